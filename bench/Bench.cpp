@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Bench.h"
+
+/**
+ * Parses the CLI arguments.
+ * @param argc
+ * @param argv
+ * @return BenchArgs The arguments packed in a BenchArgs struct
+ */
+BenchArgs parseArguments(int argc, char** argv) {
+    BenchArgs args;
+
+    CLI::App app{"NuCachis benchmark. Measures the throughput of the simulator"};
+    argv = app.ensure_utf8(argv);
+
+    app.add_option("configs", args.configFiles, "Configurations to benchmark (Default: every .ini in traces/ and bench/configs/)")
+       ->check(CLI::ExistingFile);
+    app.add_option("-o,--out", args.outputFile, "Path to write the JSON report to (Default: stdout)");
+    app.add_option("-n,--ops", args.operations, "Number of operations of each generated trace")
+       ->check(CLI::PositiveNumber);
+    app.add_option("-r,--repeat", args.repetitions, "Number of runs per measurement, the fastest one is reported")
+       ->check(CLI::PositiveNumber);
+    app.add_option("-s,--seed", args.seed, "Seed of the trace generator");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError &e) {
+        std::exit(app.exit(e));
+    }
+
+    return args;
+}
+
+/**
+ * Returns the time of a monotonic clock.
+ * @return double The time in seconds.
+ */
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Lists the configuration files of the default directories, sorted by name.
+ * @return std::vector<std::string> The paths of the files.
+ */
+std::vector<std::string> findConfigs() {
+    std::vector<std::string> files;
+    const char* dirs[] = BENCH_CONFIG_DIRS;
+
+    for (const char* dirPath : dirs) {
+        std::vector<std::string> found;
+        DIR* dir = opendir(dirPath);
+        if (dir == NULL) continue;
+
+        for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+            size_t length = strlen(entry->d_name);
+            if (length > 4 && strcmp(entry->d_name + length - 4, ".ini") == 0) {
+                found.push_back(std::string(dirPath) + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+
+    return files;
+}
+
+/**
+ * Generates a synthetic trace that stays inside the simulated memory page. A quarter of the operations are instruction
+ * fetches that run sequentially through the first eighth of the page with occasional jumps. The rest are data accesses
+ * (30% stores): half of them stream through the data region, 30% hit a small hot region and 20% are spread randomly.
+ * @param sc The configuration the trace is for.
+ * @param numOps The number of operations.
+ * @param seed The seed of the generator.
+ * @return MemoryOperation** The trace, with the same layout that parseTrace returns.
+ */
+MemoryOperation** generateTrace(SimulatorConfig* sc, uint64_t numOps, uint32_t seed) {
+    MemoryOperation** ops = (MemoryOperation**) malloc(sizeof(MemoryOperation*) * numOps);
+    uint64_t wordBytes = sc->cpuWordWidth / 8;
+    uint64_t pageWords = sc->memPageSize / wordBytes;
+    uint64_t codeWords = std::max<uint64_t>(pageWords / 8, 1);
+    uint64_t dataWords = pageWords - codeWords;
+    uint64_t hotWords = std::max<uint64_t>(dataWords / 16, 1);
+    uint64_t pc = 0, stream = 0;
+    uint64_t state = ((uint64_t) seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+
+    for (uint64_t i = 0; i < numOps; i++) {
+        uint64_t word;
+
+        // Xorshift, independent from the generator of the simulation
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        ops[i] = (MemoryOperation*) malloc(sizeof(MemoryOperation));
+        ops[i]->numWords = 1;
+        ops[i]->hasBreakPoint = false;
+        ops[i]->data = nullptr;
+
+        if (state % 4 == 0) {
+            // Instruction fetch
+            pc = ((state >> 8) % 16 == 0) ? (state >> 16) % codeWords : (pc + 1) % codeWords;
+            word = pc;
+            ops[i]->operation = LOAD;
+            ops[i]->isData = false;
+        } else {
+            // Data access
+            uint64_t kind = (state >> 8) % 10;
+            if (kind < 5) {
+                stream = (stream + 1) % dataWords;
+                word = codeWords + stream;
+            } else if (kind < 8) {
+                word = codeWords + (state >> 16) % hotWords;
+            } else {
+                word = codeWords + (state >> 16) % dataWords;
+            }
+
+            ops[i]->isData = true;
+            ops[i]->operation = ((state >> 40) % 10 < 3) ? STORE : LOAD;
+            if (ops[i]->operation == STORE) {
+                ops[i]->data = (uint64_t*) malloc(sizeof(uint64_t));
+                ops[i]->data[0] = i;
+            }
+        }
+
+        ops[i]->address = sc->memPageBaseAddress + word * wordBytes;
+    }
+
+    return ops;
+}
+
+/**
+ * Runs the benchmark of a configuration. Every measurement is repeated and the fastest run is kept.
+ * Besides the full hierarchy, the hierarchy is also run with only its first N caches, so that the cost of each level
+ * can be estimated as the time it adds divided by the accesses it receives.
+ * @param path The configuration file.
+ * @param args The benchmark arguments.
+ * @param result The measurements.
+ */
+void runConfig(const char* path, BenchArgs* args, BenchResult* result) {
+    SimulatorConfig sc;
+
+    memset(result, 0, sizeof(BenchResult));
+
+    double start = now();
+    if (parseConfiguration((char*) path, &sc) == -2) {
+        result->status = -1;
+        return;
+    }
+    double parseSeconds = now() - start;
+
+    if (sc.miscCacheLevels > BENCH_MAX_CACHES) {
+        fprintf(stderr, "Bench Error: %s has %u caches, at most %d can be benchmarked\n", path, sc.miscCacheLevels,
+                BENCH_MAX_CACHES);
+        result->status = -1;
+        return;
+    }
+
+    result->levels = sc.miscCacheLevels;
+    sc.miscNumOperations = args->operations;
+
+    for (int levels = result->levels; levels >= 0; levels--) {
+        sc.miscCacheLevels = levels;
+        result->levelSeconds[levels] = -1.0;
+
+        for (uint32_t i = 0; i < args->repetitions; i++) {
+            MemoryOperation** ops = generateTrace(&sc, args->operations, args->seed);
+
+            start = now();
+            Simulator* sim = new Simulator(&sc, ops);
+            if (levels == (int) result->levels && i == 0) {
+                result->startupSeconds = parseSeconds + now() - start;
+            }
+            sim->setQuiet(true);
+
+            start = now();
+            sim->stepAll(false);
+            double seconds = now() - start;
+
+            if (result->levelSeconds[levels] < 0.0 || seconds < result->levelSeconds[levels]) {
+                result->levelSeconds[levels] = seconds;
+            }
+            if (levels == (int) result->levels) {
+                for (int j = 0; j < levels; j++) {
+                    result->levelAccesses[j] = sim->getCache(j)->getAccesses();
+                }
+            }
+
+            // The simulator frees the data of the operations
+            delete sim;
+            for (uint64_t j = 0; j < args->operations; j++) {
+                free(ops[j]);
+            }
+            free(ops);
+        }
+    }
+}
+
+/**
+ * Runs the benchmark of a configuration in a child process, so that its peak memory usage can be measured on its own.
+ * @param path The configuration file.
+ * @param args The benchmark arguments.
+ * @param result The measurements.
+ * @param peakRss Returns the peak resident set size of the child in KiB.
+ * @return int 0 if Ok, -1 if the benchmark failed.
+ */
+int runIsolated(const char* path, BenchArgs* args, BenchResult* result, long* peakRss) {
+    int fds[2];
+    int status;
+    struct rusage usage;
+
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        runConfig(path, args, result);
+        ssize_t written = write(fds[1], result, sizeof(BenchResult));
+        _exit(written == sizeof(BenchResult) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t received = read(fds[0], result, sizeof(BenchResult));
+    close(fds[0]);
+
+    if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+        received != sizeof(BenchResult) || result->status != 0) {
+        return -1;
+    }
+
+    *peakRss = usage.ru_maxrss;
+    return 0;
+}
+
+/**
+ * Gets the name of a configuration, which is its file name without the extension.
+ * @param path The configuration file.
+ * @return std::string The name.
+ */
+std::string configName(const std::string& path) {
+    size_t start = path.find_last_of('/');
+    std::string name = path.substr(start == std::string::npos ? 0 : start + 1);
+    return name.substr(0, name.find_last_of('.'));
+}
+
+int main(int argc, char** argv) {
+    BenchArgs args = parseArguments(argc, argv);
+    FILE* out = stdout;
+    int errors = 0;
+    bool first = true;
+
+    if (args.configFiles.empty()) {
+        args.configFiles = findConfigs();
+    }
+
+    if (!args.outputFile.empty()) {
+        out = fopen(args.outputFile.c_str(), "w");
+        if (out == NULL) {
+            fprintf(stderr, "Bench Error: Cannot open %s for writing\n", args.outputFile.c_str());
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"version\": %d,\n  \"operations\": %lu,\n  \"repetitions\": %u,\n  \"seed\": %u,\n  \"benchmarks\": [",
+            BENCH_JSON_VERSION, args.operations, args.repetitions, args.seed);
+
+    for (std::string& path : args.configFiles) {
+        BenchResult result;
+        long peakRss;
+
+        fprintf(stderr, "Bench: %s\n", path.c_str());
+        if (runIsolated(path.c_str(), &args, &result, &peakRss) != 0) {
+            fprintf(stderr, "Bench Error: %s could not be benchmarked\n", path.c_str());
+            errors++;
+            continue;
+        }
+
+        double seconds = result.levelSeconds[result.levels];
+        fprintf(out, "%s\n    {\n", first ? "" : ",");
+        fprintf(out, "      \"name\": \"%s\",\n", configName(path).c_str());
+        fprintf(out, "      \"config\": \"%s\",\n", path.c_str());
+        fprintf(out, "      \"levels\": %u,\n", result.levels);
+        fprintf(out, "      \"startup_ms\": %.3f,\n", result.startupSeconds * 1e3);
+        fprintf(out, "      \"seconds\": %.6f,\n", seconds);
+        fprintf(out, "      \"accesses_per_second\": %.0f,\n", args.operations / seconds);
+        fprintf(out, "      \"ns_per_access\": %.2f,\n", seconds / args.operations * 1e9);
+        fprintf(out, "      \"peak_rss_kb\": %ld,\n", peakRss);
+        fprintf(out, "      \"memory_only_ns_per_access\": %.2f,\n", result.levelSeconds[0] / args.operations * 1e9);
+        fprintf(out, "      \"cache_levels\": [");
+
+        for (uint32_t i = 0; i < result.levels; i++) {
+            // Time the level adds to the hierarchy above it, including the change in memory traffic, per access it receives.
+            // A level that filters enough memory traffic makes the simulation faster, so it is clamped to 0
+            double added = std::max(result.levelSeconds[i + 1] - result.levelSeconds[i], 0.0);
+            double perAccess = (result.levelAccesses[i] > 0) ? added / result.levelAccesses[i] * 1e9 : 0.0;
+            fprintf(out, "%s\n        {\"level\": %u, \"accesses\": %lu, \"added_ns_per_access\": %.2f}", (i > 0) ? "," : "",
+                    i + 1, result.levelAccesses[i], perAccess);
+        }
+
+        fprintf(out, "\n      ]\n    }");
+        first = false;
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return (errors == 0) ? 0 : 1;
+}
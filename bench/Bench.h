@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CLI11.hpp"
+#include "Misc.h"
+#include "ParserConfig.h"
+#include "Simulator.h"
+
+// Benchmark defaults
+#define BENCH_DEFAULT_OPERATIONS 1000000    // Operations of each generated trace
+#define BENCH_DEFAULT_REPETITIONS 3         // Runs per measurement, the fastest one is reported
+#define BENCH_DEFAULT_SEED 1                // Seed of the trace generator
+#define BENCH_JSON_VERSION 1                // Increment whenever the layout of the report changes
+#define BENCH_MAX_CACHES 16                 // Caches of the largest hierarchy that can be benchmarked
+
+// Directories searched for configurations when none are given, relative to the source tree
+#ifndef BENCH_SOURCE_DIR
+#define BENCH_SOURCE_DIR "."
+#endif
+#define BENCH_CONFIG_DIRS {BENCH_SOURCE_DIR "/traces", BENCH_SOURCE_DIR "/bench/configs"}
+
+typedef struct {
+    std::vector<std::string> configFiles;
+    std::string outputFile;
+    uint64_t operations = BENCH_DEFAULT_OPERATIONS;
+    uint32_t repetitions = BENCH_DEFAULT_REPETITIONS;
+    uint32_t seed = BENCH_DEFAULT_SEED;
+} BenchArgs;
+
+// Measurements of a configuration, sent from the process that runs it to the one that reports it
+typedef struct {
+    int status;                                     // 0 if Ok, -1 if the configuration could not be parsed
+    uint32_t levels;                                // Number of caches
+    double startupSeconds;                          // Parsing the configuration and building the hierarchy
+    double levelSeconds[BENCH_MAX_CACHES + 1];      // Fastest run with only the first N caches, index 0 is the memory alone
+    uint64_t levelAccesses[BENCH_MAX_CACHES];       // Accesses received by each cache in the full hierarchy
+} BenchResult;
@@ -0,0 +1,411 @@
+#include <time.h>
+
+#include "MicroBench.h"
+
+// Kernel names, as used in the report
+const char* strKernel[] = {"search", "replace", "extract", "fetch", "request"};
+
+// Keeps the results of the kernels alive so that the compiler cannot remove them
+volatile int64_t sink;
+
+/**
+ * Parses the CLI arguments.
+ * @param argc
+ * @param argv
+ * @return MicroArgs The arguments packed in a MicroArgs struct
+ */
+MicroArgs parseArguments(int argc, char** argv) {
+    MicroArgs args;
+
+    CLI::App app{"NuCachis micro-benchmarks. Measures the inner kernels of a cache in isolation"};
+    argv = app.ensure_utf8(argv);
+
+    app.add_option("-o,--out", args.outputFile, "Path to write the JSON report to (Default: stdout)");
+    app.add_option("-w,--ways", args.ways, "Associativities to measure")
+       ->check(CLI::Range(1, 255));
+    app.add_option("-l,--line-sizes", args.lineSizes, "Line sizes to measure, in Bytes");
+    app.add_option("--hit-ratios", args.hitRatios, "Fractions of the lookups that hit")
+       ->check(CLI::Range(0.0, 1.0));
+    app.add_option("--sets", args.sets, "Number of sets of the measured caches");
+    app.add_option("-n,--ops", args.operations, "Number of operations of each measurement")
+       ->check(CLI::PositiveNumber);
+    app.add_option("-r,--repeat", args.repetitions, "Number of runs per measurement, the fastest one is reported")
+       ->check(CLI::PositiveNumber);
+    app.add_option("-s,--seed", args.seed, "Seed of the generated addresses and of the random replacement");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError &e) {
+        std::exit(app.exit(e));
+    }
+
+    return args;
+}
+
+/**
+ * Checks that the arguments describe valid caches.
+ * @param args The arguments.
+ * @return int 0 if Ok, -1 if they are invalid.
+ */
+int checkArguments(MicroArgs* args) {
+    int errors = 0;
+
+    if (!isPowerOf2(args->sets)) {
+        fprintf(stderr, "MicroBench Error: The number of sets must be a power of 2\n");
+        errors++;
+    }
+
+    for (uint32_t lineSize : args->lineSizes) {
+        if (!isPowerOf2(lineSize) || lineSize < MICRO_WORD_WIDTH / 8) {
+            fprintf(stderr, "MicroBench Error: Line size %u is not a power of 2 that holds at least a word\n", lineSize);
+            errors++;
+        }
+    }
+
+    return (errors == 0) ? 0 : -1;
+}
+
+/**
+ * Returns the time of a monotonic clock.
+ * @return double The time in seconds.
+ */
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Reads the cycle counter of the processor.
+ * @return uint64_t The cycles, 0 if there is no counter.
+ */
+uint64_t readCycles() {
+#if MICRO_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Gets the next number of a xorshift generator, independent from the generator of the simulation.
+ * @param state The state of the generator.
+ * @return uint64_t The number.
+ */
+uint64_t nextRandom(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Builds a unified write-back cache on top of a NullMemory and fills all of its lines, so that every set is full.
+ * Afterwards, set s holds the tags 0 to ways - 1 and any line of a higher tag misses.
+ * @param args The benchmark arguments.
+ * @param ways The associativity.
+ * @param lineSize The line size in Bytes.
+ * @param policy The replacement policy.
+ * @param memory The level below the cache.
+ * @return Cache* The cache.
+ */
+Cache* buildCache(MicroArgs* args, uint32_t ways, uint32_t lineSize, PolicyReplacement policy, NullMemory* memory) {
+    SimulatorConfig sc = {};
+    MemoryOperation op;
+    MemoryReply rep;
+    uint64_t data;
+
+    sc.cpuWordWidth = MICRO_WORD_WIDTH;
+    sc.cacheSize.push_back((int64_t) args->sets * ways * lineSize);
+    sc.cacheLineSize.push_back(lineSize);
+    sc.cacheAccessTime.push_back(1.0);
+    sc.cacheAssoc.push_back(ways);
+    sc.cacheIsSplit.push_back(false);
+    sc.cachePolicyWrite.push_back(WRITE_BACK);
+    sc.cachePolicyReplacement.push_back(policy);
+    sc.miscCacheLevels = 1;
+    sc.miscNumCores = 1;
+    sc.miscIsChain = true;
+
+    cycle = 0;
+    seedRand(args->seed);
+
+    Cache* cache = new Cache(&sc, 0);
+    cache->setNext(memory);
+    cache->setQuiet(true);
+
+    op.operation = LOAD;
+    op.numWords = 1;
+    op.isData = true;
+    op.hasBreakPoint = false;
+    rep.data = &data;
+
+    for (uint64_t i = 0; i < cache->getLines(); i++) {
+        op.address = i * lineSize;
+        rep.totalTime = 0.0;
+        cache->processRequest(&op, &rep);
+        cycle++;
+    }
+
+    return cache;
+}
+
+/**
+ * Runs a kernel several times and keeps the fastest run.
+ * @param args The benchmark arguments.
+ * @param body Runs the kernel args->operations times.
+ * @param result Returns the time and cycles per operation.
+ */
+template <typename Body> void measure(MicroArgs* args, Body body, MicroResult* result) {
+    result->nsPerOp = -1.0;
+    result->cyclesPerOp = -1.0;
+
+    for (uint32_t i = 0; i < args->repetitions; i++) {
+        double start = now();
+        uint64_t startCycles = readCycles();
+
+        body();
+
+        uint64_t cycles = readCycles() - startCycles;
+        double nsPerOp = (now() - start) / args->operations * 1e9;
+
+        if (result->nsPerOp < 0.0 || nsPerOp < result->nsPerOp) {
+            result->nsPerOp = nsPerOp;
+            result->cyclesPerOp = MICRO_HAS_TSC ? cycles / (double) args->operations : -1.0;
+        }
+    }
+}
+
+/**
+ * Measures searchAddress with a given fraction of hits. The lookups do not modify the cache.
+ */
+void runSearch(MicroArgs* args, Cache* cache, uint32_t lineSize, double hitRatio, MicroResult* result) {
+    uint64_t state = ((uint64_t) args->seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+    uint64_t lines = cache->getLines();
+    std::vector<uint64_t> addresses(args->operations);
+
+    for (uint64_t i = 0; i < args->operations; i++) {
+        bool hit = (nextRandom(&state) >> 11) * (1.0 / 9007199254740992.0) < hitRatio;
+        uint64_t line = nextRandom(&state) % lines;
+        addresses[i] = (hit ? line : line + lines) * lineSize + nextRandom(&state) % lineSize;
+    }
+
+    measure(args, [&]() {
+        int64_t found = 0;
+        for (uint64_t i = 0; i < args->operations; i++) {
+            found += CacheProbe::search(cache, addresses[i]);
+        }
+        sink = found;
+    }, result);
+}
+
+/**
+ * Measures findReplacement in random sets, all of them full.
+ */
+void runReplace(MicroArgs* args, Cache* cache, uint32_t lineSize, MicroResult* result) {
+    uint64_t state = ((uint64_t) args->seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+    std::vector<uint64_t> addresses(args->operations);
+
+    for (uint64_t i = 0; i < args->operations; i++) {
+        addresses[i] = (nextRandom(&state) % cache->getLines()) * lineSize;
+    }
+
+    measure(args, [&]() {
+        int64_t picked = 0;
+        for (uint64_t i = 0; i < args->operations; i++) {
+            picked += CacheProbe::replace(cache, addresses[i]);
+        }
+        sink = picked;
+    }, result);
+}
+
+/**
+ * Measures extractWordsFromLine of single words of random lines.
+ */
+void runExtract(MicroArgs* args, Cache* cache, uint32_t lineSize, MicroResult* result) {
+    uint64_t state = ((uint64_t) args->seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+    std::vector<int32_t> lines(args->operations);
+    std::vector<uint64_t> addresses(args->operations);
+    MemoryOperation op;
+    MemoryReply rep;
+    uint64_t data;
+
+    for (uint64_t i = 0; i < args->operations; i++) {
+        lines[i] = nextRandom(&state) % cache->getLines();
+        addresses[i] = CacheProbe::addressOf(cache, lines[i]) + nextRandom(&state) % lineSize;
+    }
+
+    op.operation = LOAD;
+    op.numWords = 1;
+    rep.data = &data;
+
+    measure(args, [&]() {
+        int64_t words = 0;
+        for (uint64_t i = 0; i < args->operations; i++) {
+            op.address = addresses[i];
+            CacheProbe::extract(cache, lines[i], &op, &rep);
+            words += data;
+        }
+        sink = words;
+    }, result);
+}
+
+/**
+ * Measures fetchFromLowerLevel of lines that have never been in the cache, each of them evicting a clean line.
+ */
+void runFetch(MicroArgs* args, Cache* cache, uint32_t lineSize, MicroResult* result) {
+    uint64_t fresh = cache->getLines();
+
+    measure(args, [&]() {
+        double time = 0.0;
+        for (uint64_t i = 0; i < args->operations; i++) {
+            time += CacheProbe::fetch(cache, (fresh++) * lineSize);
+            cycle++;
+        }
+        sink = time;
+    }, result);
+}
+
+/**
+ * Measures processRequest of loads with a given fraction of hits. Hits go to the current content of random lines,
+ * misses to lines that have never been in the cache.
+ */
+void runRequest(MicroArgs* args, Cache* cache, uint32_t lineSize, double hitRatio, MicroResult* result) {
+    uint64_t state = ((uint64_t) args->seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+    uint64_t fresh = cache->getLines();
+    std::vector<int32_t> lines(args->operations);
+    std::vector<uint32_t> offsets(args->operations);
+    MemoryOperation op;
+    MemoryReply rep;
+    uint64_t data;
+
+    for (uint64_t i = 0; i < args->operations; i++) {
+        bool hit = (nextRandom(&state) >> 11) * (1.0 / 9007199254740992.0) < hitRatio;
+        lines[i] = hit ? nextRandom(&state) % cache->getLines() : -1;
+        offsets[i] = (nextRandom(&state) % lineSize) & ~(MICRO_WORD_WIDTH / 8 - 1);
+    }
+
+    op.operation = LOAD;
+    op.numWords = 1;
+    op.isData = true;
+    op.hasBreakPoint = false;
+    rep.data = &data;
+
+    measure(args, [&]() {
+        for (uint64_t i = 0; i < args->operations; i++) {
+            uint64_t base = (lines[i] >= 0) ? CacheProbe::addressOf(cache, lines[i]) : (fresh++) * lineSize;
+            op.address = base + offsets[i];
+            rep.totalTime = 0.0;
+            cache->processRequest(&op, &rep);
+            cycle++;
+        }
+        sink = data;
+    }, result);
+}
+
+/**
+ * Measures every kernel with a given associativity and line size. Every kernel gets a freshly filled cache.
+ * @param args The benchmark arguments.
+ * @param ways The associativity.
+ * @param lineSize The line size in Bytes.
+ * @param results The list the measurements are appended to.
+ */
+void runGeometry(MicroArgs* args, uint32_t ways, uint32_t lineSize, std::vector<MicroResult>& results) {
+    NullMemory memory;
+    MicroResult result;
+    Cache* cache;
+
+    result.ways = ways;
+    result.lineSize = lineSize;
+    result.policy = LRU;
+
+    for (double hitRatio : args->hitRatios) {
+        cache = buildCache(args, ways, lineSize, LRU, &memory);
+        result.kernel = KERNEL_SEARCH;
+        result.hitRatio = hitRatio;
+        runSearch(args, cache, lineSize, hitRatio, &result);
+        results.push_back(result);
+        delete cache;
+    }
+
+    for (int policy = 0; policy < NUM_POLICY_REPLACEMENT; policy++) {
+        cache = buildCache(args, ways, lineSize, (PolicyReplacement) policy, &memory);
+        result.kernel = KERNEL_REPLACE;
+        result.policy = (PolicyReplacement) policy;
+        result.hitRatio = -1.0;
+        runReplace(args, cache, lineSize, &result);
+        results.push_back(result);
+        delete cache;
+    }
+    result.policy = LRU;
+
+    cache = buildCache(args, ways, lineSize, LRU, &memory);
+    result.kernel = KERNEL_EXTRACT;
+    runExtract(args, cache, lineSize, &result);
+    results.push_back(result);
+    delete cache;
+
+    cache = buildCache(args, ways, lineSize, LRU, &memory);
+    result.kernel = KERNEL_FETCH;
+    runFetch(args, cache, lineSize, &result);
+    results.push_back(result);
+    delete cache;
+
+    for (double hitRatio : args->hitRatios) {
+        cache = buildCache(args, ways, lineSize, LRU, &memory);
+        result.kernel = KERNEL_REQUEST;
+        result.hitRatio = hitRatio;
+        runRequest(args, cache, lineSize, hitRatio, &result);
+        results.push_back(result);
+        delete cache;
+    }
+}
+
+int main(int argc, char** argv) {
+    MicroArgs args = parseArguments(argc, argv);
+    std::vector<MicroResult> results;
+    FILE* out = stdout;
+
+    if (checkArguments(&args) != 0) {
+        return 1;
+    }
+
+    for (uint32_t lineSize : args.lineSizes) {
+        for (uint32_t ways : args.ways) {
+            fprintf(stderr, "MicroBench: %u ways, %u Byte lines\n", ways, lineSize);
+            runGeometry(&args, ways, lineSize, results);
+        }
+    }
+
+    if (!args.outputFile.empty()) {
+        out = fopen(args.outputFile.c_str(), "w");
+        if (out == NULL) {
+            fprintf(stderr, "MicroBench Error: Cannot open %s for writing\n", args.outputFile.c_str());
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"version\": %d,\n  \"operations\": %lu,\n  \"repetitions\": %u,\n  \"sets\": %u,\n  \"seed\": %u,\n",
+            MICRO_JSON_VERSION, args.operations, args.repetitions, args.sets, args.seed);
+    fprintf(out, "  \"cycle_counter\": \"%s\",\n  \"kernels\": [", MICRO_HAS_TSC ? "tsc" : "none");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        MicroResult* r = &results[i];
+        fprintf(out, "%s\n    {\"kernel\": \"%s\", \"policy\": \"%s\", \"ways\": %u, \"line_size\": %u, ", (i > 0) ? "," : "",
+                strKernel[r->kernel], replacementPolicyStr(r->policy), r->ways, r->lineSize);
+
+        // Fields that do not apply are null, so that every entry has the same members
+        if (r->hitRatio >= 0.0) fprintf(out, "\"hit_ratio\": %.2f, ", r->hitRatio);
+        else fprintf(out, "\"hit_ratio\": null, ");
+        if (r->cyclesPerOp >= 0.0) fprintf(out, "\"cycles_per_op\": %.2f, ", r->cyclesPerOp);
+        else fprintf(out, "\"cycles_per_op\": null, ");
+        fprintf(out, "\"ns_per_op\": %.2f}", r->nsPerOp);
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CLI11.hpp"
+#include "Misc.h"
+#include "Cache.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MICRO_HAS_TSC 1                     // Cycles are read from the time stamp counter
+#else
+#define MICRO_HAS_TSC 0                     // Only the time per operation is reported
+#endif
+
+// Micro-benchmark defaults
+#define MICRO_DEFAULT_OPERATIONS 200000     // Operations of each measurement
+#define MICRO_DEFAULT_REPETITIONS 3         // Runs per measurement, the fastest one is reported
+#define MICRO_DEFAULT_SETS 256
+#define MICRO_DEFAULT_SEED 1
+#define MICRO_DEFAULT_WAYS {1, 2, 4, 8, 16}
+#define MICRO_DEFAULT_LINE_SIZES {16, 64}
+#define MICRO_DEFAULT_HIT_RATIOS {0.0, 0.5, 0.9, 1.0}
+#define MICRO_WORD_WIDTH 32                 // In bits
+#define MICRO_JSON_VERSION 1                // Increment whenever the layout of the report changes
+
+typedef struct {
+    std::string outputFile;
+    std::vector<uint32_t> ways = MICRO_DEFAULT_WAYS;
+    std::vector<uint32_t> lineSizes = MICRO_DEFAULT_LINE_SIZES;
+    std::vector<double> hitRatios = MICRO_DEFAULT_HIT_RATIOS;
+    uint32_t sets = MICRO_DEFAULT_SETS;
+    uint64_t operations = MICRO_DEFAULT_OPERATIONS;
+    uint32_t repetitions = MICRO_DEFAULT_REPETITIONS;
+    uint32_t seed = MICRO_DEFAULT_SEED;
+} MicroArgs;
+
+// Kernels of the cache that get measured
+typedef enum {
+    KERNEL_SEARCH,      // searchAddress
+    KERNEL_REPLACE,     // findReplacement in a full set
+    KERNEL_EXTRACT,     // extractWordsFromLine of a single word
+    KERNEL_FETCH,       // fetchFromLowerLevel of a line that is not present, evicting another one
+    KERNEL_REQUEST,     // processRequest of a load, the whole lookup path
+    NUM_KERNELS
+} Kernel;
+
+// A measurement of a kernel
+typedef struct {
+    Kernel kernel;
+    PolicyReplacement policy;
+    uint32_t ways, lineSize;
+    double hitRatio;                // Negative if the kernel does not depend on it
+    double cyclesPerOp;             // Negative if there is no cycle counter
+    double nsPerOp;
+} MicroResult;
+
+// Last level below the measured cache. Answers instantly so that only the cache gets measured
+class NullMemory : public MemoryElement {
+public:
+    virtual void processRequest(MemoryOperation* op, MemoryReply* rep) override {
+        if (op->operation == LOAD) {
+            for (uint64_t i = 0; i < op->numWords; i++) {
+                rep->data[i] = 0;
+            }
+        }
+    }
+    virtual void registerStats(StatsRegistry*) override {}
+};
+
+// Gives the micro-benchmarks access to the private kernels of a cache. Only unified caches are driven
+class CacheProbe {
+public:
+    static CacheLine* getLines(Cache* cache) {
+        return cache->caches[Cache::DATA_CACHE];
+    }
+
+    static int32_t search(Cache* cache, uint64_t address) {
+        return cache->searchAddress(getLines(cache), address);
+    }
+
+    static uint32_t replace(Cache* cache, uint64_t address) {
+        return cache->findReplacement(getLines(cache), address);
+    }
+
+    static void extract(Cache* cache, int32_t line, MemoryOperation* op, MemoryReply* rep) {
+        cache->extractWordsFromLine(getLines(cache)[line], op, rep);
+    }
+
+    static double fetch(Cache* cache, uint64_t address) {
+        uint8_t hitLevel;
+        return cache->fetchFromLowerLevel(getLines(cache), address, true, &hitLevel);
+    }
+
+    static uint64_t addressOf(Cache* cache, int32_t line) {
+        CacheLine* cacheLine = &getLines(cache)[line];
+        return cache->getAddressFromTagAndSet(cacheLine->tag, cacheLine->set);
+    }
+};
@@ -4,23 +4,53 @@
 #include <stdbool.h>
 #include <cstdlib>
 #include <math.h>
+#include <stdarg.h>
+#include <vector>
+#include <string>
 
 #include "Misc.h"
 #include "MemoryElement.h"
+#include "MissClassifier.h"
 #include "PolicyReplacement.h"
 #include "PolicyWrite.h"
 
+// Line timestamps are stored relative to a per set base cycle, so that they stay 32 bits long in traces of any length
+#define CACHE_MAX_STAMP INT32_MAX                   // Largest relative timestamp. The set is rebased when the current cycle goes beyond it
+#define CACHE_REBASE_STAMP (CACHE_MAX_STAMP / 2)    // Relative timestamp of the current cycle after rebasing a set
+
 // A cache line
 typedef struct {
     uint64_t* content;              // Pointer to an array of words
     uint64_t tag;
     uint32_t set, way;
-    int32_t firstAccess, lastAccess, numberAccesses;
+    int32_t firstAccess, lastAccess;    // Cycles relative to the base of the set, -1 if never accessed
+    int32_t numberAccesses;             // Saturates at CACHE_MAX_STAMP
+    uint32_t version;                   // Changes whenever the line does, so that its text is only formatted again then
     bool valid, dirty;
     ColorNames lineColor;
 } CacheLine;
 
+// The state of a cache line as it gets stored in a checkpoint. The content is stored separately.
+typedef struct {
+    uint64_t tag;
+    int32_t firstAccess, lastAccess, numberAccesses;
+    uint8_t valid, dirty;
+    uint16_t padding;
+} CheckpointLine;
+
+// Counters kept for every set, for the heatmap of the GUI
+typedef enum {
+    SET_HITS,
+    SET_MISSES,
+    SET_EVICTIONS,                  // Valid lines replaced
+    SET_DIRTY_LINES,                // Lines of the set that are dirty now
+    NUM_SET_COUNTERS
+} SetCounter;
+
 class Cache : public MemoryElement {
+// The micro-benchmarks drive the private kernels directly
+friend class CacheProbe;
+
 // Caches
 typedef enum {
     DATA_CACHE,
@@ -31,18 +61,30 @@ typedef enum {
 private:
     // The actual cache structures
     CacheLine* caches[NUM_CACHE_TYPES];
+    uint64_t* contents[NUM_CACHE_TYPES];    // Contiguous storage for the content of all lines of each cache
+    uint64_t* setBases[NUM_CACHE_TYPES];    // Cycle the timestamps of each set are relative to
+    uint64_t* setCounters[NUM_CACHE_TYPES]; // NUM_SET_COUNTERS per set
 
     // Properties of the cache
     uint64_t size, lineSize, lineSizeWords; 
     double accessTime;
     uint32_t sets, ways, lines, wordWidth;
+    uint32_t offsetBits, setBits;           // Bits of the offset and the set in an address
     bool isSplit;
-    uint8_t id;
+    uint32_t id;                            // Index of the cache in the configuration
+    uint32_t level;                         // 1 for the caches that receive the accesses of a core
+    std::string name, label;                // Prefix of the statistics (E.g. l1) and name shown to the user (E.g. L1)
+    bool showSide;                          // Follow the label with I or D in the console output
     PolicyWrite policyWrite;
     PolicyReplacement policyReplacement;
 
     // Stats
-    uint32_t accesses, hits, misses;
+    uint64_t accesses, hits, misses, writebacks;
+    uint64_t missesByType[NUM_CACHE_TYPES][NUM_MISS_TYPES];    // Three-C classification, indexed by the side of the operation
+
+    // Shadow structures used to classify the misses of each cache
+    MissClassifier* classifiers[NUM_CACHE_TYPES];
+    std::vector<uint64_t> batchHits[NUM_CACHE_TYPES];   // Lines hit by processBatch, referenced in the classifiers after its loop
 
     // Private functions
     uint64_t getMask(uint64_t numBits);
@@ -53,23 +95,47 @@ private:
     uint32_t findReplacement(CacheLine* cache, uint64_t address);
     void extractWordsFromLine(CacheLine line, MemoryOperation* op, MemoryReply* rep);
     void insertWordsInLine(CacheLine line, MemoryOperation* op);
-    double fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isData);
+    double fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isData, uint8_t* hitLevel);
     int32_t searchAddress(CacheLine* cache, uint64_t address);
+    void touchLine(CacheLine* cache, int32_t line);
+    void countInSet(CacheLine* cache, uint32_t set, SetCounter counter, int64_t amount);
+    int32_t getStamp(CacheLine* cache, uint32_t set, uint64_t now);
+    void rebaseSet(CacheLine* cache, uint32_t set, uint64_t* base, uint64_t now);
+    void log(bool isData, const char* format, ...);
+    void classifyReference(MemoryOperation* op, bool isMiss);
 
 public:
-    Cache(SimulatorConfig* sc, uint8_t id);
+    Cache(SimulatorConfig* sc, uint32_t id);
     ~Cache();
 
     bool isCacheSplit();
+    const char* getName();
+    const char* getLabel();
+    uint32_t getLevel();
     CacheLine* getCache(bool getInst = 0);
     uint32_t getLines();
+    uint32_t getSets();
     uint32_t getLineSizeWords();
-    uint32_t getAccesses();
-    uint32_t getHits();
-    uint32_t getMisses();
+    const uint64_t* getSetBases(bool getInst = 0);
+    const uint64_t* getSetCounters(bool getInst = 0);
+    uint64_t getAccesses();
+    uint64_t getHits();
+    uint64_t getMisses();
+    uint64_t getWritebacks();
+    uint64_t getMissesOfType(MissType type, bool getInst = 0);
 
     virtual void processRequest(MemoryOperation* op, MemoryReply* rep) override;
-    virtual void clearStyle() override;
+    virtual uint32_t processBatch(MemoryOperation** ops, MemoryReply* reps, uint32_t numOps) override;
+    virtual void registerStats(StatsRegistry* stats) override;
 
     void flush();
+    void resetStats();
+
+    // Checkpoints
+    void saveState(FILE* file);
+    int loadState(FILE* file);
+
+    // Undo journal
+    void saveCounters(std::vector<uint64_t>& counters);
+    const uint64_t* restoreCounters(const uint64_t* counters);
 };
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Misc.h"
+#include "OperationSource.h"
+
+// Compressed trace (.nct) format
+#define TRACE_MAGIC "NCTRACE1"              // 8 characters that open every compressed trace
+#define TRACE_VERSION 1                     // Increment whenever the layout of a compressed trace changes
+#define TRACE_BLOCK_OPERATIONS 65536        // Operations per block. Every block can be decoded on its own
+#define TRACE_READ_AHEAD 4                  // Decoded blocks kept ahead of the simulator per worker
+#define TRACE_MAX_WORKERS 16
+
+// Flags of an operation, stored as separate bit streams in each block
+#define TRACE_FLAG_STORE 0x1
+#define TRACE_FLAG_DATA 0x2
+#define TRACE_FLAG_BREAKPOINT 0x4
+
+/*
+ * Layout of a compressed trace. Integers are stored in the byte order of the machine, as in checkpoints.
+ *  Header:     TraceHeader
+ *  Blocks:     TraceBlockHeader, followed by its streams:
+ *              - Store bits, data bits and breakpoint bits, (numOps + 7) / 8 Bytes each
+ *              - Addresses, as varints of the zigzag delta from the previous address of the same side (instruction or data)
+ *              - Store data, as varints
+ *  Index:      TraceIndexEntry per block, at header.indexOffset
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockOps;              // Operations per block, the last block may have fewer
+    uint64_t numOps;
+    uint64_t numBlocks;
+    uint64_t indexOffset;
+} TraceHeader;
+
+typedef struct {
+    uint32_t numOps;
+    uint32_t flagBytes, addressBytes, dataBytes;
+} TraceBlockHeader;
+
+typedef struct {
+    uint64_t offset;                // Position of the block header in the file
+    uint64_t size;                  // Size of the block, header included
+} TraceIndexEntry;
+
+// A decoded operation
+typedef struct {
+    uint64_t address;
+    uint64_t data;
+    uint8_t flags;
+} TraceRecord;
+
+// A block decoded by a worker, waiting to be consumed
+typedef struct {
+    uint64_t block;                 // Block held, UINT64_MAX while empty
+    int status;                     // 0 if Ok, -1 if the block could not be read or decoded
+    std::vector<TraceRecord> records;
+} TraceSlot;
+
+class CompressedTraceWriter {
+private:
+    FILE* file;
+    TraceHeader header;
+    std::vector<TraceIndexEntry> index;
+
+    // Streams of the block being filled
+    std::vector<TraceRecord> pending;
+
+    void writeBlock();
+
+public:
+    CompressedTraceWriter();
+    ~CompressedTraceWriter();
+
+    int open(const char* path, uint32_t blockOps = TRACE_BLOCK_OPERATIONS);
+    void append(const MemoryOperation* op);
+    int close();
+};
+
+class CompressedTraceReader : public OperationSource {
+private:
+    int fd;
+    TraceHeader header;
+    std::vector<TraceIndexEntry> index;
+
+    // Consumer position
+    uint64_t current;               // Block being consumed
+    uint32_t position;              // Next record of the block being consumed
+    TraceSlot* slot;                // Slot of the block being consumed, nullptr until it is ready
+    bool failed;
+
+    // Workers that decode the blocks ahead of the consumer
+    std::vector<std::thread> workers;
+    std::vector<TraceSlot> slots;
+    uint32_t numWorkers;
+    uint64_t nextToDecode;
+    bool stopping;
+    std::mutex lock;
+    std::condition_variable changed;
+
+    int readBlock(uint64_t block, TraceSlot* target);
+    void work();
+    void startWorkers();
+    void stopWorkers();
+    TraceSlot* waitForBlock(uint64_t block);
+
+public:
+    CompressedTraceReader();
+    ~CompressedTraceReader();
+
+    int open(const char* path, uint32_t threads);
+    void close();
+
+    virtual bool next(MemoryOperation* op) override;
+    virtual void rewind() override;
+    virtual uint64_t getNumOps() override;
+};
+
+bool isCompressedTrace(const char* path);
+
+// Varint encoding of the streams, also used by the filter streams
+void putVarint(std::vector<uint8_t>& stream, uint64_t value);
+int getVarint(const uint8_t** cursor, const uint8_t* end, uint64_t* value);
+uint64_t zigzag(uint64_t delta);
+uint64_t unzigzag(uint64_t value);
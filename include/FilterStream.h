@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+
+#include "Misc.h"
+#include "MemoryElement.h"
+#include "OperationSource.h"
+
+// Filter streams (.ncf): the requests that reach a level of the hierarchy, recorded once to replay them into that level
+#define FILTER_MAGIC "NCFILTR1"             // 8 characters that open every filter stream
+#define FILTER_VERSION 1                    // Increment whenever the layout of a filter stream changes
+#define FILTER_BUFFER_SIZE (1 << 20)        // Bytes buffered before writing or after reading
+
+// Flags of a request
+#define FILTER_FLAG_STORE 0x1
+#define FILTER_FLAG_DATA 0x2
+
+/*
+ * Layout of a filter stream. Integers are stored in the byte order of the machine, as in checkpoints.
+ *  Header:     FilterHeader
+ *  Requests:   Flags Byte, varint of the cycles since the previous request, varint of the zigzag delta from the
+ *              previous address of the same side (instruction or data), varint of the number of words and, for stores,
+ *              a varint per word
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t level;                 // Level the requests were sent to, 1 for L1. One past the last cache for the memory
+    uint32_t wordWidth;             // In Bytes
+    uint32_t maxWords;              // Words of the longest request
+    uint64_t fingerprint;           // Configuration of the levels above, that produced the requests
+    uint64_t numRequests;
+    uint64_t numCycles;             // Operations of the trace the requests were recorded from
+    uint64_t warmupCycles;          // Operations of the trace that warmed up the hierarchy
+} FilterHeader;
+
+// Sits in front of a level of the hierarchy and records every request it gets before passing it on
+class FilterRecorder : public MemoryElement {
+private:
+    FILE* file;
+    FilterHeader header;
+    std::vector<uint8_t> buffer;
+    uint64_t previous[2];           // Last address of each side
+    uint64_t previousCycle;
+
+public:
+    FilterRecorder();
+    ~FilterRecorder();
+
+    int open(const char* path, SimulatorConfig* sc, uint32_t level);
+    int close(uint64_t numCycles, uint64_t warmupCycles);
+    uint32_t getLevel();
+
+    virtual void processRequest(MemoryOperation* op, MemoryReply* rep) override;
+    virtual void registerStats(StatsRegistry*) override {}
+};
+
+// Replays a filter stream. Requests may span several words, up to getMaxWords(), and several of them may belong to the
+// same cycle. The reader decodes one request ahead to tell the cycle of the next one
+class FilterReader : public OperationSource {
+private:
+    FILE* file;
+    FilterHeader header;
+    std::vector<uint8_t> buffer;
+    size_t cursor, end;
+    uint64_t previous[2];
+
+    // Next request
+    MemoryOperation ahead;
+    std::vector<uint64_t> aheadData;
+    uint64_t aheadCycle;            // UINT64_MAX once the stream has ended
+
+    void refill();
+    void decodeAhead();
+
+public:
+    FilterReader();
+    ~FilterReader();
+
+    int open(const char* path);
+    void close();
+    uint32_t getLevel();
+    uint32_t getMaxWords();
+    uint64_t getFingerprint();
+    uint64_t getNumCycles();
+    uint64_t getWarmupCycles();
+    uint64_t getNextCycle();
+
+    virtual bool next(MemoryOperation* op) override;
+    virtual void rewind() override;
+    virtual uint64_t getNumOps() override;
+};
+
+uint64_t filterFingerprint(SimulatorConfig* sc, uint32_t level);
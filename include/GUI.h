@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <SDL.h>
 #include <SDL_opengl.h>
 #include <GL/gl.h>
@@ -30,16 +34,50 @@
 #define CACHE_WINDOW_WIDTH  (1 - (INSTR_WINDOW_WIDTH + MEM_WINDOW_WIDTH))   // Take up all the free remaining space
 #define CACHE_WINDOW_HEIGHT 1
 #define MIN_CACHE_TABLE_WIDTH 450.0f
+#define HEATMAP_DEFAULT_LINES 4096  // Caches with more lines start in the heatmap view
 
 // Stats window
 #define STATS_WINDOW_WIDTH  INSTR_WINDOW_WIDTH
 #define STATS_WINDOW_HEIGHT (1.0 - INSTR_WINDOW_HEIGHT) 
+#define HISTORY_PLOT_HEIGHT 60.0f
+
+// Background simulation
+#define WORKER_SLICE_OPS 64         // Operations run between checks for a frame that wants to be drawn
+#define WORKER_SLICE_MS 8           // Longest time the worker keeps the simulation before letting a frame draw it
+#define WORKER_PAUSE_MS 10          // Time the worker sleeps between checks while paused
 
 // Error window
 #define ERROR_WINDOW_WIDTH  0.40
 #define ERROR_WINDOW_HEIGHT 0.20
 
 
+// Text of a line of a cache table, kept between frames
+typedef struct {
+    uint32_t version;               // Version of the line when the text was formatted
+    bool formatted;
+    std::string content;            // Content words of the line
+} LineText;
+
+// Views of the cache window
+typedef enum {
+    CACHE_VIEW_LINES,               // A table with every line
+    CACHE_VIEW_HEATMAP,             // A heatmap with a counter of every set
+} CacheView;
+
+// A table of the cache window, for the data or the instructions of a cache
+typedef struct {
+    std::vector<LineText> lines;
+    bool scrolled;                  // Already scrolled to the styled line of this cycle
+
+    // Heatmap of the sets, one texel per set
+    GLuint texture;                 // 0 until the heatmap is first shown
+    uint32_t textureWidth, textureHeight;
+    std::vector<uint8_t> pixels;    // RGBA
+    uint64_t drawnCycle;            // Cycle and counter the texture was drawn for
+    int drawnCounter;
+    uint64_t maxValue;              // Value with the brightest color
+} CacheTableView;
+
 class GUI {
 private:
     SDL_Window* window;
@@ -51,16 +89,39 @@ private:
     // Table scroll
     // Used to scroll the first time a cycle passes but not hold the scroll in a certain position
     bool scrolledInstructions;
-    bool scrolledCache[MAX_CACHE_LEVELS];
     bool scrolledMemory;
 
+    // Tables of the cache window, two per cache for the data and the instructions
+    std::vector<CacheTableView> cacheTables;
+    int cacheView;                          // CacheView, -1 until the first frame picks one
+    int heatmapCounter;                     // SetCounter shown by the heatmaps
+
+    // Points of the chart being drawn, reused between charts and frames
+    std::vector<float> plotValues;
+
+    // Conditional breakpoint being edited before adding it
+    Breakpoint newBreakpoint;
+    bool breakpointError;                   // The last one could not be added
+
+    // Background simulation. The worker holds simMutex while it runs operations and the renderer while it builds a
+    // frame, so every frame shows the state between two operations
+    std::thread worker;
+    std::mutex simMutex;
+    std::atomic<bool> workerPaused, workerCancel, workerDone;
+    std::atomic<bool> renderWaiting;        // A frame is waiting for the worker to release the simulation
+    uint64_t workerOps;                     // Operations run by the worker, guarded by simMutex
+    double workerSeconds;                   // Time spent running them, guarded by simMutex
+
     // Window sizes
     int windowHeight, windowWidth; 
 
     // Draw functions
     GLuint LoadImageFromCSource(const unsigned char* rawData, int width, int height, bool setTaskbarIcon);
     void centerNextItem(float itemWidth);
-    void drawCacheTable(CacheLine* cache, uint8_t id, uint32_t lineSizeWords, uint32_t numLines, char* label);
+    void drawCacheTable(CacheLine* cache, const uint64_t* setBases, CacheTableView* view, uint32_t lineSizeWords, uint32_t numLines, char* label);
+    void drawSetHeatmap(const uint64_t* setCounters, uint32_t numSets, CacheTableView* view, char* label);
+    void drawHistoryCharts(Simulator* sim);
+    void drawBreakpoints(Simulator* sim);
 
     // Main section renderers
     void renderInstructionWindow(Simulator* sim);
@@ -69,6 +130,11 @@ private:
     void renderMemoryWindow(Simulator* sim);
     void resetScroll();
 
+    // Background simulation
+    void runWorker(Simulator* sim);
+    void startWorker(Simulator* sim);
+    void stopWorker();
+
 public:
     GUI();
     ~GUI();
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "Misc.h"
+
+// Interval statistics
+#define INTERVAL_DEFAULT_OPERATIONS 10000   // Operations per sample if no interval is given
+#define INTERVAL_RING_SIZE 1024             // Samples kept in memory. The unwritten ones are streamed out when the ring fills up
+#define INTERVAL_BUFFER_SIZE 65536          // Bytes buffered by the output file
+
+class Simulator;
+
+// Output formats of the interval statistics
+typedef enum {
+    INTERVAL_CSV,
+    INTERVAL_JSONL
+} IntervalFormat;
+
+// Statistics of a cache level, accumulated since the start of the measurement
+typedef struct {
+    uint64_t accesses, hits, misses, writebacks;
+} IntervalLevel;
+
+// A sample of all the counters of the hierarchy
+typedef struct {
+    uint64_t operation;             // Measured operations executed when the sample was taken
+    double time;                    // Total access time when the sample was taken
+    std::vector<IntervalLevel> levels;      // One per cache
+    uint64_t memoryAccesses;        // Words read or written in the main memory
+} IntervalSample;
+
+class IntervalStats {
+private:
+    Simulator* sim;
+    uint32_t interval, untilSample;
+    uint32_t cacheLevels;
+    uint32_t wordWidth;
+
+    // Samples, the newest one is at head - 1
+    IntervalSample ring[INTERVAL_RING_SIZE];
+    uint32_t head, count, unwritten;
+    IntervalSample lastWritten;     // Used to turn the accumulated counters of the next sample into deltas
+
+    // Output
+    FILE* file;
+    char* buffer;
+    IntervalFormat format;
+
+    void takeSample(IntervalSample* sample);
+    void writeHeader();
+    void writeSample(const IntervalSample* sample);
+
+public:
+    IntervalStats();
+    ~IntervalStats();
+
+    int open(const char* path, Simulator* simulator, uint32_t numOps);
+    void step();
+    void flush();
+    void close();
+
+    uint32_t getNumSamples();
+    const IntervalSample* getSample(uint32_t age);
+};
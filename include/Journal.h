@@ -0,0 +1,93 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "Misc.h"
+#include "Cache.h"
+#include "MainMemory.h"
+#include "MissClassifier.h"
+
+// Journal limits
+#define JOURNAL_MAX_STEPS 65536             // Steps that can be undone before falling back to snapshots
+#define JOURNAL_SNAPSHOT_INTERVAL 4096      // Initial number of steps between full snapshots
+#define JOURNAL_MAX_SNAPSHOTS 64            // When exceeded, every other snapshot is dropped and the interval doubles
+
+// The state of a cache line before a step modified it
+typedef struct {
+    MemoryElement* element;         // Cache the line belongs to
+    CacheLine* line;
+    CheckpointLine state;
+    uint32_t lineSizeWords;
+    ColorNames colorAfter;          // Style of the line at the end of the step
+} JournalLine;
+
+// The state of a memory word before a step modified it
+typedef struct {
+    MemoryElement* element;         // Memory the word belongs to
+    MemoryLine* word;
+    uint32_t content;
+    ColorNames colorAfter;          // Style of the word at the end of the step
+} JournalWord;
+
+// The previous value of a 64 bit variable modified by a step
+typedef struct {
+    uint64_t* address;
+    uint64_t value;
+} JournalValue;
+
+// Number of records a step added to each of the journals
+typedef struct {
+    uint32_t lines, words, references, values;
+} JournalStep;
+
+// A full copy of the simulation state
+typedef struct {
+    uint64_t cycle;
+    char* data;
+    size_t size;
+} JournalSnapshot;
+
+class Journal {
+private:
+    // Undo records, the newest ones are at the back
+    std::deque<JournalStep> steps;
+    std::deque<JournalLine> lines;
+    std::deque<uint64_t> contents;
+    std::deque<JournalWord> words;
+    std::deque<ClassifierRecord> references;
+    std::deque<JournalValue> values;
+    std::deque<uint64_t> counters;
+    uint32_t countersPerStep;
+
+    // Full snapshots, sorted by cycle
+    std::vector<JournalSnapshot> snapshots;
+    uint64_t snapshotInterval;
+
+    void dropOldestStep();
+
+public:
+    Journal();
+    ~Journal();
+
+    // Recording
+    void beginStep(const std::vector<uint64_t>& stepCounters);
+    void recordLine(MemoryElement* element, CacheLine* line, uint32_t lineSizeWords);
+    void recordWord(MemoryElement* element, MemoryLine* word);
+    void recordReference(const ClassifierRecord* record);
+    void recordValue(uint64_t* address);
+    void endStep();
+
+    // Undoing
+    uint32_t getDepth();
+    bool undoStep(std::vector<uint64_t>& stepCounters);
+    void discardSteps(uint64_t numSteps);
+    void restyleLastStep();
+
+    // Snapshots
+    bool isSnapshotDue(uint64_t cycle);
+    void addSnapshot(uint64_t cycle, char* data, size_t size);
+    JournalSnapshot* findSnapshot(uint64_t cycle);
+
+    void clear();
+};
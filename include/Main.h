@@ -1,17 +1,73 @@
 #pragma once
 
 #include <string.h>
+#include <errno.h>
+#include <algorithm>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "CLI11.hpp"
 #include "Misc.h"
+#ifdef NUCACHIS_GUI
 #include "GUI.h"
+#endif
 #include "ParserConfig.h"
 #include "ParserTrace.h"
 #include "Simulator.h"
+#include "TraceGenerator.h"
+#include "CompressedTrace.h"
+#include "TraceImporter.h"
+#include "FilterStream.h"
 
 typedef struct {
     std::string configFile;
     std::string traceFile;
+    std::string dramsysFile;
+    std::string checkpointLoad;
+    std::string checkpointSave;
+    uint64_t checkpointAt = 0;  // 0 saves the checkpoint at the end of the trace
+    uint64_t warmup = 0;
+    double warmupFraction = 0.0;
+    uint32_t interval = 0;      // 0 disables the interval statistics
+    std::string intervalFile;
+    std::string statsJson;
+    std::string statsCsv;
+    std::string generate;       // Access pattern of the generated trace, empty to read the trace file
+    std::string genFootprint;   // Empty covers the memory page
+    std::string genOut;         // Write the generated trace instead of simulating it
+    uint64_t genOps = GENERATOR_DEFAULT_OPERATIONS;
+    uint64_t genStride = GENERATOR_DEFAULT_STRIDE;
+    double genWrites = GENERATOR_DEFAULT_WRITES;
+    double genInst = GENERATOR_DEFAULT_INST;
+    double genZipf = GENERATOR_DEFAULT_ZIPF;
+    uint32_t genBlock = GENERATOR_DEFAULT_BLOCK;
+    uint32_t genSeed = GENERATOR_DEFAULT_SEED;
+    std::string compressOut;    // Write the trace compressed instead of simulating it
+    uint32_t traceThreads = 0;  // Workers that decompress a compressed trace, 0 picks one per core but one
+    std::string filterOut;      // Record the requests that reach filterLevel
+    uint32_t filterLevel = 0;   // 0 records the requests to the last cache
+    std::string filterIn;       // Replay a filter stream instead of a trace
+    uint32_t jobs = 0;          // Configurations of a sweep simulated at once, 0 picks one per core
     int debug;
     bool noGui = false;     // Gui is on by default
-} AppArgs;
\ No newline at end of file
+    bool quiet = false;
+} AppArgs;
+
+// Every source the operations of a simulation can be pulled from, only one of them is used
+typedef struct {
+    TraceGenerator generator;
+    CompressedTraceReader reader;
+    TraceImporter importer;
+    FilterReader filter;
+} TraceSources;
+
+// A configuration of a sweep, simulated by a child process that sends back its statistics
+typedef struct {
+    pid_t pid;
+    int fd;                             // Read end of the pipe of the child, -1 once it is closed
+    std::string output;                 // Statistics sent by the child, as CSV
+    bool failed;
+    std::vector<std::string> names;     // Statistics, parsed from the output
+    std::vector<std::string> values;
+} SweepResult;
@@ -19,6 +19,9 @@ private:
     // The actual main memory
     MemoryLine* memory;
 
+    // Words outside of the page that have been written, by index from the page base. They are not displayed
+    std::unordered_map<uint64_t, MemoryLine> offPage;
+
     int32_t addressWidth, wordWidth;
     int64_t size, pageSize, pageBaseAddress;
     double accessTimeSingle, accessTimeBurst;
@@ -26,6 +29,13 @@ private:
     // Stats
     uint64_t accessesSingle, accessesBurst;
 
+    // DRAMSys trace export
+    DramsysFile* dramsysFile;       // nullptr if the export is disabled
+    double currentTime;             // Simulated time at which the current CPU operation started
+    double busyUntil;               // Simulated time at which the memory finishes its last request
+
+    MemoryLine* getLine(uint64_t index, bool create);
+
 public:
     MainMemory(SimulatorConfig* sc);
     ~MainMemory();
@@ -36,8 +46,20 @@ public:
     uint64_t getAccessesSingle();
     uint64_t getAccessesBurst();
 
+    void setDramsysFile(DramsysFile* df);
+    void setCurrentTime(double time);
+
     virtual void processRequest(MemoryOperation* op, MemoryReply* rep) override;
-    virtual void clearStyle() override;
+    virtual void registerStats(StatsRegistry* stats) override;
 
     void flush();
+    void resetStats();
+
+    // Checkpoints
+    void saveState(FILE* file);
+    int loadState(FILE* file);
+
+    // Undo journal
+    void saveCounters(std::vector<uint64_t>& counters);
+    const uint64_t* restoreCounters(const uint64_t* counters);
 };
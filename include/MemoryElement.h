@@ -1,26 +1,54 @@
 #pragma once
 
+#include <vector>
+
 #include "Misc.h"
 
+class Journal;
+class StatsRegistry;
+
 class MemoryElement {
 protected:
     // Pointers to the next and previous elements in the memory hierarchy
     MemoryElement* next;
     MemoryElement* prev;
 
+    // Undo journal in which the element records the state it modifies. nullptr if disabled
+    Journal* journal;
+
+    // In functional mode only the state of the hierarchy is simulated: no timing, styles or console output
+    bool functional;
+
+    // In quiet mode nothing is printed to the console and nothing is styled, as only the GUI shows the styles
+    bool quiet;
+
+    // Styles set since the last clearStyle, so that clearing them does not depend on the size of the element
+    std::vector<ColorNames*> styled;
+
 public:
     // Constructor
     MemoryElement();
+    virtual ~MemoryElement() {}
 
     MemoryElement* getNext();
     MemoryElement* getPrev();
 
     void setNext(MemoryElement* nextElement);
     void setPrev(MemoryElement* prevElement);
+    void setJournal(Journal* j);
+    void setFunctional(bool isFunctional);
+    void setQuiet(bool isQuiet);
 
     // Process request from another level
     virtual void processRequest(MemoryOperation* op, MemoryReply* rep) = 0;
 
-    // Clear the style of whatever structure stores the code.
-    virtual void clearStyle() = 0;
+    // Process the first requests of a batch from the CPU that can be served without the levels below
+    virtual uint32_t processBatch(MemoryOperation** ops, MemoryReply* reps, uint32_t numOps);
+
+    // Style a row of the element and clear the style of the rows styled since the last clear
+    void setStyle(ColorNames* style, ColorNames color);
+    virtual void clearStyle();
+
+    // Register the statistics of the element
+    virtual void registerStats(StatsRegistry* stats) = 0;
 };
@@ -8,6 +8,8 @@
 #include <ctype.h>
 #include <cassert>
 #include <math.h>
+#include <string>
+#include <vector>
 
 #include "PolicyReplacement.h"
 #include "PolicyWrite.h"
@@ -19,8 +21,22 @@
 #define WINDOW_HEIGHT 720
 #define MAX_PATH_LENGTH 512
 
-// Simulator config
-#define MAX_CACHE_LEVELS 5
+// DRAMSys trace export
+#define DRAMSYS_BUFFER_SIZE 65536           // Bytes buffered before writing to the trace file
+#define DRAMSYS_MAX_LINE_LENGTH 64          // Upper bound of the length of a single trace line
+#define DRAMSYS_TICKS_PER_SECOND 1e9        // Resolution of the timestamps (1 tick = 1 ns of simulated time)
+
+// Accesses of its core that a cache at the top of the hierarchy receives
+typedef enum {
+    CACHE_SIDE_BOTH,
+    CACHE_SIDE_INSTRUCTIONS,
+    CACHE_SIDE_DATA,
+    NUM_CACHE_SIDES
+} CacheSide;
+
+// Checkpoints
+#define CHECKPOINT_MAGIC "NCCHKPNT"         // 8 characters that open every checkpoint file
+#define CHECKPOINT_VERSION 7                // Increment whenever the layout of a checkpoint changes
 
 // Simulator configuration. Used to pass config to the Simulator's constructor from the config file
 typedef struct {
@@ -31,18 +47,27 @@ typedef struct {
     double memAccessTimeSingle, memAccessTimeBurst;
     int64_t memSize, memPageSize, memPageBaseAddress;
 
-    // Cache configs
-    int64_t cacheSize[MAX_CACHE_LEVELS];
-    int64_t cacheLineSize[MAX_CACHE_LEVELS];
-    double cacheAccessTime[MAX_CACHE_LEVELS];
-    uint8_t cacheAssoc[MAX_CACHE_LEVELS];
-    bool cacheIsSplit[MAX_CACHE_LEVELS];
-    PolicyWrite cachePolicyWrite[MAX_CACHE_LEVELS];
-    PolicyReplacement cachePolicyReplacement[MAX_CACHE_LEVELS];
+    // Cache configs, one entry per cache. A cache always comes before the ones below it
+    std::vector<int64_t> cacheSize;
+    std::vector<int64_t> cacheLineSize;
+    std::vector<double> cacheAccessTime;
+    std::vector<uint32_t> cacheAssoc;
+    std::vector<bool> cacheIsSplit;
+    std::vector<PolicyWrite> cachePolicyWrite;
+    std::vector<PolicyReplacement> cachePolicyReplacement;
+
+    // Topology of the caches
+    std::vector<std::string> cacheName;     // Prefix of the statistics of the cache (E.g. l1 or l1d)
+    std::vector<int32_t> cacheNext;         // Cache that gets the misses, -1 for the main memory
+    std::vector<int32_t> cacheCore;         // Core whose accesses the cache receives, -1 if it only gets misses
+    std::vector<CacheSide> cacheSide;       // Accesses of the core it receives
+    std::vector<uint32_t> cacheLevel;       // Longest distance from a core, 1 for the caches that receive its accesses
 
     // Other misc configs
-    uint32_t miscNumOperations;
-    uint8_t miscCacheLevels;
+    uint64_t miscNumOperations;
+    uint32_t miscCacheLevels;               // Number of caches. Only the first ones are built if lowered
+    uint32_t miscNumCores;
+    bool miscIsChain;                       // Each cache sends its misses to the next one, as in [cacheN] configurations
 } SimulatorConfig;
 
 // The type of operation that an instruction will represent
@@ -64,8 +89,17 @@ typedef struct {
 typedef struct {
     double totalTime;         // The total time to complete the request
     uint64_t* data;           // Pointer to the data that has been requested
+    uint8_t hitLevel;         // Level that had the data, 1 for L1. 0 for the main memory
 } MemoryReply;
 
+// Buffered writer for DRAMSys traces
+typedef struct {
+    FILE* file;
+    char* buffer;
+    size_t used;              // Bytes currently stored in the buffer
+    uint64_t requests;        // Number of requests written so far
+} DramsysFile;
+
 // GUI Colors
 typedef enum {
     COLOR_HIT,          // Hit
@@ -81,7 +115,8 @@ typedef enum {
 
 /* Global variables */
 extern int debugLevel;
-extern uint32_t cycle;        // This should be in Simulator, but due to cyclic reference issues is has to be here, sorry.
+extern uint64_t cycle;        // This should be in Simulator, but due to cyclic reference issues is has to be here, sorry.
+extern uint64_t randState;    // State of the simulation's random number generator. Kept global so that it can be checkpointed
 
 /* Misc parsing functions */
 // Policy parsing functions
@@ -110,10 +145,12 @@ void contentStringToArray(unsigned* array, char* content, int level);
 
 /* Other Functions */
 // DRAMSys functions
-int openDramsysFile(const char* filename, FILE** f);
-void writeToDramsysFile(FILE** f, int lastNumber, int readOrWrite, int address);
-void close_dramsys_file(FILE **f);
+int openDramsysFile(const char* filename, DramsysFile* df);
+void writeToDramsysFile(DramsysFile* df, uint64_t timestamp, Operation operation, uint64_t address);
+void flushDramsysFile(DramsysFile* df);
+void closeDramsysFile(DramsysFile* df);
 
 // Misc Functions
-int countLines(FILE* fp);
-int cycle_rand();
+uint64_t countLines(FILE* fp);
+void seedRand(uint32_t seed);
+uint32_t simRand();
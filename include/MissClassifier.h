@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+
+#include "Misc.h"
+
+// Seen lines are kept as a bitmap in chunks of consecutive lines, allocated once one of their lines is referenced
+#define CLASSIFIER_CHUNK_LINES 1024
+
+// Three-C classification of misses
+typedef enum {
+    MISS_COMPULSORY,    // First reference to the line
+    MISS_CAPACITY,      // Would also miss in a fully associative LRU cache of the same size
+    MISS_CONFLICT,      // Would hit in a fully associative LRU cache of the same size
+    NUM_MISS_TYPES
+} MissType;
+
+class MissClassifier;
+
+// Bitmap of the seen lines of a chunk
+typedef struct {
+    uint64_t bits[CLASSIFIER_CHUNK_LINES / 64];
+} SeenChunk;
+
+// What a reference changed in the classifier, so that it can be undone
+typedef struct {
+    MissClassifier* classifier;
+    uint64_t lineAddress;
+    uint64_t oldStamp;          // Previous recency stamp of the line, if it was present
+    uint64_t evictedAddress;    // Line evicted from the shadow cache, if any
+    uint64_t evictedStamp;
+    bool wasSeen, wasPresent, evicted;
+} ClassifierRecord;
+
+class MissClassifier {
+private:
+    uint64_t capacity;                                  // Number of lines of the shadow cache
+    uint64_t clock;                                     // Recency stamp given to the last reference
+
+    std::unordered_map<uint64_t, SeenChunk> seen;       // Chunk index -> lines that have been referenced at least once
+    uint64_t numSeen;
+    std::unordered_map<uint64_t, uint64_t> stamps;      // Line address -> recency stamp of the lines in the shadow cache
+    std::map<uint64_t, uint64_t> recency;               // Recency stamp -> line address, least recently used first
+
+    bool markSeen(uint64_t lineAddress);
+    void unmarkSeen(uint64_t lineAddress);
+
+public:
+    MissClassifier(uint64_t numLines);
+
+    MissType reference(uint64_t lineAddress, ClassifierRecord* record);
+    void referenceHits(const uint64_t* lineAddresses, size_t count);
+    void undo(const ClassifierRecord* record);
+    void clear();
+
+    // Checkpoints
+    void saveState(FILE* file);
+    int loadState(FILE* file);
+};
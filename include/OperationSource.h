@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Misc.h"
+
+// A stream of memory operations that the simulator pulls one at a time, instead of reading them from a parsed trace.
+// Sources have to be deterministic: after rewind they must produce the same operations again.
+class OperationSource {
+public:
+    virtual ~OperationSource() {}
+
+    /**
+     * Produces the next operation of the stream.
+     * @param op The operation to fill. Its data pointer must point to storage for at least one word, or for the
+     *           longest line of the hierarchy for sources of multi-word requests.
+     * @return true If an operation was produced, false if the stream has ended.
+     */
+    virtual bool next(MemoryOperation* op) = 0;
+
+    /**
+     * Restarts the stream from its first operation.
+     */
+    virtual void rewind() = 0;
+
+    /**
+     * Returns the number of operations of the stream.
+     * @return uint64_t The number of operations.
+     */
+    virtual uint64_t getNumOps() = 0;
+};
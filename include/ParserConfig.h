@@ -4,4 +4,14 @@
 #include "iniparser.h"
 #include "Simulator.h"
 
-int parseConfiguration(char* iniName, SimulatorConfig* sc);
\ No newline at end of file
+// Parameter sweeps
+#define SWEEP_MAX_POINTS 4096               // Configurations a sweep can expand into
+
+// A configuration of a sweep
+typedef struct {
+    SimulatorConfig config;
+    std::vector<std::string> values;        // Value of each swept key
+} SweepPoint;
+
+int parseConfiguration(char* iniName, SimulatorConfig* sc);
+int parseSweep(char* iniName, std::vector<std::string>* keys, std::vector<SweepPoint>* points);
@@ -2,4 +2,4 @@
 
 #include "Misc.h"
 
-int parseTrace(const char* traceFile, MemoryOperation*** ops, uint32_t* numOperations);
\ No newline at end of file
+int parseTrace(const char* traceFile, MemoryOperation*** ops, uint64_t* numOperations, uint64_t baseAddress);
\ No newline at end of file
@@ -1,50 +1,163 @@
 #pragma once
 
 #include <stdint.h>
+#include <vector>
+#include <algorithm>
 
 #include "Misc.h"
 #include "Cache.h"
 #include "MainMemory.h"
+#include "Journal.h"
+#include "IntervalStats.h"
+#include "StatsHistory.h"
+#include "StatsRegistry.h"
+#include "OperationSource.h"
+#include "FilterStream.h"
 #include "PolicyReplacement.h"
 #include "PolicyWrite.h"
 
+#define SIMULATOR_BATCH_SIZE 256            // Operations handed to the hierarchy at once by the runs that need no per step work
+
+// Conditions of the breakpoints, besides the ones marked in the trace
+typedef enum {
+    BREAK_ADDRESS,                  // An operation of the trace accesses an address range
+    BREAK_MISS,                     // A cache misses
+    BREAK_DIRTY_EVICTION,           // A cache writes a dirty line back
+    BREAK_SET_REPLACEMENT,          // A cache replaces a valid line of a set
+    NUM_BREAK_CONDITIONS
+} BreakCondition;
+
+// A conditional breakpoint. Stepping stops after the operation that meets its condition
+typedef struct {
+    BreakCondition condition;
+    uint64_t first, last;           // Address range, both included. Only for BREAK_ADDRESS
+    int32_t cache;                  // Index of the cache, -1 for any. Not for BREAK_ADDRESS
+    uint32_t set;                   // Only for BREAK_SET_REPLACEMENT
+} Breakpoint;
+
 class Simulator {
 private:
     // Private variables
     // Pointers to elements of the memory hierarchy
-    Cache* caches[MAX_CACHE_LEVELS];
+    std::vector<Cache*> caches;     // Every cache before the ones below it
     MainMemory* memory;
-    MemoryElement* hierarchyStart;  // The first element of the hierarchy. All messages will be sent to it
+    std::vector<MemoryElement*> entries;    // Element that receives the instruction fetches (even) and the data accesses (odd) of each core
 
-    // Instructions to execute
-    MemoryOperation** operations;
+    // Instructions to execute, either from a parsed trace or pulled from a source one at a time
+    MemoryOperation** operations;   // nullptr if the operations come from a source
+    OperationSource* source;        // nullptr if the operations come from a parsed trace
+    MemoryOperation streamOperation;
+    uint64_t* streamData;
+    uint32_t maxWords;              // Words of the longest request that can reach any level
 
     // CPU variables
-    int32_t addressWidth, wordWidth;
-    uint32_t numOperations;
-    uint8_t cacheLevels;
+    int32_t addressWidth, wordWidth, randSeed;
+    uint64_t numOperations;
+    uint32_t cacheLevels;           // Number of caches
+    uint32_t numCores;
+    bool quiet;                     // Do not print the progress of each operation nor update the styles
 
     // Stats
     double totalAccessTime;
+    uint64_t warmupOperations;      // Operations executed before the stats were reset
+    StatsRegistry stats;            // Every statistic of the simulation, by name
+
+    // Undo journal, nullptr if disabled
+    Journal* journal;
+
+    // Interval sampling, nullptr if disabled
+    IntervalStats* intervalStats;
+
+    // History of the stats for the charts of the GUI, nullptr if disabled
+    StatsHistory* history;
+
+    // Conditional breakpoints, compiled into the address ranges and the counters they watch. A watched counter
+    // triggers its breakpoint when it changes
+    std::vector<Breakpoint> breakpoints;
+    std::vector<uint64_t> watchedRanges;            // First and last address of each range
+    std::vector<const uint64_t*> watchedCounters;
+    std::vector<uint64_t> watchedValues;            // Value of each counter when the watch was armed
+    std::vector<uint32_t> watchedOwners;            // Breakpoint of each range, then of each counter
+    int32_t triggeredBreakpoint;
+
+    // Recorder of the requests to a level, nullptr if disabled
+    FilterRecorder* filterRecorder;
+
+    // Filter stream being replayed, nullptr if the operations come from a trace. Also the source
+    FilterReader* filter;
+
+    // State serialisation
+    void saveState(FILE* file);
+    int loadState(FILE* file, const char* name);
+    void saveCounters(std::vector<uint64_t>& counters);
+    void restoreCounters(const std::vector<uint64_t>& counters);
+
+    void setFunctional(bool isFunctional);
+    void setEntryLevel(uint32_t level);
+    MemoryElement* getEntry(MemoryOperation* op, uint32_t core);
+    MemoryOperation* fetchOperation();
+    void syncSource();
+    void replayCycle(MemoryReply* rep);
+    void stepBatches();
+    void compileBreakpoints();
+    void armBreakpoints();
+    bool checkBreakpoints();
 
 public:
     Simulator(SimulatorConfig* sc, MemoryOperation** ops);
+    Simulator(SimulatorConfig* sc, OperationSource* src);
+    Simulator(SimulatorConfig* sc, FilterReader* fr);
     ~Simulator();
 
     void singleStep();
     void stepAll(bool stopOnBreakpoint);
+    bool stepSome(uint64_t numOps, bool stopOnBreakpoint);
+    void access(MemoryOperation* op, MemoryReply* rep, uint32_t core = 0);
+    void accessBatch(MemoryOperation** ops, MemoryReply* reps, uint32_t numOps, uint32_t core = 0);
+    void warmup(uint64_t numOps);
     void reset();
+    void restart();
+    void setQuiet(bool isQuiet);
+
+    // Reverse stepping
+    void enableJournal();
+    bool stepBack();
+    void seek(uint64_t target);
+
+    // Conditional breakpoints
+    int addBreakpoint(const Breakpoint* breakpoint);
+    void removeBreakpoint(uint32_t index);
+    uint32_t getNumBreakpoints();
+    const Breakpoint* getBreakpoint(uint32_t index);
+    int32_t getTriggeredBreakpoint();
+
+    // Interval statistics
+    void setIntervalStats(IntervalStats* is);
+
+    // Statistics history
+    void enableHistory();
+    StatsHistory* getHistory();
+
+    // Filter streams
+    void setFilterRecorder(FilterRecorder* fr);
+
+    // Checkpoints
+    int saveCheckpoint(const char* path);
+    int loadCheckpoint(const char* path);
 
     // Object getters
     MemoryOperation** getOps();
     MainMemory* getMemory();
-    Cache* getCache(uint8_t cache);
+    Cache* getCache(uint32_t cache);
+    StatsRegistry* getStats();
 
     // Other getters
-    uint32_t getNumOps();
-    uint8_t getNumCaches();
+    uint64_t getNumOps();
+    uint32_t getNumCaches();
+    uint32_t getNumCores();
     uint32_t getAddressWidth();
     uint32_t getWordWidth();
+    uint64_t getMeasuredOps();
     double getTotalAccessTime();
 
     void clearAllStyles();
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "Misc.h"
+
+// Statistics history
+#define HISTORY_SIZE 512                    // Samples kept. When full, every other one is dropped and the stride doubles
+
+class Simulator;
+
+// Counters of the hierarchy after an operation, accumulated since the stats were last reset
+typedef struct {
+    uint64_t cycle;                 // Operations executed when the sample was taken
+    uint64_t measuredOps;
+    double time;                    // Total access time
+    uint64_t memoryAccesses;        // Words read or written in the main memory
+} HistorySample;
+
+// Samples the counters of the whole simulation so that the GUI can chart them. The samples are evenly spaced, and
+// their number is bounded by downsampling the older ones, so the history costs the same after any number of operations
+class StatsHistory {
+private:
+    Simulator* sim;
+    uint32_t cacheLevels;
+    uint64_t stride;                // Operations between samples, a power of 2
+
+    // Samples, oldest first. The first one is the state the history started from
+    HistorySample samples[HISTORY_SIZE];
+    std::vector<uint64_t> levels;   // Accesses and hits of each cache for each sample
+    uint32_t count;
+
+    void takeSample();
+    void downsample();
+
+public:
+    StatsHistory(Simulator* simulator);
+
+    void step();
+    void truncate(uint64_t target);
+    void clear();
+
+    uint32_t getNumSamples();
+    uint64_t getStride();
+    const HistorySample* getSample(uint32_t index);
+    uint64_t getAccesses(uint32_t index, uint32_t level);
+    uint64_t getHits(uint32_t index, uint32_t level);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Misc.h"
+
+// Types of the counters that can be registered
+typedef enum {
+    STAT_U32,
+    STAT_U64,
+    STAT_DOUBLE
+} StatType;
+
+// A registered counter. The registry only keeps a pointer, the counter is still owned and updated by its element
+typedef struct {
+    std::string name;               // Hierarchical name, with the levels separated by dots (E.g. l2.d.misses.conflict)
+    StatType type;
+    const void* value;
+} StatEntry;
+
+class StatsRegistry {
+private:
+    std::vector<StatEntry> entries;     // In registration order
+
+    void formatValue(FILE* file, const StatEntry* entry);
+
+public:
+    // Registration
+    void add(const std::string& name, const uint32_t* value);
+    void add(const std::string& name, const uint64_t* value);
+    void add(const std::string& name, const double* value);
+
+    // Queries
+    uint32_t getNumStats();
+    const char* getName(uint32_t index);
+    double getValue(uint32_t index);
+    int32_t find(const char* name);
+    const uint64_t* getCounter(int32_t index);
+    uint64_t getCount(const std::string& name);
+
+    // Export
+    void printCsv(FILE* file);
+    int writeJson(const char* path);
+    int writeCsv(const char* path);
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Misc.h"
+#include "OperationSource.h"
+
+// Trace generator defaults
+#define GENERATOR_DEFAULT_OPERATIONS 1000000    // Operations of a generated trace
+#define GENERATOR_DEFAULT_STRIDE 64             // Bytes between accesses of the stride pattern and between pointer chase nodes
+#define GENERATOR_DEFAULT_ZIPF 0.99             // Skew of the Zipfian pattern
+#define GENERATOR_DEFAULT_BLOCK 32              // Elements per side of the blocks of the matrix multiply
+#define GENERATOR_DEFAULT_WRITES 0.3            // Fraction of the data accesses that are stores
+#define GENERATOR_DEFAULT_INST 0.0              // Fraction of the operations that are instruction fetches
+#define GENERATOR_DEFAULT_SEED 1
+#define GENERATOR_MAX_CODE_BYTES 65536          // Upper bound of the region that the instruction fetches walk through
+#define GENERATOR_JUMP_PERIOD 16                // One in this many instruction fetches jumps to a random place
+
+// Access patterns of the generated data accesses
+typedef enum {
+    GEN_SEQUENTIAL,     // One word after another
+    GEN_STRIDE,         // Fixed jumps, wrapping around the footprint
+    GEN_UNIFORM,        // Random words, all equally likely
+    GEN_ZIPF,           // Random words, a few of them much more likely than the rest
+    GEN_CHASE,          // Pointer chasing, every node is visited once per round in a random order
+    GEN_MATMUL,         // Blocked multiplication of two square matrices, C += A * B
+    NUM_GEN_PATTERNS
+} GeneratorPattern;
+
+// Parameters of a generated trace
+typedef struct {
+    GeneratorPattern pattern;
+    uint64_t numOps;
+    uint64_t baseAddress;       // First address of the footprint
+    uint64_t footprint;         // Bytes covered by the trace, code included
+    uint32_t wordWidth;         // In Bytes
+    uint64_t stride;            // In Bytes, for GEN_STRIDE and GEN_CHASE
+    double writeRatio;          // Fraction of the data accesses that are stores. Ignored by GEN_MATMUL
+    double instRatio;           // Fraction of the operations that are instruction fetches
+    double zipfSkew;            // Exponent of the Zipfian distribution
+    uint32_t block;             // Elements per side of the blocks of GEN_MATMUL
+    uint32_t seed;
+} GeneratorConfig;
+
+class TraceGenerator : public OperationSource {
+private:
+    GeneratorConfig config;
+    uint64_t generated;
+
+    // Layout of the footprint, in words. The code goes first and the data after it
+    uint64_t codeWords, dataWords;
+
+    // Random numbers, independent from the generator of the simulation
+    uint64_t state;
+    uint64_t instThreshold, writeThreshold;
+
+    // Pattern state
+    uint64_t pc;                // Next instruction, relative to the code
+    uint64_t position;          // Next word of GEN_SEQUENTIAL and GEN_STRIDE, next node of GEN_CHASE
+    uint64_t strideWords;
+    uint64_t numNodes, permMask, permIncrement, chaseMultiplier;
+
+    // Zipfian sampling by rejection-inversion
+    double zipfIntegralFirst, zipfIntegralLast, zipfThreshold;
+    uint64_t zipfMask;
+
+    // Loop nest of GEN_MATMUL
+    uint64_t matrixSize;
+    uint64_t ii, jj, kk, i, j, k;
+    uint8_t matmulPhase;
+
+    uint64_t nextRandom();
+    double randomUnit();
+    uint64_t scatter(uint64_t index, uint64_t mask);
+    double zipfH(double x);
+    double zipfIntegral(double x);
+    double zipfIntegralInverse(double x);
+    uint64_t nextZipf();
+    uint64_t nextChase();
+    uint64_t nextMatmul(Operation* operation);
+
+public:
+    TraceGenerator();
+
+    int init(const GeneratorConfig* gc);
+    int writeTrace(const char* path);
+
+    virtual bool next(MemoryOperation* op) override;
+    virtual void rewind() override;
+    virtual uint64_t getNumOps() override;
+};
+
+// Pattern names, as used in the CLI
+const char* generatorPatternStr(GeneratorPattern pattern);
+int parseGeneratorPattern(const char* string);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+
+#include "Misc.h"
+#include "OperationSource.h"
+#include "CompressedTrace.h"
+
+#define IMPORT_BUFFER_SIZE (1 << 20)        // Bytes of the read buffer of the imported file
+#define IMPORT_MAX_RECORD_OPERATIONS 8      // Operations produced by a single record of any format
+
+// Formats of the trace files that can be simulated
+typedef enum {
+    TRACE_FORMAT_VCA,           // Text traces of NuCachis
+    TRACE_FORMAT_COMPRESSED,    // Compressed traces of NuCachis
+    TRACE_FORMAT_DIN,           // Dinero din traces: "label address" per line
+    TRACE_FORMAT_LACKEY,        // Output of valgrind --tool=lackey --trace-mem=yes
+    TRACE_FORMAT_CHAMPSIM,      // Uncompressed ChampSim traces, input_instr records of 64 Bytes
+    NUM_TRACE_FORMATS
+} TraceFormat;
+
+// Instruction of a ChampSim trace, as written by its tracer on a little endian machine
+typedef struct {
+    uint64_t ip;
+    uint8_t isBranch;
+    uint8_t branchTaken;
+    uint8_t destinationRegisters[2];
+    uint8_t sourceRegisters[4];
+    uint64_t destinationMemory[2];  // Addresses stored to, 0 if unused
+    uint64_t sourceMemory[4];       // Addresses loaded from, 0 if unused
+} ChampSimInstruction;
+
+static_assert(sizeof(ChampSimInstruction) == 64, "ChampSim records are 64 Bytes long");
+
+// Translates the records of an external trace format into operations while the simulator runs, without converting
+// the file first. Accesses become single word operations at their address, as in text traces, and stores write 0.
+// Addresses are not relocated: the memory must be configured so that none of them is below its page base address,
+// which open() checks for every record.
+class TraceImporter : public OperationSource {
+private:
+    FILE* file;
+    char* buffer;
+    char* line;
+    size_t lineLength;
+    std::string path;
+    TraceFormat format;
+    uint64_t numOps;
+    uint64_t lineNumber;
+    uint64_t baseAddress;           // Lowest address an operation can have
+
+    // Operations of the last record that have not been produced yet
+    TraceRecord pending[IMPORT_MAX_RECORD_OPERATIONS];
+    uint32_t numPending, nextPending;
+
+    int readRecord();
+    int readDin();
+    int readLackey();
+    int readChampSim();
+    void addPending(uint64_t address, uint8_t flags);
+
+public:
+    TraceImporter();
+    ~TraceImporter();
+
+    int open(const char* path, TraceFormat format, uint64_t baseAddress);
+    void close();
+
+    virtual bool next(MemoryOperation* op) override;
+    virtual void rewind() override;
+    virtual uint64_t getNumOps() override;
+};
+
+TraceFormat detectTraceFormat(const char* path);
+const char* traceFormatStr(TraceFormat format);
@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ * C interface of libnucachis, to embed the simulator in other programs and feed it with accesses instead of traces.
+ * Only fixed size types cross it, so it stays usable from C and through FFI, and its structs keep their layout across
+ * releases. Changes that break it increment NC_API_VERSION.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NC_API_VERSION 1
+
+// Types of access
+#define NC_LOAD 0                   // Data load
+#define NC_STORE 1                  // Data store
+#define NC_IFETCH 2                 // Instruction fetch
+
+// Hit level of the accesses served by the main memory. Caches are numbered by their distance to the cores, 1 for L1
+#define NC_HIT_MEMORY 0
+
+// A simulation, opaque to the embedder
+typedef struct nc_sim nc_sim;
+
+// An access sent by the embedder
+typedef struct {
+    uint64_t address;
+    uint64_t data;                  // Word to write, only used by stores
+    uint8_t type;                   // NC_LOAD, NC_STORE or NC_IFETCH
+    uint8_t core;                   // Core that makes it, below nc_sim_num_cores. 0 in single core hierarchies
+    uint8_t reserved[6];
+} nc_access;
+
+// The outcome of an access
+typedef struct {
+    double latency;                 // Time to complete the access, in the units of the configuration
+    uint64_t data;                  // Word read, only set by loads and instruction fetches
+    uint8_t hit_level;              // Level that had the data, NC_HIT_MEMORY if no cache did
+    uint8_t reserved[7];
+} nc_result;
+
+nc_sim* nc_sim_create(const char* config_path);
+void nc_sim_destroy(nc_sim* sim);
+void nc_sim_reset(nc_sim* sim);
+uint32_t nc_sim_num_cores(nc_sim* sim);
+
+uint64_t nc_sim_access_batch(nc_sim* sim, const nc_access* accesses, uint64_t count, nc_result* results);
+
+int nc_stats_get(nc_sim* sim, const char* name, double* value);
+uint32_t nc_stats_count(nc_sim* sim);
+const char* nc_stats_name(nc_sim* sim, uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,8 @@
+#include <algorithm>
+
 #include "Cache.h"
+#include "Journal.h"
+#include "StatsRegistry.h"
 
 /**
  * Constructs a new Cache object.
@@ -8,8 +12,12 @@
  * @param policy The write policy used in the cache
  * @param split If the cache is split for instructions and data or not.
  */
-Cache::Cache(SimulatorConfig* sc, uint8_t identifier) {
+Cache::Cache(SimulatorConfig* sc, uint32_t identifier) {
     id = identifier;
+    level = sc->cacheLevel.empty() ? id + 1 : sc->cacheLevel[id];
+    name = sc->cacheName.empty() ? "l" + std::to_string(id + 1) : sc->cacheName[id];
+    label = name;
+    std::transform(label.begin(), label.end(), label.begin(), ::toupper);
     size = sc->cacheSize[id];
     lineSize = sc->cacheLineSize[id];                   // Size of the lines in Bytes
     accessTime = sc->cacheAccessTime[id];
@@ -26,22 +34,38 @@ Cache::Cache(SimulatorConfig* sc, uint8_t identifier) {
         sets = sets / 2;
     }
     lines = sets * ways;
+    showSide = isSplit || sc->miscIsChain;
+
+    // Bits of the offset and the set in an address, used on every access
+    offsetBits = log2(lineSize);
+    setBits = log2(sets);
 
     if (isSplit) {
         // Allocate the caches
-        caches[DATA_CACHE] = (CacheLine*) malloc(sets * ways * sizeof(CacheLine));
-        caches[INST_CACHE] = (CacheLine*) malloc(sets * ways * sizeof(CacheLine));
+        caches[DATA_CACHE] = (CacheLine*) calloc(sets * ways, sizeof(CacheLine));
+        caches[INST_CACHE] = (CacheLine*) calloc(sets * ways, sizeof(CacheLine));
     } else {
-        caches[DATA_CACHE] = (CacheLine*) malloc(sets * ways * sizeof(CacheLine));
+        caches[DATA_CACHE] = (CacheLine*) calloc(sets * ways, sizeof(CacheLine));
         caches[INST_CACHE] = nullptr;
     }
+    contents[INST_CACHE] = nullptr;
+    setBases[INST_CACHE] = nullptr;
+    setCounters[INST_CACHE] = nullptr;
+    classifiers[INST_CACHE] = nullptr;
 
     // Allocate space for the content
     for (int i = 0; i < (isSplit ? 2 : 1); i++) {
+        // A single block holds the content of every line so that it can be saved and restored in one go
+        contents[i] = (uint64_t*) malloc(sizeof(uint64_t) * lineSizeWords * lines);
+
         for (int j = 0; j < lines; j++) {
-            // Allocate lineSizeWords slots for data
-            caches[i][j].content = (uint64_t*) malloc(sizeof(uint64_t) * lineSizeWords);
+            // Each line points to its lineSizeWords slots for data
+            caches[i][j].content = contents[i] + j * lineSizeWords;
         }
+
+        setBases[i] = (uint64_t*) malloc(sizeof(uint64_t) * sets);
+        setCounters[i] = (uint64_t*) malloc(sizeof(uint64_t) * sets * NUM_SET_COUNTERS);
+        classifiers[i] = new MissClassifier(lines);
     }
 
     // Init all execution dependent stats
@@ -51,9 +75,10 @@ Cache::Cache(SimulatorConfig* sc, uint8_t identifier) {
 Cache::~Cache() {
     // Deallocate the space for the content
     for (int i = 0; i < (isSplit ? 2 : 1); i++) {
-        for (int j = 0; j < lines; j++) {
-            free(caches[i][j].content);
-        }
+        free(contents[i]);
+        free(setBases[i]);
+        free(setCounters[i]);
+        delete classifiers[i];
     }
 
     // Free the data cache
@@ -75,6 +100,30 @@ bool Cache::isCacheSplit() {
     return isSplit;
 }
 
+/**
+ * Returns the name of the cache, the prefix of its statistics.
+ * @return const char* The name (E.g. l1).
+ */
+const char* Cache::getName() {
+    return name.c_str();
+}
+
+/**
+ * Returns the name of the cache as it is shown to the user.
+ * @return const char* The label (E.g. L1).
+ */
+const char* Cache::getLabel() {
+    return label.c_str();
+}
+
+/**
+ * Returns the level of the cache, its longest distance from a core.
+ * @return uint32_t The level, 1 for the caches that receive the accesses of a core.
+ */
+uint32_t Cache::getLevel() {
+    return level;
+}
+
 /**
  * Returns the cache whole data or instruction cache. 
  * @param getInst 0 if the cache should be the data cache, 1 if it should be the instr cache. Returns the data cache by default
@@ -97,6 +146,14 @@ uint32_t Cache::getLines() {
     return lines;
 }
 
+/**
+ * Gets the number of sets of a cache. If the cache is split, it is the number of sets of each side.
+ * @return uint32_t The number of sets.
+ */
+uint32_t Cache::getSets() {
+    return sets;
+}
+
 /**
  * Gets the total number of words stored in a cache line.
  * @return uint32_t The number of words.
@@ -105,41 +162,110 @@ uint32_t Cache::getLineSizeWords() {
     return lineSizeWords;
 }
 
+/**
+ * Gets the cycle that the timestamps of each set are relative to. The absolute cycle of an access is the base of its set plus its timestamp.
+ * @param getInst 0 for the bases of the data cache, 1 for the ones of the instr cache. Returns the data cache by default
+ * @return const uint64_t* Array with the base of each set, nullptr if the cache does not exist.
+ */
+const uint64_t* Cache::getSetBases(bool getInst) {
+    return setBases[getInst ? INST_CACHE : DATA_CACHE];
+}
+
+/**
+ * Gets the counters of every set, NUM_SET_COUNTERS per set, indexed by SetCounter.
+ * @param getInst 0 for the sets of the data cache, 1 for the ones of the instr cache. Returns the data cache by default
+ * @return const uint64_t* Array with the counters of each set, nullptr if the cache does not exist.
+ */
+const uint64_t* Cache::getSetCounters(bool getInst) {
+    return setCounters[getInst ? INST_CACHE : DATA_CACHE];
+}
+
 /**
  * Gets the total number of accesses.
- * @return uint32_t The number of accesses
+ * @return uint64_t The number of accesses
  */
-uint32_t Cache::getAccesses() {
+uint64_t Cache::getAccesses() {
     return accesses;
 }
     
 /**
  * Gets the total number of hits.
- * @return uint32_t The number of hits
+ * @return uint64_t The number of hits
  */
-uint32_t Cache::getHits() {
+uint64_t Cache::getHits() {
     return hits;
 }
 
 /**
  * Gets the total number of misses.
- * @return uint32_t The number of misses
+ * @return uint64_t The number of misses
  */
-uint32_t Cache::getMisses() {
+uint64_t Cache::getMisses() {
     return misses;
 }
 
 /**
- * Resets the entire cache. 
+ * Gets the total number of dirty lines written back to the lower level.
+ * @return uint64_t The number of write-backs
  */
-void Cache::flush() {
-    // Reset the stats
+uint64_t Cache::getWritebacks() {
+    return writebacks;
+}
+
+/**
+ * Gets the number of misses of a given type.
+ * @param type The type of miss.
+ * @param getInst 0 for the misses of data operations, 1 for the misses of instruction operations. Returns data by default
+ * @return uint64_t The number of misses
+ */
+uint64_t Cache::getMissesOfType(MissType type, bool getInst) {
+    return missesByType[getInst ? INST_CACHE : DATA_CACHE][type];
+}
+
+/**
+ * Resets the stats of the cache without modifying its content.
+ */
+void Cache::resetStats() {
     accesses = 0;
     hits = 0;
     misses = 0;
+    writebacks = 0;
 
-    // Init the cache
+    for (int i = 0; i < NUM_CACHE_TYPES; i++) {
+        for (int j = 0; j < NUM_MISS_TYPES; j++) {
+            missesByType[i][j] = 0;
+        }
+    }
+
+    // The dirty lines of each set are part of its state, not a statistic
     for (int i = 0; i < (isSplit ? 2 : 1); i++) {
+        for (uint32_t j = 0; j < sets; j++) {
+            setCounters[i][j * NUM_SET_COUNTERS + SET_HITS] = 0;
+            setCounters[i][j * NUM_SET_COUNTERS + SET_MISSES] = 0;
+            setCounters[i][j * NUM_SET_COUNTERS + SET_EVICTIONS] = 0;
+        }
+    }
+}
+
+/**
+ * Resets the entire cache. 
+ */
+void Cache::flush() {
+    // Reset the stats
+    resetStats();
+
+    for (int i = 0; i < (isSplit ? 2 : 1); i++) {
+        classifiers[i]->clear();
+    }
+
+    // Init the cache, which leaves no line styled
+    styled.clear();
+    for (int i = 0; i < (isSplit ? 2 : 1); i++) {
+        for (int j = 0; j < sets; j++) {
+            setBases[i][j] = 0;
+            setCounters[i][j * NUM_SET_COUNTERS + SET_DIRTY_LINES] = 0;
+        }
+
         for (int j = 0; j < lines; j++) {
             // Init the content to 0
             for (int k = 0; k < lineSizeWords; k++) {
@@ -156,8 +282,139 @@ void Cache::flush() {
             caches[i][j].valid = false;
             caches[i][j].dirty = false;
             caches[i][j].lineColor = COLOR_NONE;
+            caches[i][j].version++;
+        }
+    }
+}
+
+/**
+ * Writes the whole state of the cache (stats, line metadata and content) to a checkpoint.
+ * @param file The checkpoint file, opened for writing.
+ */
+void Cache::saveState(FILE* file) {
+    // Geometry, used to make sure the checkpoint is restored in an identical cache
+    uint64_t geometry[4] = {sets, ways, lineSizeWords, isSplit};
+    uint64_t stats[4] = {accesses, hits, misses, writebacks};
+    fwrite(geometry, sizeof(uint64_t), 4, file);
+    fwrite(stats, sizeof(uint64_t), 4, file);
+    fwrite(missesByType, sizeof(uint64_t), NUM_CACHE_TYPES * NUM_MISS_TYPES, file);
+
+    CheckpointLine* state = (CheckpointLine*) malloc(sizeof(CheckpointLine) * lines);
+
+    for (int i = 0; i < (isSplit ? 2 : 1); i++) {
+        // Pack the metadata of all lines and write it in one go, followed by the content of all lines
+        for (int j = 0; j < lines; j++) {
+            state[j].tag = caches[i][j].tag;
+            state[j].firstAccess = caches[i][j].firstAccess;
+            state[j].lastAccess = caches[i][j].lastAccess;
+            state[j].numberAccesses = caches[i][j].numberAccesses;
+            state[j].valid = caches[i][j].valid;
+            state[j].dirty = caches[i][j].dirty;
+            state[j].padding = 0;
+        }
+
+        fwrite(state, sizeof(CheckpointLine), lines, file);
+        fwrite(contents[i], sizeof(uint64_t), lines * lineSizeWords, file);
+        fwrite(setBases[i], sizeof(uint64_t), sets, file);
+        fwrite(setCounters[i], sizeof(uint64_t), sets * NUM_SET_COUNTERS, file);
+        classifiers[i]->saveState(file);
+    }
+
+    free(state);
+}
+
+/**
+ * Restores the whole state of the cache from a checkpoint written by saveState.
+ * @param file The checkpoint file, opened for reading.
+ * @return int 0 if Ok, -1 if the checkpoint is truncated or belongs to a cache with a different geometry.
+ */
+int Cache::loadState(FILE* file) {
+    uint64_t geometry[4];
+    uint64_t stats[4];
+
+    if (fread(geometry, sizeof(uint64_t), 4, file) != 4 || fread(stats, sizeof(uint64_t), 4, file) != 4 ||
+        fread(missesByType, sizeof(uint64_t), NUM_CACHE_TYPES * NUM_MISS_TYPES, file) != NUM_CACHE_TYPES * NUM_MISS_TYPES) {
+        fprintf(stderr, "Checkpoint Error: %s is truncated\n", label.c_str());
+        return -1;
+    }
+
+    if (geometry[0] != sets || geometry[1] != ways || geometry[2] != lineSizeWords || geometry[3] != isSplit) {
+        fprintf(stderr, "Checkpoint Error: %s has a different geometry than the configured one\n", label.c_str());
+        return -1;
+    }
+
+    CheckpointLine* state = (CheckpointLine*) malloc(sizeof(CheckpointLine) * lines);
+    int result = 0;
+    styled.clear();
+
+    for (int i = 0; i < (isSplit ? 2 : 1) && result == 0; i++) {
+        if (fread(state, sizeof(CheckpointLine), lines, file) != lines ||
+            fread(contents[i], sizeof(uint64_t), lines * lineSizeWords, file) != lines * lineSizeWords ||
+            fread(setBases[i], sizeof(uint64_t), sets, file) != sets ||
+            fread(setCounters[i], sizeof(uint64_t), sets * NUM_SET_COUNTERS, file) != sets * NUM_SET_COUNTERS ||
+            classifiers[i]->loadState(file) != 0) {
+            fprintf(stderr, "Checkpoint Error: %s is truncated\n", label.c_str());
+            result = -1;
+            break;
+        }
+
+        // Unpack the metadata, set and way are implicit in the position of the line
+        for (int j = 0; j < lines; j++) {
+            caches[i][j].tag = state[j].tag;
+            caches[i][j].firstAccess = state[j].firstAccess;
+            caches[i][j].lastAccess = state[j].lastAccess;
+            caches[i][j].numberAccesses = state[j].numberAccesses;
+            caches[i][j].valid = state[j].valid;
+            caches[i][j].dirty = state[j].dirty;
+            caches[i][j].lineColor = COLOR_NONE;
+            caches[i][j].version++;
+        }
+    }
+
+    free(state);
+
+    accesses = stats[0];
+    hits = stats[1];
+    misses = stats[2];
+    writebacks = stats[3];
+
+    return result;
+}
+
+/**
+ * Appends the stats of the cache to a list of counters.
+ * @param counters The list.
+ */
+void Cache::saveCounters(std::vector<uint64_t>& counters) {
+    counters.push_back(accesses);
+    counters.push_back(hits);
+    counters.push_back(misses);
+    counters.push_back(writebacks);
+
+    for (int i = 0; i < NUM_CACHE_TYPES; i++) {
+        counters.insert(counters.end(), missesByType[i], missesByType[i] + NUM_MISS_TYPES);
+    }
+}
+
+/**
+ * Restores the stats of the cache from a list of counters written by saveCounters.
+ * @param counters Pointer to the first counter of this cache.
+ * @return const uint64_t* Pointer to the counter after the ones of this cache.
+ */
+const uint64_t* Cache::restoreCounters(const uint64_t* counters) {
+    accesses = counters[0];
+    hits = counters[1];
+    misses = counters[2];
+    writebacks = counters[3];
+    counters += 4;
+
+    for (int i = 0; i < NUM_CACHE_TYPES; i++) {
+        for (int j = 0; j < NUM_MISS_TYPES; j++) {
+            missesByType[i][j] = *counters++;
         }
     }
+
+    return counters;
 }
 
 /*
@@ -183,12 +440,6 @@ uint64_t Cache::getMask(uint64_t numBits) {
  * @return uint64_t The tag.
  */
 uint64_t Cache::getTag(uint64_t address) {
-    // Calculate the number of bits for the offset
-    uint32_t offsetBits = log2(lineSize);
-    
-    // Calculate the number of bits for the set
-    uint32_t setBits = log2(sets);
-
     // Remove the set and offset bits
     return address >> setBits >> offsetBits;
 }
@@ -199,12 +450,7 @@ uint64_t Cache::getTag(uint64_t address) {
  * @return uint32_t The set.
  */
 uint32_t Cache::getSet(uint64_t address) {
-    // Calculate the number of bits for the offset
-    uint32_t offsetBits = log2(lineSize);
     uint64_t addrWithoutOffset = address >> offsetBits;
-    
-    // Calculate the number of bits for the set
-    uint32_t setBits = log2(sets);
 
     // And the address with a mask of setBits bits to remove the tag
     return addrWithoutOffset & getMask(setBits);
@@ -217,7 +463,7 @@ uint32_t Cache::getSet(uint64_t address) {
  */
 uint32_t Cache::getOffset(uint64_t address) {
     // Remove the bits that are not offset
-    return address & getMask(log2(lineSize));
+    return address & getMask(offsetBits);
 }
 
 /**
@@ -227,9 +473,6 @@ uint32_t Cache::getOffset(uint64_t address) {
  * @return uint64_t The address without the offset.
  */
 uint64_t Cache::getAddressFromTagAndSet(uint64_t tag, uint32_t set) {
-    // Calculate the number of bits for the offset and set
-    uint32_t offsetBits = log2(lineSize);
-    uint32_t setBits = log2(sets);
     return (tag << setBits << offsetBits) | (set << offsetBits);
 }
 
@@ -254,6 +497,135 @@ int32_t Cache::searchAddress(CacheLine* cache, uint64_t address) {
     return -1; 
 }
 
+/**
+ * Prints a message about what the cache is doing, prefixed by the name of the cache. Nothing is printed in functional or quiet mode.
+ * @param isData If the message is about the data or the instruction cache.
+ * @param format printf-like format of the message.
+ */
+void Cache::log(bool isData, const char* format, ...) {
+    if (functional || quiet) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    if (showSide) {
+        printf("%s%c: ", label.c_str(), (!isData && isSplit) ? 'I' : 'D');
+    } else {
+        printf("%s: ", label.c_str());
+    }
+    vprintf(format, args);
+    va_end(args);
+}
+
+/**
+ * Updates the shadow structures with a reference to the line of the operation and classifies it if it missed.
+ * @param op The operation.
+ * @param isMiss If the operation missed in the cache.
+ */
+void Cache::classifyReference(MemoryOperation* op, bool isMiss) {
+    ClassifierRecord record;
+    MissClassifier* classifier = classifiers[(isSplit && !op->isData) ? INST_CACHE : DATA_CACHE];
+
+    MissType type = classifier->reference(op->address >> offsetBits, &record);
+    if (journal != nullptr) {
+        journal->recordReference(&record);
+    }
+
+    if (isMiss) {
+        missesByType[op->isData ? DATA_CACHE : INST_CACHE][type]++;
+    }
+}
+
+/**
+ * Must be called before modifying a line, so that the journal can undo the change and the GUI formats it again.
+ * @param cache The cache the line belongs to.
+ * @param line The index of the line.
+ */
+void Cache::touchLine(CacheLine* cache, int32_t line) {
+    cache[line].version++;
+    if (journal != nullptr) {
+        journal->recordLine(this, &cache[line], lineSizeWords);
+    }
+}
+
+/**
+ * Adds to a counter of a set. Every change goes through here, so that the journal can undo it.
+ * @param cache The cache the set belongs to.
+ * @param set The set.
+ * @param counter The counter.
+ * @param amount The amount to add, negative to subtract.
+ */
+void Cache::countInSet(CacheLine* cache, uint32_t set, SetCounter counter, int64_t amount) {
+    uint64_t* value = &setCounters[(cache == caches[INST_CACHE]) ? INST_CACHE : DATA_CACHE][set * NUM_SET_COUNTERS + counter];
+
+    if (journal != nullptr) {
+        journal->recordValue(value);
+    }
+    *value += amount;
+}
+
+/**
+ * Gets a cycle relative to the base of a set, rebasing the set first if the cycle does not fit in a timestamp.
+ * @param cache The cache the set belongs to.
+ * @param set The set.
+ * @param now The cycle, the current one except in batches.
+ * @return int32_t The timestamp of the cycle.
+ */
+int32_t Cache::getStamp(CacheLine* cache, uint32_t set, uint64_t now) {
+    uint64_t* base = &setBases[(cache == caches[INST_CACHE]) ? INST_CACHE : DATA_CACHE][set];
+
+    if (now - *base > CACHE_MAX_STAMP) {
+        rebaseSet(cache, set, base, now);
+    }
+
+    return now - *base;
+}
+
+/**
+ * Moves the base of a set forward so that a cycle gets the timestamp CACHE_REBASE_STAMP.
+ * The timestamps of the lines are shifted back by the same amount. The ones that would become too small are squeezed
+ * into the lowest values keeping their order, so replacement decisions never change. Only the absolute cycles shown for
+ * lines that have not been accessed in CACHE_REBASE_STAMP cycles lose precision.
+ * @param cache The cache the set belongs to.
+ * @param set The set.
+ * @param base The base of the set.
+ * @param now The cycle.
+ */
+void Cache::rebaseSet(CacheLine* cache, uint32_t set, uint64_t* base, uint64_t now) {
+    int64_t reserved = 2 * ways;            // Every line has two timestamps, so this many distinct values are enough for any order
+    int64_t shift = now - *base - CACHE_REBASE_STAMP - reserved;
+    std::vector<int32_t> squeezed;
+
+    // Timestamps that are too old to be shifted, sorted and without repetitions
+    for (int i = set * ways; i < (set + 1) * ways; i++) {
+        if (cache[i].firstAccess != -1 && cache[i].firstAccess < shift + reserved) squeezed.push_back(cache[i].firstAccess);
+        if (cache[i].lastAccess != -1 && cache[i].lastAccess < shift + reserved) squeezed.push_back(cache[i].lastAccess);
+    }
+    std::sort(squeezed.begin(), squeezed.end());
+    squeezed.erase(std::unique(squeezed.begin(), squeezed.end()), squeezed.end());
+
+    if (journal != nullptr) {
+        journal->recordValue(base);
+    }
+    *base += shift;
+
+    for (int i = set * ways; i < (set + 1) * ways; i++) {
+        int32_t* stamps[2] = {&cache[i].firstAccess, &cache[i].lastAccess};
+        touchLine(cache, i);
+
+        for (int j = 0; j < 2; j++) {
+            if (*stamps[j] == -1) {
+                continue;
+            } else if (*stamps[j] < shift + reserved) {
+                *stamps[j] = std::lower_bound(squeezed.begin(), squeezed.end(), *stamps[j]) - squeezed.begin();
+            } else {
+                *stamps[j] -= shift;
+            }
+        }
+    }
+}
+
 /**
  * Extracts the specified number of words from the given cache line and puts them into the reply.
  * @param line The line 
@@ -343,7 +715,7 @@ uint32_t Cache::findReplacement(CacheLine* cache, uint64_t address) {
 
         case RAND:
             // If the policy is RAND, pick a line randomly inside of that set
-            candidate = set * ways + (rand() % ways);
+            candidate = set * ways + (simRand() % ways);
             break;
 
         default:
@@ -358,18 +730,20 @@ uint32_t Cache::findReplacement(CacheLine* cache, uint64_t address) {
  * Fills an entire cache line with data from the lower level.
  * @param address The address to fetch.
  * @param isData If the address contains data or not.
+ * @param hitLevel Returns the level that had the line.
  * @return double The total access time.
  */
-double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isData) {
+double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isData, uint8_t* hitLevel) {
     // Build a new request and reply for the lower level
     MemoryOperation newOp;
     MemoryReply newRep;
     double time = 0.0;
 
-    newOp.address = address >> (uint8_t) log2(lineSize) << (uint8_t) log2(lineSize);    // Remove the offset to point to the base address to fetch
+    newOp.address = address >> offsetBits << offsetBits;    // Remove the offset to point to the base address to fetch
     newOp.numWords = lineSizeWords;
     newOp.operation = LOAD;
     newOp.isData = isData;
+    newOp.hasBreakPoint = false;
 
     newRep.data = (uint64_t*) malloc(sizeof(uint64_t) * lineSizeWords);
     newRep.totalTime = 0.0;
@@ -379,11 +753,15 @@ double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isDat
 
     // Update the stats
     time += newRep.totalTime;
+    *hitLevel = newRep.hitLevel;
 
     // Once the request is here, find a place to put it
     // Find replacement line function that uses the policy of the cache
     int32_t newLine = findReplacement(cache, address);
-    printf("L%u%c: Picked line %d to be evicted\n", id + 1, (!isData && isSplit) ? 'I' : 'D', newLine);
+    log(isData, "Picked line %d to be evicted\n", newLine);
+    touchLine(cache, newLine);
+    if (cache[newLine].valid) countInSet(cache, cache[newLine].set, SET_EVICTIONS, 1);
+    if (cache[newLine].valid && cache[newLine].dirty) countInSet(cache, cache[newLine].set, SET_DIRTY_LINES, -1);
 
     // Evict the data to the lower level
     if (cache[newLine].valid && cache[newLine].dirty) {
@@ -394,6 +772,8 @@ double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isDat
         evictOp.address = getAddressFromTagAndSet(cache[newLine].tag, cache[newLine].set);
         evictOp.numWords = lineSizeWords;
         evictOp.operation = STORE;
+        evictOp.isData = isData;
+        evictOp.hasBreakPoint = false;
         evictOp.data = (uint64_t*) malloc(sizeof(uint64_t) * lineSizeWords);
         for (int i = 0; i < lineSizeWords; i++) {
             evictOp.data[i] = cache[newLine].content[i];
@@ -401,11 +781,12 @@ double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isDat
         evictRep.totalTime = 0.0;
 
         // Send the eviction as a STORE to the lower level
-        printf("L%u%c: Line %d is dirty and will be sent to the lower level\n", id + 1, (!isData && isSplit) ? 'I' : 'D', newLine);
+        log(isData, "Line %d is dirty and will be sent to the lower level\n", newLine);
         next->processRequest(&evictOp, &evictRep);
 
         // Update the stats
         time += evictRep.totalTime;
+        writebacks++;
 
         // Free the mem
         free(evictOp.data);
@@ -416,7 +797,7 @@ double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isDat
         cache[newLine].content[i] = newRep.data[i];
     }
 
-    cache[newLine].firstAccess = cycle;
+    cache[newLine].firstAccess = getStamp(cache, cache[newLine].set, cycle);
     cache[newLine].numberAccesses = 0;
     cache[newLine].tag = getTag(address);
     cache[newLine].dirty = false;
@@ -436,7 +817,7 @@ double Cache::fetchFromLowerLevel(CacheLine* cache, uint64_t address, bool isDat
 void Cache::processRequest(MemoryOperation* op, MemoryReply* rep) {
     CacheLine* cache;
 
-   if (debugLevel >= 1) printf("Debug: L%d, Address=%lu, Tag=%lu, Set=%u, Offset=%u\n", id + 1, op->address, getTag(op->address), getSet(op->address), getOffset(op->address));
+   if (debugLevel >= 1) printf("Debug: %s, Address=%lu, Tag=%lu, Set=%u, Offset=%u\n", label.c_str(), op->address, getTag(op->address), getSet(op->address), getOffset(op->address));
     
     // Update the stats
     rep->totalTime += accessTime;
@@ -451,29 +832,35 @@ void Cache::processRequest(MemoryOperation* op, MemoryReply* rep) {
     
     // First, check if the data is present in the cache
     int32_t line = searchAddress(cache, op->address);
+    if (line != -1) touchLine(cache, line);
 
     // For loads
     if (op->operation == LOAD) {
         // If it is present 
         if (line != -1) {
-            printf("L%u%c: Hit in line %d\n", id + 1, (!op->isData && isSplit) ? 'I' : 'D', line);
+            log(op->isData, "Hit in line %d\n", line);
             hits++;
-            cache[line].lineColor = COLOR_HIT;
+            countInSet(cache, cache[line].set, SET_HITS, 1);
+            rep->hitLevel = level;
+            classifyReference(op, false);
+            setStyle(&cache[line].lineColor, COLOR_HIT);
 
             // Reply with that data
             extractWordsFromLine(cache[line], op, rep);
         } else {
             // If it is not present
-            printf("L%u%c: Miss, fetching from lower level\n", id + 1, (!op->isData && isSplit) ? 'I' : 'D');
+            log(op->isData, "Miss, fetching from lower level\n");
             misses++;
+            countInSet(cache, getSet(op->address), SET_MISSES, 1);
+            classifyReference(op, true);
 
             // Query the lower level
-            rep->totalTime += fetchFromLowerLevel(cache, op->address, op->isData);
+            rep->totalTime += fetchFromLowerLevel(cache, op->address, op->isData, &rep->hitLevel);
 
             // Fetch the line again
             line = searchAddress(cache, op->address);
             assert(line != -1 && "The line should be found after being brought"); 
-            cache[line].lineColor = COLOR_MISS;
+            setStyle(&cache[line].lineColor, COLOR_MISS);
 
             // Reply with that data
             extractWordsFromLine(cache[line], op, rep);
@@ -484,43 +871,52 @@ void Cache::processRequest(MemoryOperation* op, MemoryReply* rep) {
         if (policyWrite == WRITE_THROUGH) {
             // Note it as a hit always
             hits++;
+            countInSet(cache, getSet(op->address), SET_HITS, 1);
             
             // If the data is present in the cache, store it but do not flag it as dirty
             if (line != -1) {
-                printf("L%u%c: Write-Through, updating already present data\n", id + 1, (!op->isData && isSplit) ? 'I' : 'D');
+                log(op->isData, "Write-Through, updating already present data\n");
+                classifyReference(op, false);
                 insertWordsInLine(cache[line], op);
-                cache[line].lineColor = COLOR_HIT;
+                setStyle(&cache[line].lineColor, COLOR_HIT);
             }
 
-            printf("L%u%c: Write-Through, sending store to lower level\n", id + 1, (!op->isData && isSplit) ? 'I' : 'D');
+            log(op->isData, "Write-Through, sending store to lower level\n");
 
             // Send it to the lower level (Reusing the reply, as no data will be stored on it)
             next->processRequest(op, rep);
+            if (line != -1) rep->hitLevel = level;
         } else if (policyWrite == WRITE_BACK) {
             // If the cache is WB
             // If the line is not present
             if (line == -1) {
                 misses++;
+                countInSet(cache, getSet(op->address), SET_MISSES, 1);
+                classifyReference(op, true);
 
                 // Query the lower level (Write-allocate)
-                printf("L%u%c: Write-Back allocate miss, fetching from lower level\n", id + 1, (!op->isData && isSplit) ? 'I' : 'D');
-                rep->totalTime += fetchFromLowerLevel(cache, op->address, op->data);
+                log(op->isData, "Write-Back allocate miss, fetching from lower level\n");
+                rep->totalTime += fetchFromLowerLevel(cache, op->address, op->isData, &rep->hitLevel);
 
                 // Search again for the address
                 line = searchAddress(cache, op->address);
                 assert(line != -1 && "The line should be found after being brought"); 
-                cache[line].lineColor = COLOR_MISS;
+                setStyle(&cache[line].lineColor, COLOR_MISS);
             } else {
                 hits++;
-                cache[line].lineColor = COLOR_HIT;
+                countInSet(cache, cache[line].set, SET_HITS, 1);
+                rep->hitLevel = level;
+                classifyReference(op, false);
+                setStyle(&cache[line].lineColor, COLOR_HIT);
             }
 
-            printf("L%u%c: Storing in line %d\n", id + 1,  (!op->isData && isSplit) ? 'I' : 'D', line);
+            log(op->isData, "Storing in line %d\n", line);
 
             // Store the data
             insertWordsInLine(cache[line], op);
             
             // Flag the line as dirty
+            if (!cache[line].dirty) countInSet(cache, cache[line].set, SET_DIRTY_LINES, 1);
             cache[line].dirty = true;
         } else {
             assert(0 && "Unsupported write policy type");
@@ -529,18 +925,94 @@ void Cache::processRequest(MemoryOperation* op, MemoryReply* rep) {
         assert(0 && "Unsupported operation type");
     }
 
-    // Update the line stats
-    cache[line].numberAccesses++;
-    cache[line].lastAccess = cycle;
+    // Update the line stats (Write-Through stores that miss do not allocate a line)
+    if (line != -1) {
+        if (cache[line].numberAccesses < CACHE_MAX_STAMP) cache[line].numberAccesses++;
+        cache[line].lastAccess = getStamp(cache, cache[line].set, cycle);
+    }
 }
 
 /**
- * Clears the style from all cache rows. 
+ * Serves the hits at the start of a batch of CPU operations in a single pass, without going through the whole request
+ * path. Loads and Write-Back stores that hit leave the cache as processRequest would, and the batch stops at the first
+ * miss or Write-Through store, as those need the lower levels in order. The hits reach the miss classifiers after the
+ * loop, in the same order.
+ * @param ops The operations.
+ * @param reps The replies, with the time set to 0.
+ * @param numOps The number of operations.
+ * @return uint32_t The number of operations served.
  */
-void Cache::clearStyle() {
-    for (int i = 0; i < (isSplit ? 2 : 1); i++) {
-        for (int j = 0; j < lines; j++) {
-            caches[i][j].lineColor = COLOR_NONE;
+uint32_t Cache::processBatch(MemoryOperation** ops, MemoryReply* reps, uint32_t numOps) {
+    // The journal and the console output need the whole path
+    if (journal != nullptr || !quiet || debugLevel >= 1) {
+        return 0;
+    }
+
+    uint32_t served;
+    for (served = 0; served < numOps; served++) {
+        MemoryOperation* op = ops[served];
+        MemoryReply* rep = &reps[served];
+        CacheLine* cache = (isSplit && !op->isData) ? caches[INST_CACHE] : caches[DATA_CACHE];
+
+        if (op->operation == STORE && policyWrite != WRITE_BACK) {
+            break;
         }
+
+        int32_t line = searchAddress(cache, op->address);
+        if (line == -1) {
+            break;
+        }
+
+        touchLine(cache, line);
+        rep->totalTime += accessTime;
+        rep->hitLevel = level;
+        accesses++;
+        hits++;
+        countInSet(cache, cache[line].set, SET_HITS, 1);
+        batchHits[(isSplit && !op->isData) ? INST_CACHE : DATA_CACHE].push_back(op->address >> offsetBits);
+        setStyle(&cache[line].lineColor, COLOR_HIT);
+
+        if (op->operation == LOAD) {
+            extractWordsFromLine(cache[line], op, rep);
+        } else {
+            insertWordsInLine(cache[line], op);
+            if (!cache[line].dirty) countInSet(cache, cache[line].set, SET_DIRTY_LINES, 1);
+            cache[line].dirty = true;
+        }
+
+        if (cache[line].numberAccesses < CACHE_MAX_STAMP) cache[line].numberAccesses++;
+        cache[line].lastAccess = getStamp(cache, cache[line].set, cycle + served);
+    }
+
+    // The shadow structures of the classifiers are maps, so they are kept out of the loop. Each side only sees its own
+    // references, which keep their order
+    for (int i = 0; i < NUM_CACHE_TYPES; i++) {
+        if (!batchHits[i].empty()) {
+            classifiers[i]->referenceHits(batchHits[i].data(), batchHits[i].size());
+            batchHits[i].clear();
+        }
+    }
+
+    return served;
+}
+
+/**
+ * Registers the statistics of the cache as lN.*, with the three C classification of the misses of each side as lN.d.* and lN.i.*
+ * @param stats The registry.
+ */
+void Cache::registerStats(StatsRegistry* stats) {
+    const char* missNames[NUM_MISS_TYPES] = {"compulsory", "capacity", "conflict"};
+    std::string prefix = name;
+
+    stats->add(prefix + ".accesses", &accesses);
+    stats->add(prefix + ".hits", &hits);
+    stats->add(prefix + ".misses", &misses);
+    stats->add(prefix + ".writebacks", &writebacks);
+
+    for (int i = 0; i < NUM_MISS_TYPES; i++) {
+        stats->add(prefix + ".d.misses." + missNames[i], &missesByType[DATA_CACHE][i]);
+    }
+    for (int i = 0; i < NUM_MISS_TYPES; i++) {
+        stats->add(prefix + ".i.misses." + missNames[i], &missesByType[INST_CACHE][i]);
     }
 }
\ No newline at end of file
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "CompressedTrace.h"
+
+/**
+ * Appends an unsigned integer to a stream as a varint: 7 bits per Byte, with the highest bit set in all Bytes but the last.
+ * @param stream The stream.
+ * @param value The integer.
+ */
+void putVarint(std::vector<uint8_t>& stream, uint64_t value) {
+    while (value >= 0x80) {
+        stream.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    stream.push_back(value);
+}
+
+/**
+ * Reads a varint from a stream.
+ * @param cursor The position in the stream. It is moved past the varint.
+ * @param end The end of the stream.
+ * @param value Returns the integer.
+ * @return int 0 if Ok, -1 if the stream ends in the middle of the varint.
+ */
+int getVarint(const uint8_t** cursor, const uint8_t* end, uint64_t* value) {
+    uint64_t result = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*cursor >= end) {
+            return -1;
+        }
+
+        uint8_t byte = *(*cursor)++;
+        result |= (uint64_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Maps a signed delta to an unsigned integer so that small deltas of either sign get short varints.
+ */
+uint64_t zigzag(uint64_t delta) {
+    return (delta << 1) ^ (uint64_t) ((int64_t) delta >> 63);
+}
+
+/**
+ * Inverse of zigzag.
+ */
+uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+/**
+ * Checks if a file is a compressed trace.
+ * @param path Path to the file.
+ * @return true If the file starts like a compressed trace.
+ */
+bool isCompressedTrace(const char* path) {
+    char magic[8];
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return false;
+    }
+
+    bool result = fread(magic, 1, 8, file) == 8 && memcmp(magic, TRACE_MAGIC, 8) == 0;
+    fclose(file);
+
+    return result;
+}
+
+CompressedTraceWriter::CompressedTraceWriter() {
+    file = NULL;
+}
+
+CompressedTraceWriter::~CompressedTraceWriter() {
+    if (file != NULL) {
+        close();
+    }
+}
+
+/**
+ * Creates a compressed trace.
+ * @param path Path to the file. It will be overwritten.
+ * @param blockOps Operations per block.
+ * @return int 0 if Ok, -1 if the file could not be created.
+ */
+int CompressedTraceWriter::open(const char* path, uint32_t blockOps) {
+    file = fopen(path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Trace Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(TraceHeader));
+    memcpy(header.magic, TRACE_MAGIC, 8);
+    header.version = TRACE_VERSION;
+    header.blockOps = blockOps;
+
+    index.clear();
+    pending.clear();
+    pending.reserve(blockOps);
+
+    // The header gets rewritten with the final counts on close
+    fwrite(&header, sizeof(TraceHeader), 1, file);
+
+    return 0;
+}
+
+/**
+ * Adds an operation at the end of the trace. Only the first word of the data of a store is kept, as in text traces.
+ * @param op The operation.
+ */
+void CompressedTraceWriter::append(const MemoryOperation* op) {
+    TraceRecord record;
+
+    record.address = op->address;
+    record.flags = 0;
+    record.data = 0;
+
+    if (op->operation == STORE) {
+        record.flags |= TRACE_FLAG_STORE;
+        record.data = (op->data != nullptr) ? op->data[0] : 0;
+    }
+    if (op->isData) record.flags |= TRACE_FLAG_DATA;
+    if (op->hasBreakPoint) record.flags |= TRACE_FLAG_BREAKPOINT;
+
+    pending.push_back(record);
+    if (pending.size() == header.blockOps) {
+        writeBlock();
+    }
+}
+
+/**
+ * Encodes the pending operations as a block and writes it.
+ */
+void CompressedTraceWriter::writeBlock() {
+    uint32_t numOps = pending.size();
+    uint32_t bitBytes = (numOps + 7) / 8;
+    std::vector<uint8_t> flags(3 * bitBytes, 0);
+    std::vector<uint8_t> addresses, data;
+    uint64_t previous[2] = {0, 0};      // Last address of each side, instructions and data follow separate patterns
+
+    for (uint32_t i = 0; i < numOps; i++) {
+        TraceRecord* record = &pending[i];
+        int side = (record->flags & TRACE_FLAG_DATA) ? 1 : 0;
+
+        if (record->flags & TRACE_FLAG_STORE) flags[i / 8] |= 1 << (i % 8);
+        if (record->flags & TRACE_FLAG_DATA) flags[bitBytes + i / 8] |= 1 << (i % 8);
+        if (record->flags & TRACE_FLAG_BREAKPOINT) flags[2 * bitBytes + i / 8] |= 1 << (i % 8);
+
+        putVarint(addresses, zigzag(record->address - previous[side]));
+        previous[side] = record->address;
+
+        if (record->flags & TRACE_FLAG_STORE) {
+            putVarint(data, record->data);
+        }
+    }
+
+    TraceBlockHeader blockHeader = {numOps, (uint32_t) flags.size(), (uint32_t) addresses.size(), (uint32_t) data.size()};
+    TraceIndexEntry entry;
+    entry.offset = ftello(file);
+    entry.size = sizeof(TraceBlockHeader) + flags.size() + addresses.size() + data.size();
+
+    fwrite(&blockHeader, sizeof(TraceBlockHeader), 1, file);
+    fwrite(flags.data(), 1, flags.size(), file);
+    fwrite(addresses.data(), 1, addresses.size(), file);
+    fwrite(data.data(), 1, data.size(), file);
+
+    index.push_back(entry);
+    header.numOps += numOps;
+    pending.clear();
+}
+
+/**
+ * Writes the last block, the index and the final header, and closes the file.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int CompressedTraceWriter::close() {
+    if (!pending.empty()) {
+        writeBlock();
+    }
+
+    header.numBlocks = index.size();
+    header.indexOffset = ftello(file);
+    fwrite(index.data(), sizeof(TraceIndexEntry), index.size(), file);
+
+    fseeko(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(TraceHeader), 1, file);
+
+    int result = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0 || result != 0) {
+        fprintf(stderr, "Trace Error: Failed writing the compressed trace\n");
+        result = -1;
+    }
+    file = NULL;
+
+    return result;
+}
+
+CompressedTraceReader::CompressedTraceReader() {
+    fd = -1;
+    memset(&header, 0, sizeof(TraceHeader));
+    numWorkers = 0;
+    current = 0;
+    position = 0;
+    slot = nullptr;
+    failed = false;
+    nextToDecode = 0;
+    stopping = false;
+}
+
+CompressedTraceReader::~CompressedTraceReader() {
+    close();
+}
+
+/**
+ * Opens a compressed trace and starts decoding it.
+ * @param path Path to the file.
+ * @param threads Number of worker threads that decode blocks ahead of the consumer. 0 decodes them on demand.
+ * @return int 0 if Ok, -2 if the file is not a valid compressed trace.
+ */
+int CompressedTraceReader::open(const char* path, uint32_t threads) {
+    fd = ::open(path, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "Trace Error: Cannot open file %s\n", path);
+        return -2;
+    }
+
+    if (pread(fd, &header, sizeof(TraceHeader), 0) != sizeof(TraceHeader) || memcmp(header.magic, TRACE_MAGIC, 8) != 0) {
+        fprintf(stderr, "Trace Error: %s is not a compressed trace\n", path);
+        close();
+        return -2;
+    }
+
+    if (header.version != TRACE_VERSION) {
+        fprintf(stderr, "Trace Error: %s has version %u, expected %u\n", path, header.version, TRACE_VERSION);
+        close();
+        return -2;
+    }
+
+    index.resize(header.numBlocks);
+    size_t indexSize = sizeof(TraceIndexEntry) * header.numBlocks;
+    if (pread(fd, index.data(), indexSize, header.indexOffset) != (ssize_t) indexSize) {
+        fprintf(stderr, "Trace Error: %s is truncated\n", path);
+        close();
+        return -2;
+    }
+
+    numWorkers = std::min<uint32_t>(threads, TRACE_MAX_WORKERS);
+    slots.resize((numWorkers > 0) ? numWorkers * TRACE_READ_AHEAD : 1);
+
+    rewind();
+    return 0;
+}
+
+/**
+ * Stops the workers and closes the file.
+ */
+void CompressedTraceReader::close() {
+    stopWorkers();
+
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+/**
+ * Reads and decodes a block. Safe to call from several threads at once for different slots.
+ * @param block The block.
+ * @param target The slot the operations are decoded into.
+ * @return int 0 if Ok, -1 if the block could not be read or is corrupted.
+ */
+int CompressedTraceReader::readBlock(uint64_t block, TraceSlot* target) {
+    TraceIndexEntry* entry = &index[block];
+    TraceBlockHeader blockHeader;
+    std::vector<uint8_t> bytes(entry->size);
+
+    if (entry->size < sizeof(TraceBlockHeader) || pread(fd, bytes.data(), entry->size, entry->offset) != (ssize_t) entry->size) {
+        return -1;
+    }
+
+    memcpy(&blockHeader, bytes.data(), sizeof(TraceBlockHeader));
+    uint32_t numOps = blockHeader.numOps;
+    uint32_t bitBytes = (numOps + 7) / 8;
+
+    if (blockHeader.flagBytes != 3 * bitBytes ||
+        sizeof(TraceBlockHeader) + (uint64_t) blockHeader.flagBytes + blockHeader.addressBytes + blockHeader.dataBytes != entry->size) {
+        return -1;
+    }
+
+    const uint8_t* flags = bytes.data() + sizeof(TraceBlockHeader);
+    const uint8_t* addresses = flags + blockHeader.flagBytes;
+    const uint8_t* addressesEnd = addresses + blockHeader.addressBytes;
+    const uint8_t* data = addressesEnd;
+    const uint8_t* dataEnd = data + blockHeader.dataBytes;
+    uint64_t previous[2] = {0, 0};
+
+    target->records.resize(numOps);
+    for (uint32_t i = 0; i < numOps; i++) {
+        TraceRecord* record = &target->records[i];
+        uint64_t delta;
+        uint8_t bit = 1 << (i % 8);
+
+        record->flags = 0;
+        if (flags[i / 8] & bit) record->flags |= TRACE_FLAG_STORE;
+        if (flags[bitBytes + i / 8] & bit) record->flags |= TRACE_FLAG_DATA;
+        if (flags[2 * bitBytes + i / 8] & bit) record->flags |= TRACE_FLAG_BREAKPOINT;
+
+        int side = (record->flags & TRACE_FLAG_DATA) ? 1 : 0;
+        if (getVarint(&addresses, addressesEnd, &delta) != 0) {
+            return -1;
+        }
+        record->address = previous[side] + unzigzag(delta);
+        previous[side] = record->address;
+
+        record->data = 0;
+        if ((record->flags & TRACE_FLAG_STORE) && getVarint(&data, dataEnd, &record->data) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Body of a worker: decodes the next block that is not taken yet, as long as it fits in the read-ahead window.
+ */
+void CompressedTraceReader::work() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true) {
+        changed.wait(guard, [this] {
+            return stopping || (nextToDecode < header.numBlocks && nextToDecode < current + slots.size());
+        });
+
+        if (stopping) {
+            return;
+        }
+
+        // The slot belonged to a block that the consumer has already finished
+        uint64_t block = nextToDecode++;
+        TraceSlot* target = &slots[block % slots.size()];
+
+        guard.unlock();
+        target->status = readBlock(block, target);
+        guard.lock();
+
+        target->block = block;
+        changed.notify_all();
+    }
+}
+
+/**
+ * Starts the workers from the current position.
+ */
+void CompressedTraceReader::startWorkers() {
+    stopping = false;
+    for (uint32_t i = 0; i < numWorkers; i++) {
+        workers.emplace_back(&CompressedTraceReader::work, this);
+    }
+}
+
+/**
+ * Stops the workers, waiting for the blocks they are decoding.
+ */
+void CompressedTraceReader::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+/**
+ * Gets a decoded block, waiting for the workers if it is not ready yet.
+ * @param block The block.
+ * @return TraceSlot* The slot that holds it.
+ */
+TraceSlot* CompressedTraceReader::waitForBlock(uint64_t block) {
+    TraceSlot* target = &slots[block % slots.size()];
+
+    // Without workers, decode it right away
+    if (numWorkers == 0) {
+        target->status = readBlock(block, target);
+        target->block = block;
+        return target;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [target, block] {
+        return target->block == block;
+    });
+
+    return target;
+}
+
+/**
+ * Produces the next operation of the trace.
+ * @param op The operation to fill. Its data pointer must point to storage for at least one word.
+ * @return true If an operation was produced, false if the trace has ended or a block is corrupted.
+ */
+bool CompressedTraceReader::next(MemoryOperation* op) {
+    if (failed) {
+        return false;
+    }
+
+    while (slot == nullptr || position >= slot->records.size()) {
+        // Release the finished block so that its slot can be reused
+        if (slot != nullptr) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                current++;
+            }
+            changed.notify_all();
+            slot = nullptr;
+            position = 0;
+        }
+
+        if (current >= header.numBlocks) {
+            return false;
+        }
+
+        slot = waitForBlock(current);
+        if (slot->status != 0) {
+            fprintf(stderr, "Trace Error: Block %lu of the compressed trace is corrupted\n", current);
+            failed = true;
+            return false;
+        }
+    }
+
+    TraceRecord* record = &slot->records[position++];
+    op->address = record->address;
+    op->numWords = 1;
+    op->operation = (record->flags & TRACE_FLAG_STORE) ? STORE : LOAD;
+    op->isData = (record->flags & TRACE_FLAG_DATA) != 0;
+    op->hasBreakPoint = (record->flags & TRACE_FLAG_BREAKPOINT) != 0;
+    if (op->operation == STORE) {
+        op->data[0] = record->data;
+    }
+
+    return true;
+}
+
+/**
+ * Restarts the trace from its first operation.
+ */
+void CompressedTraceReader::rewind() {
+    stopWorkers();
+
+    current = 0;
+    position = 0;
+    slot = nullptr;
+    failed = false;
+    nextToDecode = 0;
+    for (TraceSlot& s : slots) {
+        s.block = UINT64_MAX;
+    }
+
+    startWorkers();
+}
+
+/**
+ * Returns the number of operations of the trace.
+ * @return uint64_t The number of operations.
+ */
+uint64_t CompressedTraceReader::getNumOps() {
+    return header.numOps;
+}
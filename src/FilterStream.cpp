@@ -0,0 +1,370 @@
+#include <algorithm>
+
+#include "FilterStream.h"
+#include "CompressedTrace.h"
+
+// Upper bound of the Bytes of a request, besides its data: flags, cycles, address and number of words
+#define FILTER_MAX_REQUEST_HEADER 31
+
+/**
+ * Summarises the configuration of the levels above a level, which determines the requests that reach it. Access times
+ * do not change the requests, so they are left out.
+ * @param sc The configuration.
+ * @param level The level, 1 for L1.
+ * @return uint64_t The fingerprint.
+ */
+uint64_t filterFingerprint(SimulatorConfig* sc, uint32_t level) {
+    uint64_t hash = 0xCBF29CE484222325;      // FNV-1a
+    bool random = false;
+
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (value >> (8 * i)) & 0xFF;
+            hash *= 0x100000001B3;
+        }
+    };
+
+    mix(sc->cpuWordWidth);
+    mix(level);
+    for (uint32_t i = 0; i + 1 < level && i < sc->miscCacheLevels; i++) {
+        mix(sc->cacheSize[i]);
+        mix(sc->cacheLineSize[i]);
+        mix(sc->cacheAssoc[i]);
+        mix(sc->cacheIsSplit[i]);
+        mix(sc->cachePolicyWrite[i]);
+        mix(sc->cachePolicyReplacement[i]);
+        random |= sc->cachePolicyReplacement[i] == RAND;
+    }
+
+    // Random replacements depend on the seed
+    if (random) {
+        mix(sc->cpuRandSeed);
+    }
+
+    return hash;
+}
+
+FilterRecorder::FilterRecorder() {
+    file = NULL;
+    memset(&header, 0, sizeof(FilterHeader));
+}
+
+FilterRecorder::~FilterRecorder() {
+    if (file != NULL) {
+        close(cycle, 0);
+    }
+}
+
+/**
+ * Creates a filter stream for the requests sent to a level.
+ * @param path Path to the file. It will be overwritten.
+ * @param sc The configuration of the simulation.
+ * @param level The level whose requests are recorded, 1 for L1. One past the last cache for the memory.
+ * @return int 0 if Ok, -1 if the file could not be created.
+ */
+int FilterRecorder::open(const char* path, SimulatorConfig* sc, uint32_t level) {
+    file = fopen(path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Filter Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    memcpy(header.magic, FILTER_MAGIC, 8);
+    header.version = FILTER_VERSION;
+    header.level = level;
+    header.wordWidth = sc->cpuWordWidth / 8;
+    header.fingerprint = filterFingerprint(sc, level);
+    header.numRequests = 0;
+    header.numCycles = 0;
+    header.warmupCycles = 0;
+
+    // Requests are either single words from the CPU or lines of the levels above
+    header.maxWords = 1;
+    for (uint32_t i = 0; i + 1 < level && i < sc->miscCacheLevels; i++) {
+        header.maxWords = std::max<uint32_t>(header.maxWords, sc->cacheLineSize[i] / header.wordWidth);
+    }
+
+    previous[0] = previous[1] = 0;
+    previousCycle = 0;
+    buffer.clear();
+    buffer.reserve(FILTER_BUFFER_SIZE);
+
+    // The header gets rewritten with the final counts on close
+    fwrite(&header, sizeof(FilterHeader), 1, file);
+
+    return 0;
+}
+
+/**
+ * Writes the pending requests and the final header, and closes the file.
+ * @param numCycles Operations of the trace that was simulated.
+ * @param warmupCycles Operations of the trace that warmed up the hierarchy.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int FilterRecorder::close(uint64_t numCycles, uint64_t warmupCycles) {
+    header.numCycles = numCycles;
+    header.warmupCycles = warmupCycles;
+
+    fwrite(buffer.data(), 1, buffer.size(), file);
+    buffer.clear();
+
+    fseeko(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(FilterHeader), 1, file);
+
+    int result = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0 || result != 0) {
+        fprintf(stderr, "Filter Error: Failed writing the filter stream\n");
+        result = -1;
+    }
+    file = NULL;
+
+    return result;
+}
+
+/**
+ * Returns the level whose requests are recorded.
+ * @return uint32_t The level, 1 for L1.
+ */
+uint32_t FilterRecorder::getLevel() {
+    return header.level;
+}
+
+/**
+ * Records a request and passes it on to the level behind.
+ * @param op The request.
+ * @param rep The reply, filled by the level behind.
+ */
+void FilterRecorder::processRequest(MemoryOperation* op, MemoryReply* rep) {
+    int side = op->isData ? 1 : 0;
+    uint8_t flags = 0;
+
+    if (op->operation == STORE) flags |= FILTER_FLAG_STORE;
+    if (op->isData) flags |= FILTER_FLAG_DATA;
+
+    // Caches timestamp their lines with the cycle, so the replay has to keep the requests in the same cycles
+    buffer.push_back(flags);
+    putVarint(buffer, cycle - previousCycle);
+    putVarint(buffer, zigzag(op->address - previous[side]));
+    putVarint(buffer, op->numWords);
+    previous[side] = op->address;
+    previousCycle = cycle;
+
+    if (op->operation == STORE) {
+        for (uint64_t i = 0; i < op->numWords; i++) {
+            putVarint(buffer, op->data[i]);
+        }
+    }
+
+    if (buffer.size() >= FILTER_BUFFER_SIZE) {
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+
+    header.numRequests++;
+
+    next->processRequest(op, rep);
+}
+
+FilterReader::FilterReader() {
+    file = NULL;
+    memset(&header, 0, sizeof(FilterHeader));
+    cursor = end = 0;
+    aheadCycle = UINT64_MAX;
+}
+
+FilterReader::~FilterReader() {
+    close();
+}
+
+/**
+ * Opens a filter stream to replay it.
+ * @param path Path to the file.
+ * @return int 0 if Ok, -2 if the file is not a valid filter stream.
+ */
+int FilterReader::open(const char* path) {
+    file = fopen(path, "rb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Filter Error: Cannot open file %s\n", path);
+        return -2;
+    }
+
+    if (fread(&header, sizeof(FilterHeader), 1, file) != 1 || memcmp(header.magic, FILTER_MAGIC, 8) != 0) {
+        fprintf(stderr, "Filter Error: %s is not a filter stream\n", path);
+        close();
+        return -2;
+    }
+
+    if (header.version != FILTER_VERSION) {
+        fprintf(stderr, "Filter Error: %s has version %u, expected %u\n", path, header.version, FILTER_VERSION);
+        close();
+        return -2;
+    }
+
+    buffer.resize(FILTER_BUFFER_SIZE);
+    aheadData.resize(header.maxWords);
+    ahead.data = aheadData.data();
+    rewind();
+    return 0;
+}
+
+/**
+ * Closes the file.
+ */
+void FilterReader::close() {
+    if (file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+/**
+ * Returns the level the requests were sent to.
+ * @return uint32_t The level, 1 for L1.
+ */
+uint32_t FilterReader::getLevel() {
+    return header.level;
+}
+
+/**
+ * Returns the number of words of the longest request.
+ * @return uint32_t The number of words.
+ */
+uint32_t FilterReader::getMaxWords() {
+    return header.maxWords;
+}
+
+/**
+ * Returns the fingerprint of the configuration the stream was recorded with.
+ * @return uint64_t The fingerprint, as computed by filterFingerprint.
+ */
+uint64_t FilterReader::getFingerprint() {
+    return header.fingerprint;
+}
+
+/**
+ * Returns the number of operations of the trace the requests were recorded from.
+ * @return uint64_t The number of operations, which the replay steps through.
+ */
+uint64_t FilterReader::getNumCycles() {
+    return header.numCycles;
+}
+
+/**
+ * Returns the number of operations of the trace that warmed up the hierarchy.
+ * @return uint64_t The number of operations, at the start of the trace.
+ */
+uint64_t FilterReader::getWarmupCycles() {
+    return header.warmupCycles;
+}
+
+/**
+ * Returns the cycle of the next request.
+ * @return uint64_t The cycle, UINT64_MAX if the stream has ended.
+ */
+uint64_t FilterReader::getNextCycle() {
+    return aheadCycle;
+}
+
+/**
+ * Moves the unread Bytes to the start of the buffer and fills the rest from the file.
+ */
+void FilterReader::refill() {
+    memmove(buffer.data(), buffer.data() + cursor, end - cursor);
+    end -= cursor;
+    cursor = 0;
+    end += fread(buffer.data() + end, 1, buffer.size() - end, file);
+}
+
+/**
+ * Decodes the request that follows into ahead.
+ */
+void FilterReader::decodeAhead() {
+    uint64_t cycles, delta, numWords;
+
+    // Make sure that the whole request is buffered
+    if (end - cursor < FILTER_MAX_REQUEST_HEADER + 10 * (size_t) header.maxWords) {
+        refill();
+    }
+    if (cursor >= end) {
+        aheadCycle = UINT64_MAX;
+        return;
+    }
+
+    const uint8_t* position = buffer.data() + cursor;
+    const uint8_t* limit = buffer.data() + end;
+    uint8_t flags = *position++;
+    int side = (flags & FILTER_FLAG_DATA) ? 1 : 0;
+
+    if (getVarint(&position, limit, &cycles) != 0 || getVarint(&position, limit, &delta) != 0 ||
+        getVarint(&position, limit, &numWords) != 0 || numWords == 0 || numWords > header.maxWords) {
+        fprintf(stderr, "Filter Error: The filter stream is corrupted\n");
+        aheadCycle = UINT64_MAX;
+        return;
+    }
+
+    ahead.address = previous[side] + unzigzag(delta);
+    ahead.numWords = numWords;
+    ahead.operation = (flags & FILTER_FLAG_STORE) ? STORE : LOAD;
+    ahead.isData = (flags & FILTER_FLAG_DATA) != 0;
+    ahead.hasBreakPoint = false;
+    previous[side] = ahead.address;
+    aheadCycle += cycles;
+
+    if (ahead.operation == STORE) {
+        for (uint64_t i = 0; i < numWords; i++) {
+            if (getVarint(&position, limit, &ahead.data[i]) != 0) {
+                fprintf(stderr, "Filter Error: The filter stream is corrupted\n");
+                aheadCycle = UINT64_MAX;
+                return;
+            }
+        }
+    }
+
+    cursor = position - buffer.data();
+}
+
+/**
+ * Produces the next request of the stream.
+ * @param op The operation to fill. Its data pointer must point to storage for at least getMaxWords() words.
+ * @return true If a request was produced, false if the stream has ended or is corrupted.
+ */
+bool FilterReader::next(MemoryOperation* op) {
+    if (aheadCycle == UINT64_MAX) {
+        return false;
+    }
+
+    uint64_t* data = op->data;
+    *op = ahead;
+    op->data = data;
+    if (op->operation == STORE) {
+        memcpy(op->data, ahead.data, sizeof(uint64_t) * ahead.numWords);
+    }
+
+    decodeAhead();
+    return true;
+}
+
+/**
+ * Restarts the stream from its first request.
+ */
+void FilterReader::rewind() {
+    cursor = end = 0;
+    previous[0] = previous[1] = 0;
+    aheadCycle = UINT64_MAX;
+
+    if (file != NULL) {
+        fseeko(file, sizeof(FilterHeader), SEEK_SET);
+        aheadCycle = 0;
+        decodeAhead();
+    }
+}
+
+/**
+ * Returns the number of requests of the stream.
+ * @return uint64_t The number of requests.
+ */
+uint64_t FilterReader::getNumOps() {
+    return header.numRequests;
+}
@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+
 #include "GUI.h"
 #include "Logo.cpp"
 
@@ -12,6 +17,14 @@ ImVec4 colorVec[NUM_COLOR_NAMES] = {
     ImVec4(0.0f, 0.0f, 0.0f, 0.0f)      // COLOR_NONE
 };
 
+// Color of the heatmaps of each set counter
+ColorNames heatmapColors[NUM_SET_COUNTERS] = {
+    COLOR_HIT,          // SET_HITS
+    COLOR_MISS,         // SET_MISSES
+    COLOR_STORE_FIRST,  // SET_EVICTIONS
+    COLOR_LOAD_FIRST    // SET_DIRTY_LINES
+};
+
 GUI::GUI () {
     // Setup SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
@@ -43,9 +56,24 @@ GUI::GUI () {
     // Init the scroll variables
     scrolledInstructions = false;
     scrolledMemory = false;
-    for (int i = 0; i < MAX_CACHE_LEVELS; i++) {
-        scrolledCache[i] = false;
-    }
+
+    // The view of the caches is picked on the first frame, from their sizes
+    cacheView = -1;
+    heatmapCounter = SET_MISSES;
+
+    // The first conditional breakpoint is offered on the misses of any cache
+    memset(&newBreakpoint, 0, sizeof(Breakpoint));
+    newBreakpoint.condition = BREAK_MISS;
+    newBreakpoint.cache = -1;
+    breakpointError = false;
+
+    // No simulation runs in the background yet
+    workerPaused = false;
+    workerCancel = false;
+    workerDone = false;
+    renderWaiting = false;
+    workerOps = 0;
+    workerSeconds = 0.0;
 
     ImGui_ImplSDL2_InitForOpenGL(window, gl_context);
     ImGui_ImplOpenGL3_Init(glsl_version);
@@ -54,6 +82,12 @@ GUI::GUI () {
 }
 
 GUI::~GUI () {
+    stopWorker();
+
+    for (CacheTableView& view : cacheTables) {
+        if (view.texture != 0) glDeleteTextures(1, &view.texture);
+    }
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
@@ -117,9 +151,32 @@ void GUI::centerNextItem(float itemWidth) {
     if (pos > 0.0f) ImGui::SetCursorPosX(ImGui::GetCursorPosX() + pos);
 }
 
-void GUI::drawCacheTable(CacheLine* cache, uint8_t id, uint32_t lineSizeWords, uint32_t numLines, char* label) {
+/**
+ * Draws the lines of a cache as a table. Only the rows in view are drawn, and the content of each line is only formatted
+ * again when the line changes, so that the cost of a frame does not grow with the size of the cache.
+ * @param cache The lines of the cache.
+ * @param setBases The cycle the timestamps of each set are relative to.
+ * @param view The table, with the text of the lines of previous frames.
+ * @param lineSizeWords The words of each line.
+ * @param numLines The number of lines.
+ * @param label The title of the table.
+ */
+void GUI::drawCacheTable(CacheLine* cache, const uint64_t* setBases, CacheTableView* view, uint32_t lineSizeWords, uint32_t numLines, char* label) {
     ImGui::Text("%s\n", label);
 
+    if (view->lines.size() != numLines) {
+        view->lines.assign(numLines, LineText());
+    }
+
+    // Find the styled line, which has to be drawn even if it is out of view to scroll to it
+    int32_t target = -1;
+    if (!view->scrolled) {
+        for (uint32_t i = 0; i < numLines && target == -1; i++) {
+            if (cache[i].lineColor != COLOR_NONE) target = i;
+        }
+        view->scrolled = true;
+    }
+
     // Display the instruction cache 
     if (ImGui::BeginTable(label, 10, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit, ImVec2(0.0f, 0.0f))) {
         ImGui::TableSetupColumn("L");
@@ -134,32 +191,46 @@ void GUI::drawCacheTable(CacheLine* cache, uint8_t id, uint32_t lineSizeWords, u
         ImGui::TableSetupColumn("Content");
         ImGui::TableHeadersRow();
 
-        for (int i = 0; i < numLines; i++) {
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0); ImGui::Text("%d", i);
-            ImGui::TableSetColumnIndex(1); ImGui::Text("%u", cache[i].set);
-            ImGui::TableSetColumnIndex(2); ImGui::Text("%u", cache[i].way);
-            ImGui::TableSetColumnIndex(3); ImGui::Text("%u", cache[i].dirty);
-            ImGui::TableSetColumnIndex(4); ImGui::Text("%u", cache[i].valid);
-            ImGui::TableSetColumnIndex(5); (cache[i].firstAccess == -1) ? ImGui::Text("-") : ImGui::Text("%u", cache[i].firstAccess);
-            ImGui::TableSetColumnIndex(6); (cache[i].lastAccess == -1) ? ImGui::Text("-") : ImGui::Text("%u", cache[i].lastAccess);
-            ImGui::TableSetColumnIndex(7); (cache[i].numberAccesses == -1) ? ImGui::Text("-") : ImGui::Text("%u", cache[i].numberAccesses);
-            ImGui::TableSetColumnIndex(8); (!cache[i].valid) ? ImGui::Text("-") : ImGui::Text("0x%lX", cache[i].tag);
-            ImGui::TableSetColumnIndex(9);
-
-            for (int j = 0; j < lineSizeWords; j++) {
-                ImGui::Text("%lu ", cache[i].content[j]);
-                ImGui::SameLine();
-            }
+        ImGuiListClipper clipper;
+        clipper.Begin(numLines);
+        if (target != -1) clipper.IncludeItemByIndex(target);
+
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                LineText* text = &view->lines[i];
+
+                // Format the content words once per change of the line
+                if (!text->formatted || text->version != cache[i].version) {
+                    char word[24];
+                    text->content.clear();
+                    for (uint32_t j = 0; j < lineSizeWords; j++) {
+                        snprintf(word, sizeof(word), "%lu ", cache[i].content[j]);
+                        text->content += word;
+                    }
+                    text->version = cache[i].version;
+                    text->formatted = true;
+                }
 
-            // Apply color to the row if it has some style
-            if (cache[i].lineColor != COLOR_NONE) {
-                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(colorVec[cache[i].lineColor]));
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("%d", i);
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%u", cache[i].set);
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%u", cache[i].way);
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%u", cache[i].dirty);
+                ImGui::TableSetColumnIndex(4); ImGui::Text("%u", cache[i].valid);
+                ImGui::TableSetColumnIndex(5); (cache[i].firstAccess == -1) ? ImGui::Text("-") : ImGui::Text("%lu", setBases[cache[i].set] + cache[i].firstAccess);
+                ImGui::TableSetColumnIndex(6); (cache[i].lastAccess == -1) ? ImGui::Text("-") : ImGui::Text("%lu", setBases[cache[i].set] + cache[i].lastAccess);
+                ImGui::TableSetColumnIndex(7); (cache[i].numberAccesses == -1) ? ImGui::Text("-") : ImGui::Text("%d", cache[i].numberAccesses);
+                ImGui::TableSetColumnIndex(8); (!cache[i].valid) ? ImGui::Text("-") : ImGui::Text("0x%lX", cache[i].tag);
+                ImGui::TableSetColumnIndex(9); ImGui::TextUnformatted(text->content.c_str(), text->content.c_str() + text->content.size());
+
+                // Apply color to the row if it has some style
+                if (cache[i].lineColor != COLOR_NONE) {
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(colorVec[cache[i].lineColor]));
+                }
 
-                // Scroll to that row once per cycle
-                if (!scrolledCache[id]) {
+                // Scroll to the styled row once per cycle
+                if (i == target) {
                     ImGui::SetScrollHereY(0.5f);
-                    scrolledCache[id] = true;
                 }
             }
         }
@@ -168,13 +239,87 @@ void GUI::drawCacheTable(CacheLine* cache, uint8_t id, uint32_t lineSizeWords, u
     }
 }
 
+/**
+ * Draws a counter of every set of a cache as a heatmap, one texel per set, on a logarithmic scale. The texture is only
+ * drawn again when the cycle changes, from the counters the cache keeps for each set, so the lines are never scanned.
+ * @param setCounters The counters of each set, NUM_SET_COUNTERS per set.
+ * @param numSets The number of sets. A power of 2.
+ * @param view The table, with the texture of previous frames.
+ * @param label The title of the heatmap.
+ */
+void GUI::drawSetHeatmap(const uint64_t* setCounters, uint32_t numSets, CacheTableView* view, char* label) {
+    ImGui::Text("%s\n", label);
+
+    // Lay the sets out in rows, as square as possible
+    uint32_t bits = log2(numSets);
+    uint32_t width = 1 << ((bits + 1) / 2);
+    uint32_t height = numSets / width;
+
+    if (view->texture == 0 || view->textureWidth != width || view->textureHeight != height) {
+        if (view->texture == 0) glGenTextures(1, &view->texture);
+        glBindTexture(GL_TEXTURE_2D, view->texture);
+
+        // Every set is a sharp block
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        view->textureWidth = width;
+        view->textureHeight = height;
+        view->pixels.assign(4 * numSets, 0);
+        view->drawnCycle = UINT64_MAX;
+    }
+
+    // Upload only the sets, which are far fewer than the lines, and only when they may have changed
+    if (view->drawnCycle != cycle || view->drawnCounter != heatmapCounter) {
+        view->maxValue = 1;
+        for (uint32_t i = 0; i < numSets; i++) {
+            view->maxValue = std::max(view->maxValue, setCounters[i * NUM_SET_COUNTERS + heatmapCounter]);
+        }
+
+        ImVec4 color = colorVec[heatmapColors[heatmapCounter]];
+        double scale = 1.0 / log1p((double) view->maxValue);
+        for (uint32_t i = 0; i < numSets; i++) {
+            float intensity = log1p((double) setCounters[i * NUM_SET_COUNTERS + heatmapCounter]) * scale;
+            view->pixels[4 * i] = color.x * intensity * 255;
+            view->pixels[4 * i + 1] = color.y * intensity * 255;
+            view->pixels[4 * i + 2] = color.z * intensity * 255;
+            view->pixels[4 * i + 3] = 255;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, view->texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, view->pixels.data());
+
+        view->drawnCycle = cycle;
+        view->drawnCounter = heatmapCounter;
+    }
+
+    float imageWidth = ImGui::GetContentRegionAvail().x;
+    ImGui::Image((ImTextureID)(intptr_t) view->texture, ImVec2(imageWidth, imageWidth * height / width));
+
+    // Show the counters of the set under the mouse
+    if (ImGui::IsItemHovered()) {
+        ImVec2 mouse = ImGui::GetMousePos();
+        ImVec2 corner = ImGui::GetItemRectMin();
+        ImVec2 size = ImGui::GetItemRectSize();
+        uint32_t x = std::min<uint32_t>((mouse.x - corner.x) / size.x * width, width - 1);
+        uint32_t y = std::min<uint32_t>((mouse.y - corner.y) / size.y * height, height - 1);
+        const uint64_t* counters = &setCounters[(y * width + x) * NUM_SET_COUNTERS];
+
+        ImGui::SetTooltip("Set %u\nHits: %lu\nMisses: %lu\nEvictions: %lu\nDirty lines: %lu", y * width + x, counters[SET_HITS],
+                          counters[SET_MISSES], counters[SET_EVICTIONS], counters[SET_DIRTY_LINES]);
+    }
+
+    ImGui::Text("%u sets, from 0 to %lu on a logarithmic scale", numSets, view->maxValue);
+}
+
 /**
  * Renders the instruction window.
  */
 void GUI::renderInstructionWindow(Simulator* sim) {
     // Get the operations
     MemoryOperation** ops = sim->getOps();
-    uint32_t numOps = sim->getNumOps();
+    uint64_t numOps = sim->getNumOps();
 
     // Set a size and position based on the current workspace dimms
     ImVec2 windowSize(windowWidth * INSTR_WINDOW_WIDTH, windowHeight * INSTR_WINDOW_HEIGHT);
@@ -185,26 +330,63 @@ void GUI::renderInstructionWindow(Simulator* sim) {
     // Start the window disabling collapse
     ImGui::Begin("Instruction Window", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar);
 
-    // Buttons
+    // Buttons. While Step All runs in the background, it can only be paused or cancelled
+    bool running = worker.joinable();
+    ImGui::BeginDisabled(running);
     if (ImGui::Button("Single Step")) {
         resetScroll();
         sim->singleStep();
     }
     ImGui::SameLine();
-    if (ImGui::Button("Step All")) {
+    if (ImGui::Button("Step Back")) {
         resetScroll();
-        sim->stepAll(true);
+        sim->stepBack();
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (!running) {
+        if (ImGui::Button("Step All")) {
+            resetScroll();
+            startWorker(sim);
+        }
+    } else {
+        if (ImGui::Button(workerPaused ? "Resume" : "Pause")) {
+            workerPaused = !workerPaused;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            workerCancel = true;
+        }
     }
     ImGui::SameLine();
+    ImGui::BeginDisabled(running);
     if (ImGui::Button("Reset")) {
         resetScroll();
-        sim->reset();
+        sim->restart();
     }
+    ImGui::EndDisabled();
 
     ImGui::Separator();
 
     // Current cycle
-    ImGui::Text("Current cycle: %u", cycle);
+    ImGui::Text("Current cycle: %lu", cycle);
+
+    if (running) {
+        // Progress of the background simulation, with the operations per second it has run at so far
+        char overlay[64];
+        double rate = (workerSeconds > 0.0) ? workerOps / workerSeconds : 0.0;
+        snprintf(overlay, sizeof(overlay), "%s%.0f ops/s", workerPaused ? "Paused, " : "", rate);
+        ImGui::ProgressBar((numOps != 0) ? (float) cycle / numOps : 1.0f, ImVec2(-FLT_MIN, 0.0f), overlay);
+    } else {
+        // Scrub to any cycle of the trace
+        uint64_t target = cycle;
+        uint64_t firstCycle = 0;
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::SliderScalar("##Scrub", ImGuiDataType_U64, &target, &firstCycle, &numOps, "Go to cycle %lu")) {
+            resetScroll();
+            sim->seek(target);
+        }
+    }
 
     ImGui::Separator();
 
@@ -217,41 +399,182 @@ void GUI::renderInstructionWindow(Simulator* sim) {
         ImGui::TableSetupColumn("Data");
         ImGui::TableHeadersRow();
 
-        for (int i = 0; i < numOps; i++) {
-            // Create an ID for the checkboxes
-            char checkboxId[6];
-            sprintf(checkboxId, "##C%d", i);
-
-            // Highlight the current operation
-            if (cycle != 0 && cycle == i) {
-                ImU32 rowColor = ImGui::GetColorU32(colorVec[COLOR_EXECUTE]);
-                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, rowColor);
-
-                // Scroll to that row once per cycle
-                if (!scrolledInstructions) {
-                    ImGui::SetScrollHereY(0.5f);
-                    scrolledInstructions = true;
+        // The last executed operation has to be drawn even if it is out of view to scroll to it
+        ImGuiListClipper clipper;
+        clipper.Begin((int) std::min<uint64_t>(numOps, INT_MAX));
+        if (cycle != 0 && !scrolledInstructions) clipper.IncludeItemByIndex(cycle - 1);
+
+        while (clipper.Step()) {
+            for (uint64_t i = clipper.DisplayStart; i < (uint64_t) clipper.DisplayEnd; i++) {
+                // Create an ID for the checkboxes
+                char checkboxId[24];
+                sprintf(checkboxId, "##C%lu", i);
+
+                // Draw the table
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Checkbox(checkboxId, &ops[i]->hasBreakPoint);
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%c", ops[i]->operation == LOAD ? 'L' : 'S');
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%c", ops[i]->isData ? 'D' : 'I');
+                ImGui::TableSetColumnIndex(3); ImGui::Text("0x%lX", ops[i]->address);
+                ImGui::TableSetColumnIndex(4); ops[i]->operation == STORE ? ImGui::Text("%lu", ops[i]->data[0]) : ImGui::Text("-");
+
+                // Highlight the last executed operation
+                if (cycle != 0 && cycle - 1 == i) {
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(colorVec[COLOR_EXECUTE]));
+
+                    // Scroll to that row once per cycle
+                    if (!scrolledInstructions) {
+                        ImGui::SetScrollHereY(0.5f);
+                        scrolledInstructions = true;
+                    }
                 }
             }
-
-            // Draw the table
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0); ImGui::Checkbox(checkboxId, &ops[i]->hasBreakPoint);
-            ImGui::TableSetColumnIndex(1); ImGui::Text("%c", ops[i]->operation == LOAD ? 'L' : 'S');
-            ImGui::TableSetColumnIndex(2); ImGui::Text("%c", ops[i]->isData ? 'D' : 'I');
-            ImGui::TableSetColumnIndex(3); ImGui::Text("0x%lX", ops[i]->address);
-            ImGui::TableSetColumnIndex(4); ops[i]->operation == STORE ? ImGui::Text("%lu", ops[i]->data[0]) : ImGui::Text("-");
         }
 
-        // If the last instruction has been executed already, color the last row independently. It will never get colored with the loop above as it exits 
-        if (cycle == numOps) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(colorVec[COLOR_EXECUTE]));
-
         ImGui::EndTable();
     }
 
     ImGui::End();
 }
 
+/**
+ * Draws the charts of the stats history: the hit rate of each cache and the memory traffic over each stretch of
+ * operations, and the average memory access time since the start. The history keeps a bounded number of points.
+ * @param sim Pointer to the simulator
+ */
+void GUI::drawHistoryCharts(Simulator* sim) {
+    StatsHistory* history = sim->getHistory();
+    if (history == nullptr || history->getNumSamples() < 2) {
+        return;
+    }
+
+    uint32_t numPoints = history->getNumSamples() - 1;
+    char overlay[32];
+    plotValues.resize(numPoints);
+
+    // The counters start again from 0 when the stats are reset
+    auto delta = [](uint64_t now, uint64_t before) { return (now >= before) ? now - before : now; };
+
+    ImGui::Text("\nHistory (%lu operations per point):", history->getStride());
+
+    for (uint32_t i = 0; i < sim->getNumCaches(); i++) {
+        float hitRate = 0.0f;
+        for (uint32_t j = 0; j < numPoints; j++) {
+            uint64_t accesses = delta(history->getAccesses(j + 1, i), history->getAccesses(j, i));
+            uint64_t hits = delta(history->getHits(j + 1, i), history->getHits(j, i));
+
+            // Stretches without accesses keep the previous rate
+            if (accesses != 0) hitRate = hits / (float) accesses * 100;
+            plotValues[j] = hitRate;
+        }
+
+        ImGui::Text("\tHit rate of %s:", sim->getCache(i)->getLabel());
+        snprintf(overlay, sizeof(overlay), "%.1f%%", plotValues[numPoints - 1]);
+        ImGui::PushID(i);
+        ImGui::PlotLines("##HitRate", plotValues.data(), numPoints, 0, overlay, 0.0f, 100.0f, ImVec2(-FLT_MIN, HISTORY_PLOT_HEIGHT));
+        ImGui::PopID();
+    }
+
+    for (uint32_t j = 0; j < numPoints; j++) {
+        const HistorySample* sample = history->getSample(j + 1);
+        plotValues[j] = (sample->measuredOps != 0) ? sample->time / sample->measuredOps : 0.0f;
+    }
+    ImGui::Text("\tAverage memory access time (s):");
+    snprintf(overlay, sizeof(overlay), "%.4f", plotValues[numPoints - 1]);
+    ImGui::PlotLines("##Amat", plotValues.data(), numPoints, 0, overlay, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, HISTORY_PLOT_HEIGHT));
+
+    for (uint32_t j = 0; j < numPoints; j++) {
+        uint64_t accesses = delta(history->getSample(j + 1)->memoryAccesses, history->getSample(j)->memoryAccesses);
+        plotValues[j] = accesses * sim->getWordWidth();
+    }
+    ImGui::Text("\tMemory traffic (Bytes per point):");
+    snprintf(overlay, sizeof(overlay), "%.0f", plotValues[numPoints - 1]);
+    ImGui::PlotLines("##Traffic", plotValues.data(), numPoints, 0, overlay, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, HISTORY_PLOT_HEIGHT));
+}
+
+/**
+ * Draws the editor of the conditional breakpoints and the list of the ones set. Step All stops after the operation that
+ * meets any of them, as with the breakpoints of the trace.
+ * @param sim Pointer to the simulator
+ */
+void GUI::drawBreakpoints(Simulator* sim) {
+    uint32_t numCaches = sim->getNumCaches();
+    int condition = newBreakpoint.condition;
+
+    ImGui::Text("Stop Step All after:");
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::Combo("##Condition", &condition, "An access to an address range\0A miss\0A dirty eviction\0A line replaced in a set\0")) {
+        newBreakpoint.condition = (BreakCondition) condition;
+    }
+
+    if (newBreakpoint.condition == BREAK_ADDRESS) {
+        ImGui::InputScalar("First address", ImGuiDataType_U64, &newBreakpoint.first, nullptr, nullptr, "%llX", ImGuiInputTextFlags_CharsHexadecimal);
+        ImGui::InputScalar("Last address", ImGuiDataType_U64, &newBreakpoint.last, nullptr, nullptr, "%llX", ImGuiInputTextFlags_CharsHexadecimal);
+    } else {
+        // A different simulation may have fewer caches
+        if (newBreakpoint.cache >= (int32_t) numCaches) newBreakpoint.cache = -1;
+
+        if (ImGui::BeginCombo("Cache", (newBreakpoint.cache == -1) ? "Any" : sim->getCache(newBreakpoint.cache)->getLabel())) {
+            if (ImGui::Selectable("Any", newBreakpoint.cache == -1)) newBreakpoint.cache = -1;
+            for (uint32_t i = 0; i < numCaches; i++) {
+                if (ImGui::Selectable(sim->getCache(i)->getLabel(), newBreakpoint.cache == (int32_t) i)) newBreakpoint.cache = i;
+            }
+            ImGui::EndCombo();
+        }
+
+        if (newBreakpoint.condition == BREAK_SET_REPLACEMENT) {
+            ImGui::InputScalar("Set", ImGuiDataType_U32, &newBreakpoint.set);
+        }
+    }
+
+    if (ImGui::Button("Add")) {
+        breakpointError = sim->addBreakpoint(&newBreakpoint) != 0;
+    }
+    if (breakpointError) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Invalid breakpoint, check the console");
+    }
+
+    ImGui::Separator();
+
+    // Breakpoints set, the one that stopped the simulation last is highlighted
+    for (uint32_t i = 0; i < sim->getNumBreakpoints(); i++) {
+        const Breakpoint* breakpoint = sim->getBreakpoint(i);
+        const char* cache = (breakpoint->cache == -1) ? "any cache" : sim->getCache(breakpoint->cache)->getLabel();
+        char text[128];
+
+        switch (breakpoint->condition) {
+            case BREAK_ADDRESS:
+                snprintf(text, sizeof(text), "Access to 0x%lX - 0x%lX", breakpoint->first, breakpoint->last);
+                break;
+            case BREAK_MISS:
+                snprintf(text, sizeof(text), "Miss in %s", cache);
+                break;
+            case BREAK_DIRTY_EVICTION:
+                snprintf(text, sizeof(text), "Dirty eviction in %s", cache);
+                break;
+            default:
+                snprintf(text, sizeof(text), "Line replaced in set %u of %s", breakpoint->set, cache);
+                break;
+        }
+
+        ImGui::PushID(i);
+        bool removed = ImGui::SmallButton("Remove");
+        ImGui::PopID();
+        ImGui::SameLine();
+        if ((int32_t) i == sim->getTriggeredBreakpoint()) {
+            ImGui::TextColored(colorVec[COLOR_EXECUTE], "%s (stopped here)", text);
+        } else {
+            ImGui::Text("%s", text);
+        }
+
+        if (removed) {
+            sim->removeBreakpoint(i);
+            break;
+        }
+    }
+}
+
 /**
  * Renders the stats and misc window.
  * @param sim Pointer to the simulator
@@ -267,28 +590,55 @@ void GUI::renderStatsWindow(Simulator* sim) {
     ImGui::Begin("Misc", nullptr, window_flags);
     if (ImGui::BeginTabBar("TabbedMisc")) {
         if (ImGui::BeginTabItem("Statistics")) {
+            const char* missNames[NUM_MISS_TYPES] = {"compulsory", "capacity", "conflict"};
+            StatsRegistry* stats = sim->getStats();
+            double accessTime = stats->getValue(stats->find("cpu.total_access_time"));
+            uint64_t measuredOps = sim->getMeasuredOps();
+
             ImGui::Text("CPU:");
-            ImGui::Text("\tTotal access time (s): %.4f", sim->getTotalAccessTime());
-            cycle != 0 ? ImGui::Text("\tAverage memory access time (s): %.4f", sim->getTotalAccessTime() / (double) cycle) : ImGui::Text("\tAverage memory access time (ms): -");
+            ImGui::Text("\tTotal access time (s): %.4f", accessTime);
+            measuredOps != 0 ? ImGui::Text("\tAverage memory access time (s): %.4f", accessTime / (double) measuredOps) : ImGui::Text("\tAverage memory access time (ms): -");
     
-            for (int i = 0; i < sim->getNumCaches(); i++) {
+            for (uint32_t i = 0; i < sim->getNumCaches(); i++) {
                 Cache* cache = sim ->getCache(i);
-                ImGui::Text("\nCache L%d:", i + 1);
-                ImGui::Text("\tTotal accesses: %d", cache->getAccesses());
-                ImGui::Text("\tHits: %d", cache->getHits());
-                ImGui::Text("\tMisses: %d", cache->getMisses());
-                cycle != 0 ? ImGui::Text("\tHit rate: %.1f%%", cache->getHits() / (double) cycle * 100) : ImGui::Text("\tHit rate: -");
-                cycle != 0 ? ImGui::Text("\tMiss rate: %.1f%%", cache->getMisses() / (double) cycle * 100) : ImGui::Text("\tMiss rate: ");
+                std::string name = cache->getName();
+                uint64_t hits = stats->getCount(name + ".hits");
+                uint64_t misses = stats->getCount(name + ".misses");
+                uint64_t dataMisses[NUM_MISS_TYPES];
+                uint64_t instructionMisses[NUM_MISS_TYPES];
+
+                for (int j = 0; j < NUM_MISS_TYPES; j++) {
+                    dataMisses[j] = stats->getCount(name + ".d.misses." + missNames[j]);
+                    instructionMisses[j] = stats->getCount(name + ".i.misses." + missNames[j]);
+                }
+
+                ImGui::Text("\nCache %s:", cache->getLabel());
+                ImGui::Text("\tTotal accesses: %lu", stats->getCount(name + ".accesses"));
+                ImGui::Text("\tHits: %lu", hits);
+                ImGui::Text("\tMisses: %lu", misses);
+                ImGui::Text("\tInstruction misses (comp/cap/conf): %lu/%lu/%lu", instructionMisses[MISS_COMPULSORY], instructionMisses[MISS_CAPACITY], instructionMisses[MISS_CONFLICT]);
+                ImGui::Text("\tData misses (comp/cap/conf): %lu/%lu/%lu", dataMisses[MISS_COMPULSORY], dataMisses[MISS_CAPACITY], dataMisses[MISS_CONFLICT]);
+                measuredOps != 0 ? ImGui::Text("\tHit rate: %.1f%%", hits / (double) measuredOps * 100) : ImGui::Text("\tHit rate: -");
+                measuredOps != 0 ? ImGui::Text("\tMiss rate: %.1f%%", misses / (double) measuredOps * 100) : ImGui::Text("\tMiss rate: ");
             }
 
+            uint64_t accessesSingle = stats->getCount("mem.accesses_single");
+            uint64_t accessesBurst = stats->getCount("mem.accesses_burst");
             ImGui::Text("\nMemory:");
-            ImGui::Text("\tTotal accesses: %ld", sim->getMemory()->getAccessesBurst() + sim->getMemory()->getAccessesSingle());
-            ImGui::Text("\tFirst word accesses: %ld", sim->getMemory()->getAccessesSingle());
-            ImGui::Text("\tBurst accesses: %ld", sim->getMemory()->getAccessesBurst());
+            ImGui::Text("\tTotal accesses: %ld", accessesBurst + accessesSingle);
+            ImGui::Text("\tFirst word accesses: %ld", accessesSingle);
+            ImGui::Text("\tBurst accesses: %ld", accessesBurst);
+
+            drawHistoryCharts(sim);
 
             ImGui::EndTabItem();
         }
 
+        if (ImGui::BeginTabItem("Breakpoints")) {
+            drawBreakpoints(sim);
+            ImGui::EndTabItem();
+        }
+
         if (ImGui::BeginTabItem("Legend")) {
             ImGui::Text("Color legend:");
             ImGui::ColorButton("##Legend1", colorVec[COLOR_HIT], ImGuiColorEditFlags_NoTooltip, ImVec2(20, 20));
@@ -333,8 +683,6 @@ void GUI::renderStatsWindow(Simulator* sim) {
  * @param sim Pointer to the simulator
  */
 void GUI::renderCacheWindow(Simulator* sim) {
-    char label[5] = "\0";               // Label for the columns
-
     // Set a size and position based on the current workspace dimms
     ImVec2 windowSize(windowWidth * CACHE_WINDOW_WIDTH, windowHeight * CACHE_WINDOW_HEIGHT);
     ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
@@ -344,7 +692,27 @@ void GUI::renderCacheWindow(Simulator* sim) {
     // Create the cache window
     if (ImGui::Begin("Cache Hierarchy", nullptr, ImGuiWindowFlags_NoCollapse)) {
         // Get the number of caches
-        uint8_t numCaches = sim->getNumCaches();
+        uint32_t numCaches = sim->getNumCaches();
+        if (cacheTables.size() != 2 * numCaches) {
+            cacheTables.assign(2 * numCaches, CacheTableView());
+        }
+
+        // Large caches start as heatmaps, as their tables are too long to follow
+        if (cacheView == -1) {
+            cacheView = CACHE_VIEW_LINES;
+            for (uint32_t i = 0; i < numCaches; i++) {
+                if (sim->getCache(i)->getLines() > HEATMAP_DEFAULT_LINES) cacheView = CACHE_VIEW_HEATMAP;
+            }
+        }
+
+        ImGui::RadioButton("Lines", &cacheView, CACHE_VIEW_LINES);
+        ImGui::SameLine();
+        ImGui::RadioButton("Set heatmap", &cacheView, CACHE_VIEW_HEATMAP);
+        if (cacheView == CACHE_VIEW_HEATMAP) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(150.0f);
+            ImGui::Combo("##HeatmapCounter", &heatmapCounter, "Hits\0Misses\0Evictions\0Dirty lines\0");
+        }
 
         // Create a table with as many columns as caches
         ImGuiTableFlags table_flags = ImGuiTableFlags_ScrollX | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable;
@@ -353,9 +721,9 @@ void GUI::renderCacheWindow(Simulator* sim) {
             float tableHeight = ImGui::GetItemRectSize().y;
 
             // Setup as many columns as caches with a label and a min width
-            for (int i = 0; i < numCaches; i++) {
-                char label[32];
-                sprintf(label, "L%d Cache", i + 1);
+            for (uint32_t i = 0; i < numCaches; i++) {
+                char label[64];
+                snprintf(label, sizeof(label), "%s Cache", sim->getCache(i)->getLabel());
                 ImGui::TableSetupColumn(label, ImGuiTableColumnFlags_WidthFixed, MIN_CACHE_TABLE_WIDTH);
             }
             ImGui::TableHeadersRow();
@@ -364,25 +732,31 @@ void GUI::renderCacheWindow(Simulator* sim) {
             ImGui::TableNextRow();
 
             // Create a table for each cache and draw it's contents
-            for (int i = 0; i < numCaches; i++) {
+            for (uint32_t i = 0; i < numCaches; i++) {
                 Cache* cache = sim->getCache(i);
 
                 ImGui::TableSetColumnIndex(i);
 
                 // Generate a unique ID for the child window
                 char childLabel[32];
-                sprintf(childLabel, "Child_L%d", i);
+                sprintf(childLabel, "Child_L%u", i);
 
                 // ImVec2(0, 0) tells it to fill the width and height of the cell.
                 ImGui::BeginChild(childLabel, ImVec2(0.0f, tableHeight - ImGui::GetStyle().ScrollbarSize), true);
 
                 // Draw the content of the caches inside of the talbe
-                if (cache->isCacheSplit()) {
-                    drawCacheTable(cache->getCache(true), i, cache->getLineSizeWords(),cache->getLines(), (char*) "Instructions");
+                if (cacheView == CACHE_VIEW_HEATMAP) {
+                    if (cache->isCacheSplit()) {
+                        drawSetHeatmap(cache->getSetCounters(true), cache->getSets(), &cacheTables[2 * i + 1], (char*) "Instructions");
+                        ImGui::Separator();
+                    }
+                    drawSetHeatmap(cache->getSetCounters(), cache->getSets(), &cacheTables[2 * i], (char*) "Data");
+                } else if (cache->isCacheSplit()) {
+                    drawCacheTable(cache->getCache(true), cache->getSetBases(true), &cacheTables[2 * i + 1], cache->getLineSizeWords(),cache->getLines(), (char*) "Instructions");
                     ImGui::Separator(); // Visual separator line
-                    drawCacheTable(cache->getCache(), i, cache->getLineSizeWords(), cache->getLines(), (char*) "Data");
+                    drawCacheTable(cache->getCache(), cache->getSetBases(), &cacheTables[2 * i], cache->getLineSizeWords(), cache->getLines(), (char*) "Data");
                 } else {
-                    drawCacheTable(cache->getCache(), i, cache->getLineSizeWords(), cache->getLines(), (char*) "Data");
+                    drawCacheTable(cache->getCache(), cache->getSetBases(), &cacheTables[2 * i], cache->getLineSizeWords(), cache->getLines(), (char*) "Data");
                 }
 
                 ImGui::EndChild();
@@ -425,19 +799,35 @@ void GUI::renderMemoryWindow(Simulator* sim) {
         ImGui::TableSetupColumn("Data");
         ImGui::TableHeadersRow();
 
-        for (int i = 0; i < pageSize / sim->getWordWidth(); i++) {
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0); ImGui::Text("0x%lX", memory[i].address);
-            ImGui::TableSetColumnIndex(1); ImGui::Text("%d", memory[i].content);
+        int32_t numWords = pageSize / sim->getWordWidth();
+
+        // Find the styled word, which has to be drawn even if it is out of view to scroll to it
+        int32_t target = -1;
+        if (!scrolledMemory) {
+            for (int32_t i = 0; i < numWords && target == -1; i++) {
+                if (memory[i].lineColor != COLOR_NONE) target = i;
+            }
+            scrolledMemory = true;
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin(numWords);
+        if (target != -1) clipper.IncludeItemByIndex(target);
 
-            // Apply color to the row if it has some style
-            if (memory[i].lineColor != COLOR_NONE) {
-                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(colorVec[memory[i].lineColor]));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("0x%lX", memory[i].address);
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%d", memory[i].content);
 
-                // Scroll to that row once per cycle
-                if (!scrolledMemory) {
+                // Apply color to the row if it has some style
+                if (memory[i].lineColor != COLOR_NONE) {
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(colorVec[memory[i].lineColor]));
+                }
+
+                // Scroll to the styled row once per cycle
+                if (i == target) {
                     ImGui::SetScrollHereY(0.5f);
-                    scrolledMemory = true;
                 }
             }
         }
@@ -454,8 +844,72 @@ void GUI::renderMemoryWindow(Simulator* sim) {
 void GUI::resetScroll() {
     scrolledInstructions = false;
     scrolledMemory = false;
-    for (int i = 0; i < MAX_CACHE_LEVELS; i++) {
-        scrolledCache[i] = false;
+    for (CacheTableView& view : cacheTables) {
+        view.scrolled = false;
+    }
+}
+
+/**
+ * Body of the worker: runs the rest of the trace in slices, until the end, a breakpoint or a cancel. Between slices,
+ * it lets the frames that are waiting draw the simulation.
+ * @param sim Pointer to the simulator
+ */
+void GUI::runWorker(Simulator* sim) {
+    bool stopped = false;
+
+    while (!stopped && !workerCancel) {
+        if (workerPaused) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(WORKER_PAUSE_MS));
+            continue;
+        }
+
+        // The mutex is not fair, so leave it to a waiting frame instead of taking it back right away
+        while (renderWaiting && !workerCancel) {
+            std::this_thread::yield();
+        }
+
+        std::lock_guard<std::mutex> guard(simMutex);
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+
+        while (!stopped && !renderWaiting && seconds * 1e3 < WORKER_SLICE_MS) {
+            uint64_t before = cycle;
+            stopped = sim->stepSome(WORKER_SLICE_OPS, true);
+            workerOps += cycle - before;
+
+            // Stop at the end of the trace, or if the source ran out of operations before it
+            if (cycle >= sim->getNumOps() || cycle == before) stopped = true;
+
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        workerSeconds += seconds;
+    }
+
+    workerDone = true;
+}
+
+/**
+ * Starts running the rest of the trace in the background.
+ * @param sim Pointer to the simulator
+ */
+void GUI::startWorker(Simulator* sim) {
+    workerPaused = false;
+    workerCancel = false;
+    workerDone = false;
+    workerOps = 0;
+    workerSeconds = 0.0;
+
+    worker = std::thread(&GUI::runWorker, this, sim);
+}
+
+/**
+ * Cancels the background simulation, if any, and waits for it to stop.
+ */
+void GUI::stopWorker() {
+    if (worker.joinable()) {
+        workerCancel = true;
+        worker.join();
     }
 }
 
@@ -543,6 +997,21 @@ void GUI::renderWorkspace(Simulator* sim) {
     // Always fetch the window size prior to re rendering it
     SDL_GetWindowSize(window, &windowWidth, &windowHeight);
 
+    // Collect the background simulation once it has finished, and show where it stopped
+    if (workerDone) {
+        stopWorker();
+        workerDone = false;
+        resetScroll();
+    }
+
+    // Keep the simulation still while the frame is built, so that every window shows the same cycle
+    renderWaiting = true;
+    std::lock_guard<std::mutex> guard(simMutex);
+    renderWaiting = false;
+
+    // Follow the background simulation
+    if (worker.joinable()) resetScroll();
+
     // Render all different parts of the GUI
     renderInstructionWindow(sim);
     renderStatsWindow(sim);
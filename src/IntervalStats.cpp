@@ -0,0 +1,200 @@
+#include "IntervalStats.h"
+#include "Simulator.h"
+
+IntervalStats::IntervalStats() {
+    sim = nullptr;
+    file = NULL;
+    buffer = NULL;
+    head = 0;
+    count = 0;
+    unwritten = 0;
+}
+
+IntervalStats::~IntervalStats() {
+    close();
+}
+
+/**
+ * Opens the output file and starts sampling. The format is picked from the extension of the file: JSON Lines for
+ * .jsonl and .json files, CSV for anything else. The stats accumulated before calling this are not part of the first interval.
+ * @param path Path to the output file. It will be overwritten.
+ * @param simulator The simulator to sample.
+ * @param numOps The number of operations between samples.
+ * @return int 0 if Ok, -1 if the file could not be opened.
+ */
+int IntervalStats::open(const char* path, Simulator* simulator, uint32_t numOps) {
+    const char* extension = strrchr(path, '.');
+
+    file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+
+    // The samples are written in bursts, so a large buffer keeps the number of writes low
+    buffer = (char*) malloc(INTERVAL_BUFFER_SIZE);
+    setvbuf(file, buffer, _IOFBF, INTERVAL_BUFFER_SIZE);
+
+    if (extension != NULL && (strcmp(extension, ".jsonl") == 0 || strcmp(extension, ".json") == 0)) {
+        format = INTERVAL_JSONL;
+    } else {
+        format = INTERVAL_CSV;
+    }
+
+    sim = simulator;
+    interval = numOps;
+    untilSample = numOps;
+    cacheLevels = sim->getNumCaches();
+    wordWidth = sim->getWordWidth();
+
+    head = 0;
+    count = 0;
+    unwritten = 0;
+    takeSample(&lastWritten);
+    writeHeader();
+
+    return 0;
+}
+
+/**
+ * Must be called after each measured operation. Takes a sample every interval operations.
+ */
+void IntervalStats::step() {
+    if (--untilSample != 0) {
+        return;
+    }
+
+    untilSample = interval;
+    takeSample(&ring[head]);
+    head = (head + 1) % INTERVAL_RING_SIZE;
+    if (count < INTERVAL_RING_SIZE) count++;
+
+    // Stream the samples out before they get overwritten
+    if (++unwritten == INTERVAL_RING_SIZE) {
+        flush();
+    }
+}
+
+/**
+ * Writes all the samples that have not been written yet, oldest first.
+ */
+void IntervalStats::flush() {
+    for (uint32_t age = unwritten; age > 0; age--) {
+        writeSample(getSample(age - 1));
+    }
+    unwritten = 0;
+}
+
+/**
+ * Takes a last sample with the operations executed since the previous one, writes everything and closes the file.
+ */
+void IntervalStats::close() {
+    if (file == NULL) {
+        return;
+    }
+
+    // Partial last interval
+    if (untilSample != interval) {
+        untilSample = 1;
+        step();
+    }
+
+    flush();
+    fclose(file);
+    free(buffer);
+    file = NULL;
+    buffer = NULL;
+}
+
+/**
+ * Returns the number of samples kept in memory.
+ * @return uint32_t The number of samples.
+ */
+uint32_t IntervalStats::getNumSamples() {
+    return count;
+}
+
+/**
+ * Returns a sample kept in memory.
+ * @param age 0 for the newest sample, 1 for the one before, and so on. Must be lower than getNumSamples().
+ * @return const IntervalSample* The sample.
+ */
+const IntervalSample* IntervalStats::getSample(uint32_t age) {
+    return &ring[(head + INTERVAL_RING_SIZE - 1 - age) % INTERVAL_RING_SIZE];
+}
+
+/**
+ * Copies the current value of the counters of the hierarchy.
+ * @param sample The sample to fill.
+ */
+void IntervalStats::takeSample(IntervalSample* sample) {
+    MainMemory* memory = sim->getMemory();
+
+    sample->operation = sim->getMeasuredOps();
+    sample->time = sim->getTotalAccessTime();
+    sample->memoryAccesses = memory->getAccessesSingle() + memory->getAccessesBurst();
+    sample->levels.resize(cacheLevels);
+
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        Cache* cache = sim->getCache(i);
+        sample->levels[i].accesses = cache->getAccesses();
+        sample->levels[i].hits = cache->getHits();
+        sample->levels[i].misses = cache->getMisses();
+        sample->levels[i].writebacks = cache->getWritebacks();
+    }
+}
+
+/**
+ * Writes the names of the columns of a CSV file. JSON Lines files have no header.
+ */
+void IntervalStats::writeHeader() {
+    if (format != INTERVAL_CSV) {
+        return;
+    }
+
+    fprintf(file, "operation,time");
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        const char* name = sim->getCache(i)->getName();
+        fprintf(file, ",%s_accesses,%s_hits,%s_misses,%s_writebacks,%s_miss_rate", name, name, name, name, name);
+    }
+    fprintf(file, ",mem_accesses,mem_bytes,mem_bandwidth\n");
+}
+
+/**
+ * Writes the difference between a sample and the previously written one.
+ * @param sample The sample.
+ */
+void IntervalStats::writeSample(const IntervalSample* sample) {
+    double time = sample->time - lastWritten.time;
+    uint64_t memoryAccesses = sample->memoryAccesses - lastWritten.memoryAccesses;
+    uint64_t memoryBytes = memoryAccesses * wordWidth;
+    double bandwidth = (time > 0.0) ? memoryBytes / time : 0.0;
+
+    if (format == INTERVAL_CSV) {
+        fprintf(file, "%lu,%.6f", sample->operation, time);
+    } else {
+        fprintf(file, "{\"operation\":%lu,\"time\":%.6f,\"levels\":[", sample->operation, time);
+    }
+
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        uint64_t accesses = sample->levels[i].accesses - lastWritten.levels[i].accesses;
+        uint64_t hits = sample->levels[i].hits - lastWritten.levels[i].hits;
+        uint64_t misses = sample->levels[i].misses - lastWritten.levels[i].misses;
+        uint64_t writebacks = sample->levels[i].writebacks - lastWritten.levels[i].writebacks;
+        double missRate = (accesses > 0) ? misses / (double) accesses : 0.0;
+
+        if (format == INTERVAL_CSV) {
+            fprintf(file, ",%lu,%lu,%lu,%lu,%.4f", accesses, hits, misses, writebacks, missRate);
+        } else {
+            fprintf(file, "%s{\"accesses\":%lu,\"hits\":%lu,\"misses\":%lu,\"writebacks\":%lu,\"miss_rate\":%.4f}",
+                    (i > 0) ? "," : "", accesses, hits, misses, writebacks, missRate);
+        }
+    }
+
+    if (format == INTERVAL_CSV) {
+        fprintf(file, ",%lu,%lu,%.1f\n", memoryAccesses, memoryBytes, bandwidth);
+    } else {
+        fprintf(file, "],\"memory\":{\"accesses\":%lu,\"bytes\":%lu,\"bandwidth\":%.1f}}\n", memoryAccesses, memoryBytes, bandwidth);
+    }
+
+    lastWritten = *sample;
+}
@@ -0,0 +1,298 @@
+#include "Journal.h"
+
+Journal::Journal() {
+    countersPerStep = 0;
+    snapshotInterval = JOURNAL_SNAPSHOT_INTERVAL;
+}
+
+Journal::~Journal() {
+    clear();
+}
+
+/**
+ * Starts recording a new step. If the journal is full, the oldest step is forgotten.
+ * @param stepCounters The value of all the simulation counters before the step.
+ */
+void Journal::beginStep(const std::vector<uint64_t>& stepCounters) {
+    if (steps.size() >= JOURNAL_MAX_STEPS) {
+        dropOldestStep();
+    }
+
+    countersPerStep = stepCounters.size();
+    counters.insert(counters.end(), stepCounters.begin(), stepCounters.end());
+    steps.push_back({0, 0, 0, 0});
+}
+
+/**
+ * Records the state of a cache line before it gets modified. A line can be recorded more than once per step.
+ * @param element The cache the line belongs to.
+ * @param line The line that is about to be modified.
+ * @param lineSizeWords The number of words in the line.
+ */
+void Journal::recordLine(MemoryElement* element, CacheLine* line, uint32_t lineSizeWords) {
+    JournalLine record;
+
+    record.element = element;
+    record.line = line;
+    record.state.tag = line->tag;
+    record.state.firstAccess = line->firstAccess;
+    record.state.lastAccess = line->lastAccess;
+    record.state.numberAccesses = line->numberAccesses;
+    record.state.valid = line->valid;
+    record.state.dirty = line->dirty;
+    record.lineSizeWords = lineSizeWords;
+    record.colorAfter = COLOR_NONE;
+
+    lines.push_back(record);
+    contents.insert(contents.end(), line->content, line->content + lineSizeWords);
+    steps.back().lines++;
+}
+
+/**
+ * Records the state of a memory word before it gets modified.
+ * @param element The memory the word belongs to.
+ * @param word The word that is about to be modified.
+ */
+void Journal::recordWord(MemoryElement* element, MemoryLine* word) {
+    words.push_back({element, word, word->content, COLOR_NONE});
+    steps.back().words++;
+}
+
+/**
+ * Records a reference made to a miss classifier.
+ * @param record What the reference modified in the classifier.
+ */
+void Journal::recordReference(const ClassifierRecord* record) {
+    references.push_back(*record);
+    steps.back().references++;
+}
+
+/**
+ * Records the value of a 64 bit variable before it gets modified.
+ * @param address The variable that is about to be modified.
+ */
+void Journal::recordValue(uint64_t* address) {
+    values.push_back({address, *address});
+    steps.back().values++;
+}
+
+/**
+ * Finishes the current step, remembering the style each modified element ended up with.
+ */
+void Journal::endStep() {
+    JournalStep step = steps.back();
+
+    for (uint32_t i = 0; i < step.lines; i++) {
+        JournalLine& record = lines[lines.size() - 1 - i];
+        record.colorAfter = record.line->lineColor;
+    }
+
+    for (uint32_t i = 0; i < step.words; i++) {
+        JournalWord& record = words[words.size() - 1 - i];
+        record.colorAfter = record.word->lineColor;
+    }
+}
+
+/**
+ * Returns the number of steps that can be undone.
+ * @return uint32_t The number of steps.
+ */
+uint32_t Journal::getDepth() {
+    return steps.size();
+}
+
+/**
+ * Reverts all the lines, words, classifier references and values modified by the newest step, newest record first.
+ * @param stepCounters Returns the value of the simulation counters before the step.
+ * @return true If the step was undone.
+ * @return false If the journal is empty.
+ */
+bool Journal::undoStep(std::vector<uint64_t>& stepCounters) {
+    if (steps.empty()) {
+        return false;
+    }
+
+    JournalStep step = steps.back();
+    steps.pop_back();
+
+    for (uint32_t i = 0; i < step.lines; i++) {
+        JournalLine& record = lines.back();
+        CacheLine* line = record.line;
+
+        // The content words were pushed in order, so they come back reversed
+        for (int32_t j = record.lineSizeWords - 1; j >= 0; j--) {
+            line->content[j] = contents.back();
+            contents.pop_back();
+        }
+
+        line->tag = record.state.tag;
+        line->firstAccess = record.state.firstAccess;
+        line->lastAccess = record.state.lastAccess;
+        line->numberAccesses = record.state.numberAccesses;
+        line->valid = record.state.valid;
+        line->dirty = record.state.dirty;
+        line->lineColor = COLOR_NONE;
+        line->version++;
+        lines.pop_back();
+    }
+
+    for (uint32_t i = 0; i < step.words; i++) {
+        JournalWord& record = words.back();
+        record.word->content = record.content;
+        record.word->lineColor = COLOR_NONE;
+        words.pop_back();
+    }
+
+    for (uint32_t i = 0; i < step.references; i++) {
+        references.back().classifier->undo(&references.back());
+        references.pop_back();
+    }
+
+    for (uint32_t i = 0; i < step.values; i++) {
+        *values.back().address = values.back().value;
+        values.pop_back();
+    }
+
+    stepCounters.assign(counters.end() - countersPerStep, counters.end());
+    counters.erase(counters.end() - countersPerStep, counters.end());
+
+    return true;
+}
+
+/**
+ * Forgets the newest steps without reverting them. Used when the state is restored from a snapshot.
+ * @param numSteps The number of steps to forget.
+ */
+void Journal::discardSteps(uint64_t numSteps) {
+    for (uint64_t i = 0; i < numSteps && !steps.empty(); i++) {
+        JournalStep step = steps.back();
+        steps.pop_back();
+
+        for (uint32_t j = 0; j < step.lines; j++) {
+            contents.erase(contents.end() - lines.back().lineSizeWords, contents.end());
+            lines.pop_back();
+        }
+
+        words.erase(words.end() - step.words, words.end());
+        references.erase(references.end() - step.references, references.end());
+        values.erase(values.end() - step.values, values.end());
+        counters.erase(counters.end() - countersPerStep, counters.end());
+    }
+}
+
+/**
+ * Styles the elements modified by the newest step as they were at the end of it.
+ * Used to recover the style of the previous step after undoing.
+ */
+void Journal::restyleLastStep() {
+    if (steps.empty()) {
+        return;
+    }
+
+    JournalStep step = steps.back();
+
+    for (uint32_t i = 0; i < step.lines; i++) {
+        JournalLine& record = lines[lines.size() - 1 - i];
+        record.element->setStyle(&record.line->lineColor, record.colorAfter);
+    }
+
+    for (uint32_t i = 0; i < step.words; i++) {
+        JournalWord& record = words[words.size() - 1 - i];
+        record.element->setStyle(&record.word->lineColor, record.colorAfter);
+    }
+}
+
+/**
+ * Forgets the oldest step in the journal.
+ */
+void Journal::dropOldestStep() {
+    JournalStep step = steps.front();
+    steps.pop_front();
+
+    for (uint32_t i = 0; i < step.lines; i++) {
+        contents.erase(contents.begin(), contents.begin() + lines.front().lineSizeWords);
+        lines.pop_front();
+    }
+
+    words.erase(words.begin(), words.begin() + step.words);
+    references.erase(references.begin(), references.begin() + step.references);
+    values.erase(values.begin(), values.begin() + step.values);
+    counters.erase(counters.begin(), counters.begin() + countersPerStep);
+}
+
+/**
+ * Checks if a full snapshot should be taken before running the given cycle.
+ * @param cycle The cycle about to be run.
+ * @return true If there is no snapshot for that cycle and it is on the snapshot interval.
+ */
+bool Journal::isSnapshotDue(uint64_t cycle) {
+    if (cycle % snapshotInterval != 0) {
+        return false;
+    }
+
+    JournalSnapshot* snapshot = findSnapshot(cycle);
+    return snapshot == nullptr || snapshot->cycle != cycle;
+}
+
+/**
+ * Stores a full snapshot. The journal takes ownership of the data, which must have been allocated with malloc.
+ * If there are too many snapshots, every other one is dropped and the interval between them doubles.
+ * @param cycle The cycle of the snapshot.
+ * @param data The serialised state.
+ * @param size The size of the data in Bytes.
+ */
+void Journal::addSnapshot(uint64_t cycle, char* data, size_t size) {
+    // Keep the snapshots sorted by cycle
+    std::vector<JournalSnapshot>::iterator it = snapshots.begin();
+    while (it != snapshots.end() && it->cycle < cycle) it++;
+    snapshots.insert(it, {cycle, data, size});
+
+    if (snapshots.size() > JOURNAL_MAX_SNAPSHOTS) {
+        snapshotInterval *= 2;
+
+        std::vector<JournalSnapshot> kept;
+        for (JournalSnapshot& snapshot : snapshots) {
+            if (snapshot.cycle % snapshotInterval == 0) {
+                kept.push_back(snapshot);
+            } else {
+                free(snapshot.data);
+            }
+        }
+        snapshots.swap(kept);
+    }
+}
+
+/**
+ * Finds the newest snapshot that is not after the given cycle.
+ * @param cycle The cycle.
+ * @return JournalSnapshot* The snapshot, or nullptr if there is none.
+ */
+JournalSnapshot* Journal::findSnapshot(uint64_t cycle) {
+    JournalSnapshot* found = nullptr;
+
+    for (JournalSnapshot& snapshot : snapshots) {
+        if (snapshot.cycle > cycle) break;
+        found = &snapshot;
+    }
+
+    return found;
+}
+
+/**
+ * Forgets all the steps and snapshots.
+ */
+void Journal::clear() {
+    steps.clear();
+    lines.clear();
+    contents.clear();
+    words.clear();
+    references.clear();
+    values.clear();
+    counters.clear();
+
+    for (JournalSnapshot& snapshot : snapshots) {
+        free(snapshot.data);
+    }
+    snapshots.clear();
+    snapshotInterval = JOURNAL_SNAPSHOT_INTERVAL;
+}
@@ -14,12 +14,82 @@ AppArgs parseArguments(int argc, char** argv) {
 
     app.add_option("-c,--config", args.configFile, "Path to the configuration file")
        ->check(CLI::ExistingFile);
-    app.add_option("-t,--trace", args.traceFile, "Path to the trace file")
+    CLI::Option* trace = app.add_option("-t,--trace", args.traceFile, "Path to the trace file")
        ->check(CLI::ExistingFile);
     app.add_flag("-d,--debug", args.debug, "Debug verbosity")
         ->check(CLI::Range(0, 2))
         ->default_val(0);
-    app.add_flag("-g,--nogui", args.noGui, "Disable the GUI");
+    CLI::Option* noGui = app.add_flag("-g,--nogui", args.noGui, "Disable the GUI");
+    app.add_flag("-q,--quiet", args.quiet, "Do not print the progress of each operation")
+       ->needs(noGui);
+    app.add_option("--dramsys-out", args.dramsysFile, "Path to write a DRAMSys trace of the requests that reach the main memory");
+    app.add_option("--checkpoint-load", args.checkpointLoad, "Path to a checkpoint to restore before simulating")
+       ->check(CLI::ExistingFile);
+    app.add_option("--checkpoint-save", args.checkpointSave, "Path to save a checkpoint of the simulation");
+    app.add_option("--checkpoint-at", args.checkpointAt, "Number of operations after which the checkpoint is saved (Default: end of the trace)")
+       ->needs("--checkpoint-save");
+    CLI::Option* warmup = app.add_option("-w,--warmup", args.warmup, "Number of operations that warm up the hierarchy before measuring");
+    app.add_option("--warmup-fraction", args.warmupFraction, "Fraction of the trace that warms up the hierarchy before measuring")
+       ->check(CLI::Range(0.0, 1.0))
+       ->excludes(warmup);
+    CLI::Option* intervalFile = app.add_option("--interval-out", args.intervalFile, "Path to write the interval statistics to, as JSON Lines if it ends in .jsonl, as CSV otherwise")
+       ->needs(noGui);
+    app.add_option("-i,--interval", args.interval, "Number of operations per sample of the interval statistics")
+       ->check(CLI::PositiveNumber)
+       ->needs(intervalFile);
+    app.add_option("--stats-json", args.statsJson, "Path to write the final statistics to as JSON")
+       ->needs(noGui);
+    app.add_option("--stats-csv", args.statsCsv, "Path to write the final statistics to as CSV")
+       ->needs(noGui);
+    CLI::Option* generate = app.add_option("--generate", args.generate, "Simulate a generated trace instead of a trace file: sequential, stride, uniform, zipf, chase or matmul")
+       ->excludes(trace);
+    app.add_option("--gen-ops", args.genOps, "Number of operations of the generated trace")
+       ->check(CLI::PositiveNumber)
+       ->needs(generate);
+    app.add_option("--gen-footprint", args.genFootprint, "Bytes covered by the generated trace from the page base address, with K, M or G (Default: the page)")
+       ->needs(generate);
+    app.add_option("--gen-stride", args.genStride, "Bytes between accesses of the stride pattern and between nodes of the chase pattern")
+       ->check(CLI::PositiveNumber)
+       ->needs(generate);
+    app.add_option("--gen-writes", args.genWrites, "Fraction of the generated data accesses that are stores")
+       ->check(CLI::Range(0.0, 1.0))
+       ->needs(generate);
+    app.add_option("--gen-inst", args.genInst, "Fraction of the generated operations that are instruction fetches")
+       ->check(CLI::Range(0.0, 1.0))
+       ->needs(generate);
+    app.add_option("--gen-zipf", args.genZipf, "Skew of the zipf pattern")
+       ->check(CLI::PositiveNumber)
+       ->needs(generate);
+    app.add_option("--gen-block", args.genBlock, "Elements per side of the blocks of the matmul pattern")
+       ->check(CLI::PositiveNumber)
+       ->needs(generate);
+    app.add_option("--gen-seed", args.genSeed, "Seed of the trace generator")
+       ->needs(generate);
+    app.add_option("--gen-out", args.genOut, "Path to write the generated trace to as a trace file, instead of simulating it")
+       ->needs(generate);
+    app.add_option("--compress-out", args.compressOut, "Path to write the trace, or the generated one, to as a compressed trace, instead of simulating it");
+    app.add_option("--trace-threads", args.traceThreads, "Number of threads that decompress a compressed trace ahead of the simulation (Default: one per core but one)")
+       ->needs(noGui);
+    CLI::Option* filterOut = app.add_option("--filter-out", args.filterOut, "Path to record the requests that reach --filter-level to, as a filter stream")
+       ->needs(noGui);
+    app.add_option("--filter-level", args.filterLevel, "Level whose requests are recorded, 2 for L2 (Default: the last cache)")
+       ->check(CLI::PositiveNumber)
+       ->needs(filterOut);
+    app.add_option("--filter-in", args.filterIn, "Replay a filter stream into the level it was recorded at, skipping the levels above")
+       ->check(CLI::ExistingFile)
+       ->excludes(trace)
+       ->excludes(generate)
+       ->needs(noGui);
+    app.add_option("-j,--jobs", args.jobs, "Number of configurations of a sweep simulated at once (Default: one per core)")
+       ->check(CLI::PositiveNumber)
+       ->needs(noGui);
+
+#ifndef NUCACHIS_GUI
+    // Built without GUI, every run is a --nogui run
+    for (CLI::Option* option : app.get_options()) {
+        option->remove_needs(noGui);
+    }
+#endif
 
     try {
         app.parse(argc, argv);
@@ -27,24 +97,735 @@ AppArgs parseArguments(int argc, char** argv) {
         std::exit(app.exit(e));
     }
 
+#ifndef NUCACHIS_GUI
+    args.noGui = true;
+#endif
+
     return args;
 }
 
-int main(int argc, char** argv) {
-    // File paths for the trace and config
-    char configPath[MAX_PATH_LENGTH] = "\0";
-    char tracePath[MAX_PATH_LENGTH] = "\0";
+/**
+ * Prepares the trace generator from the CLI arguments.
+ * @param args The CLI arguments.
+ * @param sc The configuration, which gives the word width, the page and the size of the memory.
+ * @param generator The generator.
+ * @return int 0 if Ok, -2 if the parameters are invalid.
+ */
+int setupGenerator(AppArgs* args, SimulatorConfig* sc, TraceGenerator* generator) {
+    GeneratorConfig gc;
+
+    int pattern = parseGeneratorPattern(args->generate.c_str());
+    if (pattern < 0) {
+        fprintf(stderr, "Generator Error: Unknown access pattern %s\n", args->generate.c_str());
+        return -2;
+    }
+
+    gc.pattern = (GeneratorPattern) pattern;
+    gc.numOps = args->genOps;
+    gc.baseAddress = sc->memPageBaseAddress;
+    gc.footprint = sc->memPageSize;
+    gc.wordWidth = sc->cpuWordWidth / 8;
+    gc.stride = args->genStride;
+    gc.writeRatio = args->genWrites;
+    gc.instRatio = args->genInst;
+    gc.zipfSkew = args->genZipf;
+    gc.block = args->genBlock;
+    gc.seed = args->genSeed;
+
+    if (!args->genFootprint.empty()) {
+        long footprint = parseLong(args->genFootprint.c_str(), true);
+        if (footprint <= 0) {
+            fprintf(stderr, "Generator Error: Invalid footprint %s\n", args->genFootprint.c_str());
+            return -2;
+        }
+        gc.footprint = footprint;
+    }
+
+    if (gc.baseAddress + gc.footprint > (uint64_t) sc->memSize) {
+        fprintf(stderr, "Generator Error: The footprint does not fit in the memory after the page base address\n");
+        return -2;
+    }
+
+    return (generator->init(&gc) == 0) ? 0 : -2;
+}
+
+/**
+ * Opens the operations to simulate: a generated, compressed or imported trace or a filter stream, which are pulled one
+ * at a time, or a text trace, which is parsed whole.
+ * @param args The CLI arguments.
+ * @param tracePath Path to the trace file, if not generated.
+ * @param sc The configuration. Gets the number of operations of text traces.
+ * @param sources The sources, the one that gets used is opened.
+ * @param source Returns the source of the operations, nullptr for text traces.
+ * @param ops Returns the parsed operations of text traces.
+ * @return int 0 if Ok, -1 if warnings, -2 if fatal errors
+ */
+int openTrace(AppArgs* args, char* tracePath, SimulatorConfig* sc, TraceSources* sources, OperationSource** source,
+              MemoryOperation*** ops) {
+    *source = nullptr;
+
+    if (!args->generate.empty()) {
+        *source = &sources->generator;
+        return setupGenerator(args, sc, &sources->generator);
+    }
+
+    if (!args->filterIn.empty()) {
+        FilterReader* filter = &sources->filter;
+        if (filter->open(args->filterIn.c_str()) != 0) {
+            return -2;
+        }
+
+        if (!sc->miscIsChain) {
+            fprintf(stderr, "Filter Error: Filter streams can only be replayed into a chain of caches\n");
+            return -2;
+        }
+
+        // The requests are only valid for the configuration of the levels above that produced them
+        uint32_t level = filter->getLevel();
+        if (level > (uint32_t) sc->miscCacheLevels + 1 || filter->getFingerprint() != filterFingerprint(sc, level)) {
+            fprintf(stderr, "Filter Error: The levels above L%u are configured differently than when the filter stream was recorded\n", level);
+            return -2;
+        }
+
+        *source = filter;
+        return 0;
+    }
+
+    TraceFormat format = detectTraceFormat(tracePath);
+
+    if (format == TRACE_FORMAT_COMPRESSED) {
+        // Leave a core for the simulation itself
+        uint32_t threads = args->traceThreads;
+        if (threads == 0) {
+            threads = std::max<int>(std::thread::hardware_concurrency() - 1, 1);
+        }
+
+        *source = &sources->reader;
+        return sources->reader.open(tracePath, threads);
+    }
+
+    if (format != TRACE_FORMAT_VCA) {
+        *source = &sources->importer;
+        return sources->importer.open(tracePath, format, sc->memPageBaseAddress);
+    }
+
+    return parseTrace(tracePath, ops, &sc->miscNumOperations, sc->memPageBaseAddress);
+}
+
+/**
+ * Writes a trace, either a trace file or the generated one, as a compressed trace.
+ * @param args The CLI arguments.
+ * @param configPath Path to the configuration, only needed by generated traces.
+ * @param tracePath Path to the trace file, if not generated.
+ * @return int 0 if Ok, -1 if the trace could not be read or written.
+ */
+int compressTrace(AppArgs* args, char* configPath, char* tracePath) {
+    CompressedTraceWriter writer;
+
+    if (!args->generate.empty()) {
+        SimulatorConfig sc;
+        TraceGenerator generator;
+        MemoryOperation op;
+        uint64_t data;
+
+        if (parseConfiguration(configPath, &sc) == -2 || setupGenerator(args, &sc, &generator) != 0 ||
+            writer.open(args->compressOut.c_str()) != 0) {
+            return -1;
+        }
+
+        op.data = &data;
+        while (generator.next(&op)) {
+            writer.append(&op);
+        }
+    } else {
+        MemoryOperation** ops;
+        uint64_t numOps;
+
+        // The trace is only converted, so its addresses do not need to fit any memory
+        if (parseTrace(tracePath, &ops, &numOps, 0) == -2 || writer.open(args->compressOut.c_str()) != 0) {
+            return -1;
+        }
+
+        // Only stores have data
+        for (uint64_t i = 0; i < numOps; i++) {
+            writer.append(ops[i]);
+            if (ops[i]->operation == STORE) free(ops[i]->data);
+            free(ops[i]);
+        }
+        free(ops);
+    }
+
+    return writer.close();
+}
+
+/**
+ * Simulates a configuration of a sweep and prints its statistics. Runs in a child process, so it can use the globals
+ * of the simulator freely.
+ * @param args The CLI arguments.
+ * @param tracePath Path to the trace file, if not generated.
+ * @param point The configuration.
+ * @param ops The operations of text traces, already parsed. NULL to open the trace.
+ * @param numOps The number of operations of text traces.
+ * @param out The file the statistics are printed to, as CSV.
+ * @return int 0 if Ok, -1 if the trace could not be opened.
+ */
+int runSweepPoint(AppArgs* args, char* tracePath, SweepPoint* point, MemoryOperation** ops, uint64_t numOps, FILE* out) {
+    SimulatorConfig* sc = &point->config;
+    TraceSources sources;
+    OperationSource* source = nullptr;
+    Simulator* sim;
+
+    if (ops != NULL) {
+        sc->miscNumOperations = numOps;
+    } else if (openTrace(args, tracePath, sc, &sources, &source, &ops) == -2) {
+        return -1;
+    }
+
+    sim = (source != nullptr) ? new Simulator(sc, source) : new Simulator(sc, ops);
+    sim->setQuiet(true);
+
+    uint64_t warmup = args->warmup;
+    if (args->warmupFraction > 0.0) {
+        warmup = args->warmupFraction * sim->getNumOps();
+    }
+    if (warmup > 0) {
+        sim->warmup(warmup);
+    }
+
+    sim->stepAll(false);
+    sim->getStats()->printCsv(out);
+    return 0;
+}
+
+/**
+ * Splits a line of CSV. The fields cannot have commas.
+ * @param line The line, without the line break.
+ * @param fields Returns the fields.
+ */
+void splitCsv(const std::string& line, std::vector<std::string>* fields) {
+    size_t start = 0;
+
+    fields->clear();
+    while (true) {
+        size_t comma = line.find(',', start);
+        fields->push_back(line.substr(start, comma - start));
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+}
+
+/**
+ * Returns a statistic of a configuration of a sweep.
+ * @param result The results of the configuration.
+ * @param name The name of the statistic.
+ * @return double The value, NAN if the configuration has no such statistic.
+ */
+double sweepStat(SweepResult* result, const std::string& name) {
+    for (uint32_t i = 0; i < result->names.size(); i++) {
+        if (result->names[i] == name) {
+            return strtod(result->values[i].c_str(), NULL);
+        }
+    }
+
+    return NAN;
+}
+
+/**
+ * Prints the summary of a sweep as a table, one row per configuration: the swept values, the AMAT, the miss rate of
+ * each cache and the accesses to the main memory.
+ * @param keys The swept keys.
+ * @param points The configurations.
+ * @param results The results of each configuration.
+ */
+void printSweepTable(std::vector<std::string>& keys, std::vector<SweepPoint>& points, std::vector<SweepResult>& results) {
+    std::vector<std::string> header = keys;
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> caches = points[0].config.cacheName;
+    char cell[64];
+
+    header.push_back("AMAT (s)");
+    for (uint32_t i = 0; i < caches.size(); i++) {
+        header.push_back(caches[i] + " miss rate");
+    }
+    header.push_back("Memory accesses");
+
+    for (uint32_t i = 0; i < points.size(); i++) {
+        std::vector<std::string> row = points[i].values;
+        SweepResult* result = &results[i];
+        double measuredOps = sweepStat(result, "cpu.cycle") - sweepStat(result, "cpu.warmup_operations");
+
+        if (result->failed) {
+            row.resize(header.size(), "-");
+            rows.push_back(row);
+            continue;
+        }
+
+        snprintf(cell, sizeof(cell), "%.4f", sweepStat(result, "cpu.total_access_time") / measuredOps);
+        row.push_back(cell);
+        for (uint32_t j = 0; j < caches.size(); j++) {
+            double misses = sweepStat(result, caches[j] + ".misses");
+            snprintf(cell, sizeof(cell), "%.1f%%", misses / measuredOps * 100);
+            row.push_back(std::isnan(misses) ? "-" : cell);
+        }
+        snprintf(cell, sizeof(cell), "%.0f", sweepStat(result, "mem.accesses_single") + sweepStat(result, "mem.accesses_burst"));
+        row.push_back(cell);
+        rows.push_back(row);
+    }
+
+    // Swept values are aligned to the left and the statistics to the right
+    std::vector<size_t> widths;
+    for (uint32_t j = 0; j < header.size(); j++) {
+        widths.push_back(header[j].size());
+        for (uint32_t i = 0; i < rows.size(); i++) {
+            widths[j] = std::max(widths[j], rows[i][j].size());
+        }
+    }
+
+    rows.insert(rows.begin(), header);
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        for (uint32_t j = 0; j < header.size(); j++) {
+            printf((j < keys.size()) ? "%-*s" : "  %*s", (int) widths[j], rows[i][j].c_str());
+            if (j + 1 < keys.size()) printf("  ");
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * Writes the statistics of every configuration of a sweep, to a CSV file with a row per configuration, or to a JSON
+ * file with an array of objects, each with the swept values and the statistics. Failed configurations are left out.
+ * @param path Path to the file. It will be overwritten.
+ * @param json If the file is JSON instead of CSV.
+ * @param keys The swept keys.
+ * @param points The configurations.
+ * @param results The results of each configuration.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int writeSweepStats(const char* path, bool json, std::vector<std::string>& keys, std::vector<SweepPoint>& points,
+                    std::vector<SweepResult>& results) {
+    FILE* file = fopen(path, "w");
+    bool first = true;
+
+    if (file == NULL) {
+        fprintf(stderr, "Stats Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    fprintf(file, json ? "[\n" : "");
+    for (uint32_t i = 0; i < points.size(); i++) {
+        SweepResult* result = &results[i];
+
+        if (result->failed) {
+            continue;
+        }
+
+        if (json) {
+            fprintf(file, first ? "  {\"sweep\": {" : ",\n  {\"sweep\": {");
+            for (uint32_t j = 0; j < keys.size(); j++) {
+                fprintf(file, (j > 0) ? ", \"%s\": \"%s\"" : "\"%s\": \"%s\"", keys[j].c_str(), points[i].values[j].c_str());
+            }
+            fprintf(file, "}, \"stats\": {");
+            for (uint32_t j = 0; j < result->names.size(); j++) {
+                fprintf(file, (j > 0) ? ", \"%s\": %s" : "\"%s\": %s", result->names[j].c_str(), result->values[j].c_str());
+            }
+            fprintf(file, "}}");
+        } else {
+            // Every configuration has the same statistics, unless the sweep changes the caches
+            if (first) {
+                for (uint32_t j = 0; j < keys.size(); j++) {
+                    fprintf(file, "%s,", keys[j].c_str());
+                }
+                for (uint32_t j = 0; j < result->names.size(); j++) {
+                    fprintf(file, (j > 0) ? ",%s" : "%s", result->names[j].c_str());
+                }
+                fprintf(file, "\n");
+            }
+            for (uint32_t j = 0; j < keys.size(); j++) {
+                fprintf(file, "%s,", points[i].values[j].c_str());
+            }
+            for (uint32_t j = 0; j < result->values.size(); j++) {
+                fprintf(file, (j > 0) ? ",%s" : "%s", result->values[j].c_str());
+            }
+            fprintf(file, "\n");
+        }
+        first = false;
+    }
+    fprintf(file, json ? "\n]\n" : "");
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Stats Error: Failed writing %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Simulates every configuration of a sweep and prints a table that compares them. The simulator keeps its state in
+ * globals, so each configuration runs in its own process, up to --jobs at once, and sends its statistics back through
+ * a pipe.
+ * @param args The CLI arguments.
+ * @param tracePath Path to the trace file, if not generated.
+ * @param keys The swept keys.
+ * @param points The configurations.
+ * @return int 0 if Ok, 1 if any configuration could not be simulated.
+ */
+int runSweep(AppArgs* args, char* tracePath, std::vector<std::string>& keys, std::vector<SweepPoint>& points) {
+    std::vector<SweepResult> results(points.size());
+    MemoryOperation** ops = NULL;
+    uint64_t numOps = 0;
+    uint32_t jobs = (args->jobs != 0) ? args->jobs : std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    uint32_t started = 0;
+    uint32_t running = 0;
+    uint32_t finished = 0;
+    bool launching = true;              // Cleared when a child cannot be started, the running ones are still waited for
+    int errors = 0;
+
+    // Text traces are parsed once and shared with the children. The other sources are opened by each child, and as
+    // the configurations already take every core, compressed traces are decompressed by a single thread
+    if (args->generate.empty() && detectTraceFormat(tracePath) == TRACE_FORMAT_VCA &&
+        parseTrace(tracePath, &ops, &numOps, 0) == -2) {
+        return 1;
+    }
+    if (args->traceThreads == 0) {
+        args->traceThreads = 1;
+    }
+
+    while (running > 0 || (launching && started < points.size())) {
+        // Keep the jobs busy
+        while (launching && running < jobs && started < points.size()) {
+            SweepResult* result = &results[started];
+            int fds[2];
+
+            fflush(stdout);
+            fflush(stderr);
+            if (pipe(fds) != 0) {
+                fprintf(stderr, "Sweep Error: Cannot start the simulation of configuration %u\n", started + 1);
+                launching = false;
+                errors++;
+                break;
+            }
+            if ((result->pid = fork()) < 0) {
+                fprintf(stderr, "Sweep Error: Cannot start the simulation of configuration %u\n", started + 1);
+                close(fds[0]);
+                close(fds[1]);
+                launching = false;
+                errors++;
+                break;
+            }
+
+            if (result->pid == 0) {
+                close(fds[0]);
+                FILE* out = fdopen(fds[1], "w");
+                int status = runSweepPoint(args, tracePath, &points[started], ops, numOps, out);
+                fclose(out);
+                fflush(stderr);
+                _exit((status == 0) ? 0 : 1);
+            }
+
+            close(fds[1]);
+            result->fd = fds[0];
+            started++;
+            running++;
+        }
+
+        // Read what the children send until they close their pipes, then reap them
+        std::vector<struct pollfd> polled;
+        std::vector<uint32_t> owners;
+        for (uint32_t i = 0; i < started; i++) {
+            if (results[i].fd >= 0) {
+                polled.push_back({results[i].fd, POLLIN, 0});
+                owners.push_back(i);
+            }
+        }
+        if (polled.empty() || poll(polled.data(), polled.size(), -1) < 0) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < polled.size(); j++) {
+            uint32_t i = owners[j];
+            SweepResult* result = &results[i];
+            char buffer[4096];
+            int status;
+
+            if (polled[j].revents == 0) {
+                continue;
+            }
+
+            ssize_t bytes = read(result->fd, buffer, sizeof(buffer));
+            if (bytes > 0) {
+                result->output.append(buffer, bytes);
+                continue;
+            }
+            if (bytes < 0 && errno == EINTR) {
+                continue;
+            }
+
+            close(result->fd);
+            result->fd = -1;
+            waitpid(result->pid, &status, 0);
+            running--;
+            finished++;
+
+            // A header and a row of values
+            size_t lineBreak = result->output.find('\n');
+            result->failed = !WIFEXITED(status) || WEXITSTATUS(status) != 0 || lineBreak == std::string::npos;
+            if (!result->failed) {
+                splitCsv(result->output.substr(0, lineBreak), &result->names);
+                splitCsv(result->output.substr(lineBreak + 1, result->output.find('\n', lineBreak + 1) - lineBreak - 1),
+                         &result->values);
+                result->failed = result->names.size() != result->values.size();
+            }
+            if (result->failed) {
+                fprintf(stderr, "Sweep Error: The simulation of configuration %u failed\n", i + 1);
+                errors++;
+            }
+            if (!args->quiet && isatty(STDERR_FILENO)) {
+                fprintf(stderr, "\rSimulated %u of %zu configurations", finished, points.size());
+                if (finished == points.size()) fprintf(stderr, "\n");
+            }
+        }
+    }
+
+    // The configurations that could not be started are left out, as the failed ones
+    for (uint32_t i = started; i < points.size(); i++) {
+        results[i].failed = true;
+    }
+    if (!args->quiet && isatty(STDERR_FILENO) && finished > 0 && finished < points.size()) {
+        fprintf(stderr, "\n");
+    }
+
+    printSweepTable(keys, points, results);
+
+    if (!args->statsJson.empty() && writeSweepStats(args->statsJson.c_str(), true, keys, points, results) != 0) {
+        return 1;
+    }
+    if (!args->statsCsv.empty() && writeSweepStats(args->statsCsv.c_str(), false, keys, points, results) != 0) {
+        return 1;
+    }
+
+    return (errors > 0) ? 1 : 0;
+}
+
+#ifdef NUCACHIS_GUI
+/**
+ * Runs the GUI until its window is closed. The files that were not given as arguments are picked in the GUI.
+ * @param args The CLI arguments.
+ * @param configPath Path to the configuration, empty to pick it.
+ * @param tracePath Path to the trace file, empty to pick it.
+ * @param dramsys The DRAMSys trace, not opened if it was not requested.
+ */
+void runGui(AppArgs* args, char* configPath, char* tracePath, DramsysFile* dramsys) {
     bool filesProvided = false;
     bool filesValidated = false;
     bool filesParsingError = false;
+    SimulatorConfig sc;
+    MemoryOperation** ops;
+    Simulator* sim;
+
+    // Create a new GUI
+    GUI* gui = new GUI();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    SDL_Window* window = gui->getWindow();
+
+    // Main loop
+    bool running = true;
+
+    while (running) {
+        // Mandatory SDL polling on each frame
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            ImGui_ImplSDL2_ProcessEvent(&event);
+            if (event.type == SDL_QUIT)
+                running = false;
+        }
+
+        // Start a new rendering frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplSDL2_NewFrame();
+        ImGui::NewFrame();
+
+        // Display the file picker if no files have been provided
+        if (!filesProvided) {
+            gui->renderPicker(configPath, tracePath, true, &filesProvided);
+            
+            // If there was an error in the parsing operation, show the error. The first \n is a hacky way of adding padding to the top
+            if (filesParsingError) {
+                gui->renderError((char*) "\nError parsing configuration or trace.\nCheck the console for more info.", &filesParsingError);
+            }
+        } else {
+            // Parse the files the first time they are provided
+            if (!filesValidated) {
+                // Parse the trace and make sure there are no fatal errors
+                if (parseConfiguration(configPath, &sc) != -2 &&
+                    parseTrace(tracePath, &ops, &sc.miscNumOperations, sc.memPageBaseAddress) != -2) {
+                    filesValidated = true;
+
+                    sim = new Simulator(&sc, ops);
+                    sim->enableJournal();
+                    sim->enableHistory();
+                    if (dramsys->file != NULL) sim->getMemory()->setDramsysFile(dramsys);
+                    if (!args->checkpointLoad.empty()) sim->loadCheckpoint(args->checkpointLoad.c_str());
+                } else {
+                    // If there were fatal errors, signal that an error should be shown and that the files are not ready
+                    filesParsingError = true;
+                    filesProvided = false;
+                }
+            } else {
+                // Render the main window (workspace) on each frame once everything has been setup
+                gui->renderWorkspace(sim);
+            }
+        }
+
+        // Render the frame afterwards
+        ImGui::Render();
+        glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        SDL_GL_SwapWindow(window);
+    }
+
+    // Stops the simulation that may still be running in the background
+    delete gui;
+}
+#endif
 
-    // Config and trace
+/**
+ * Runs a simulation without GUI, or a sweep of simulations, and prints and writes its statistics.
+ * @param args The CLI arguments.
+ * @param configPath Path to the configuration.
+ * @param tracePath Path to the trace file, if not generated.
+ * @param dramsys The DRAMSys trace, not opened if it was not requested. Left open for the caller to close.
+ * @return int 0 if Ok, 1 if the simulation could not be completed.
+ */
+int runSimulation(AppArgs* args, char* configPath, char* tracePath, DramsysFile* dramsys) {
     SimulatorConfig sc;
     MemoryOperation** ops;  // Pointer to an array of pointers to operations
-
-    // Structures
     Simulator* sim;
+    IntervalStats intervals;
+    TraceSources sources;
+    OperationSource* source;
+    FilterRecorder recorder;
+
+    std::vector<std::string> sweptKeys;
+    std::vector<SweepPoint> points;
+
+    // Any value of the configuration can sweep a list or a range, and then every combination is simulated
+    int sweep = parseSweep(configPath, &sweptKeys, &points);
+    if (sweep != -2 && !sweptKeys.empty()) {
+        if (!args->dramsysFile.empty() || !args->checkpointLoad.empty() || !args->checkpointSave.empty() ||
+            !args->intervalFile.empty() || !args->filterOut.empty() || !args->filterIn.empty()) {
+            fprintf(stderr, "Error: Sweeps only write their statistics, they cannot use DRAMSys traces, checkpoints, interval statistics or filter streams\n");
+            return 1;
+        }
+        return runSweep(args, tracePath, sweptKeys, points);
+    }
+
+    // If the files are correct, run the simulation
+    if (sweep != -2 && parseConfiguration(configPath, &sc) != -2 &&
+        openTrace(args, tracePath, &sc, &sources, &source, &ops) != -2) {
+
+        // Generated, compressed and imported operations are pulled one at a time, without ever storing the trace
+        if (!args->filterIn.empty()) {
+            sim = new Simulator(&sc, &sources.filter);
+        } else {
+            sim = (source != nullptr) ? new Simulator(&sc, source) : new Simulator(&sc, ops);
+        }
+        if (dramsys->file != NULL) sim->getMemory()->setDramsysFile(dramsys);
+        sim->setQuiet(args->quiet);
+
+        // Warm up with the same operations as the recorded simulation, unless told otherwise
+        if (!args->filterIn.empty() && args->warmup == 0 && args->warmupFraction == 0.0) {
+            args->warmup = sources.filter.getWarmupCycles();
+        }
+
+        // Record the requests that reach a level, by default the last cache
+        if (!args->filterOut.empty()) {
+            if (!sc.miscIsChain) {
+                fprintf(stderr, "Filter Error: Filter streams can only be recorded from a chain of caches\n");
+                return 1;
+            }
+            uint32_t level = (args->filterLevel != 0) ? args->filterLevel : std::max<uint32_t>(sc.miscCacheLevels, 1);
+            if (level > (uint32_t) sc.miscCacheLevels + 1) {
+                fprintf(stderr, "Filter Error: There is no level %u, the memory is level %u\n", level, sc.miscCacheLevels + 1);
+                return 1;
+            }
+            if (recorder.open(args->filterOut.c_str(), &sc, level) != 0) {
+                return 1;
+            }
+            sim->setFilterRecorder(&recorder);
+        }
+
+        // Start from a warmed hierarchy if a checkpoint was provided
+        if (!args->checkpointLoad.empty() && sim->loadCheckpoint(args->checkpointLoad.c_str()) != 0) {
+            return 1;
+        }
+
+        // Warm up the hierarchy without measuring
+        if (args->warmupFraction > 0.0) {
+            args->warmup = args->warmupFraction * sim->getNumOps();
+        }
+        if (args->warmup > 0) {
+            sim->warmup(args->warmup);
+        }
+
+        // Sample the measured operations
+        if (!args->intervalFile.empty()) {
+            if (intervals.open(args->intervalFile.c_str(), sim, args->interval ? args->interval : INTERVAL_DEFAULT_OPERATIONS) != 0) {
+                fprintf(stderr, "Error: Could not open the interval statistics file %s\n", args->intervalFile.c_str());
+                return 1;
+            }
+            sim->setIntervalStats(&intervals);
+        }
+
+        if (!args->checkpointSave.empty()) {
+            // Run up to the requested operation, save, and then finish the trace
+            uint64_t saveAt = (args->checkpointAt != 0) ? args->checkpointAt : sim->getNumOps();
+            while (cycle < saveAt && cycle < sim->getNumOps()) {
+                sim->singleStep();
+            }
+            if (sim->saveCheckpoint(args->checkpointSave.c_str()) != 0) {
+                return 1;
+            }
+        }
+
+        sim->stepAll(false);
+        intervals.close();
+        if (!args->filterOut.empty() && recorder.close(cycle, cycle - sim->getMeasuredOps()) != 0) {
+            return 1;
+        }
+        sim->printStatistics();
+
+        // Machine readable statistics
+        if (!args->statsJson.empty() && sim->getStats()->writeJson(args->statsJson.c_str()) != 0) {
+            return 1;
+        }
+        if (!args->statsCsv.empty() && sim->getStats()->writeCsv(args->statsCsv.c_str()) != 0) {
+            return 1;
+        }
+    } else {
+        fprintf(stderr, "Error: Check the configuration and trace argument paths are correct\n");
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // File paths for the trace and config
+    char configPath[MAX_PATH_LENGTH] = "\0";
+    char tracePath[MAX_PATH_LENGTH] = "\0";
+
+    // Config, only needed here to write generated traces
+    SimulatorConfig sc;
+    TraceSources sources;
+
+    DramsysFile dramsys = {};
+    int result = 0;
     AppArgs args = parseArguments(argc, argv);
+    bool generating = !args.generate.empty();
 
     // Copy the config and trace files if they were provided as an argument
     if (!args.configFile.empty()) {
@@ -56,77 +837,42 @@ int main(int argc, char** argv) {
 
     debugLevel = args.debug;
 
-    if (args.noGui) {
-        // If the files are correct, run the simulation
-        if (parseConfiguration(configPath, &sc) != -2 &&
-            parseTrace(tracePath, &ops, &sc.miscNumOperations) != -2) {
-
-            sim = new Simulator(&sc, ops); 
-            sim->stepAll(false);
-            sim->printStatistics();
-        } else {
-            fprintf(stderr, "Error: Check the configuration and trace argument paths are correct\n");
+    // Write the generated trace instead of simulating it if requested
+    if (!args.genOut.empty()) {
+        if (parseConfiguration(configPath, &sc) == -2 || setupGenerator(&args, &sc, &sources.generator) != 0 ||
+            sources.generator.writeTrace(args.genOut.c_str()) != 0) {
+            return 1;
         }
-    } else {
-        // Create a new GUI
-        GUI* gui = new GUI();
-        ImGuiIO& io = ImGui::GetIO(); (void)io;
-        SDL_Window* window = gui->getWindow();
-
-        // Main loop
-        bool running = true;
-
-        while (running) {
-            // Mandatory SDL polling on each frame
-            SDL_Event event;
-            while (SDL_PollEvent(&event)) {
-                ImGui_ImplSDL2_ProcessEvent(&event);
-                if (event.type == SDL_QUIT)
-                    running = false;
-            }
-
-            // Start a new rendering frame
-            ImGui_ImplOpenGL3_NewFrame();
-            ImGui_ImplSDL2_NewFrame();
-            ImGui::NewFrame();
-
-            // Display the file picker if no files have been provided
-            if (!filesProvided) {
-                gui->renderPicker(configPath, tracePath, true, &filesProvided);
-                
-                // If there was an error in the parsing operation, show the error. The first \n is a hacky way of adding padding to the top
-                if (filesParsingError) {
-                    gui->renderError((char*) "\nError parsing configuration or trace.\nCheck the console for more info.", &filesParsingError);
-                }
-            } else {
-                // Parse the files the first time they are provided
-                if (!filesValidated) {
-                    // Parse the trace and make sure there are no fatal errors
-                    if (parseConfiguration(configPath, &sc) != -2 &&
-                        parseTrace(tracePath, &ops, &sc.miscNumOperations) != -2) {
-                        filesValidated = true;
-
-                        sim = new Simulator(&sc, ops);
-                    } else {
-                        // If there were fatal errors, signal that an error should be shown and that the files are not ready
-                        filesParsingError = true;
-                        filesProvided = false;
-                    }
-                } else {
-                    // Render the main window (workspace) on each frame once everything has been setup
-                    gui->renderWorkspace(sim);
-                }
-            }
+        return 0;
+    }
 
-            // Render the frame afterwards
-            ImGui::Render();
-            glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-            SDL_GL_SwapWindow(window);
-        }
+    // Compress the trace instead of simulating it if requested
+    if (!args.compressOut.empty()) {
+        return (compressTrace(&args, configPath, tracePath) == 0) ? 0 : 1;
     }
-    
-    return 0;
+
+    // The GUI lists the whole trace, so generated traces have to be written to a file first
+    if (generating && !args.noGui) {
+        fprintf(stderr, "Error: Generated traces can only be simulated without GUI, write them to a file with --gen-out\n");
+        return 1;
+    }
+
+    // Open the DRAMSys trace if requested
+    if (!args.dramsysFile.empty() && openDramsysFile(args.dramsysFile.c_str(), &dramsys) != 0) {
+        fprintf(stderr, "Error: Could not open the DRAMSys trace %s\n", args.dramsysFile.c_str());
+        return 1;
+    }
+
+    if (args.noGui) {
+        result = runSimulation(&args, configPath, tracePath, &dramsys);
+    } else {
+#ifdef NUCACHIS_GUI
+        runGui(&args, configPath, tracePath, &dramsys);
+#endif
+    }
+
+    // Flushes the requests still buffered, also after errors
+    closeDramsysFile(&dramsys);
+
+    return result;
 }
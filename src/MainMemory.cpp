@@ -1,5 +1,9 @@
+#include <algorithm>
+
 #include "MainMemory.h"
 #include "Misc.h"
+#include "Journal.h"
+#include "StatsRegistry.h"
 
 MainMemory::MainMemory(SimulatorConfig* sc) {
     wordWidth = sc->cpuWordWidth / 8;               // In Bytes
@@ -14,6 +18,9 @@ MainMemory::MainMemory(SimulatorConfig* sc) {
     accessTimeSingle = sc->memAccessTimeSingle;
     accessTimeBurst = sc->memAccessTimeBurst;
 
+    // The DRAMSys export is disabled by default
+    dramsysFile = nullptr;
+
     // Allocate memory for the memory
     // The size is given in bytes, but the data is only addressable/displayed in words
     memory = (MemoryLine*) malloc(sizeof(MemoryLine) * (pageSize / wordWidth));
@@ -66,23 +73,212 @@ uint64_t MainMemory::getAccessesBurst() {
     return accessesBurst;
 }
 
+/**
+ * Sets the writer in which all the requests that reach the memory will be traced in DRAMSys format.
+ * @param df Pointer to an open DRAMSys writer, nullptr to disable the export.
+ */
+void MainMemory::setDramsysFile(DramsysFile* df) {
+    dramsysFile = df;
+}
+
+/**
+ * Gets a word of the memory. The words of the page are always there, the ones outside of it only once written.
+ * @param index The index of the word, counted from the page base.
+ * @param create True to add the word if it is outside of the page and has never been written.
+ * @return MemoryLine* Pointer to the word, nullptr if it is not there and create is false.
+ */
+MemoryLine* MainMemory::getLine(uint64_t index, bool create) {
+    if (index < (uint64_t) (pageSize / wordWidth)) {
+        return &memory[index];
+    }
+
+    auto it = offPage.find(index);
+    if (it != offPage.end()) {
+        return &it->second;
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    // Same initial content as the words of the page
+    MemoryLine* line = &offPage[index];
+    line->address = index * wordWidth + pageBaseAddress;
+    line->content = (uint32_t) index;
+    line->lineColor = COLOR_NONE;
+    return line;
+}
+
+/**
+ * Sets the simulated time at which the operation that is being executed by the CPU started.
+ * @param time The simulated time in seconds.
+ */
+void MainMemory::setCurrentTime(double time) {
+    currentTime = time;
+}
+
+/**
+ * Resets the stats of the memory without modifying its content.
+ */
+void MainMemory::resetStats() {
+    accessesSingle = 0;
+    accessesBurst = 0;
+}
+
 /**
  * Resets the entire main memory.
  */
 void MainMemory::flush() {
     // Init the stats
-    accessesSingle = 0;
-    accessesBurst = 0;
+    resetStats();
+
+    // Init the simulated time
+    currentTime = 0.0;
+    busyUntil = 0.0;
 
     // Calculate the maximum number of array items to cover up a page
     uint64_t pageLimit = pageSize / wordWidth;
 
-    // Fill the memory with increasing numbers
+    // Fill the memory with increasing numbers, which leaves no word styled
+    styled.clear();
     for (int i = 0; i < pageLimit; i++) {
         memory[i].address = i * wordWidth + pageBaseAddress;
         memory[i].content = i;
         memory[i].lineColor = COLOR_NONE;
     }
+
+    // The words outside of the page go back to their initial content too
+    offPage.clear();
+}
+
+/**
+ * Writes the whole state of the memory (stats, simulated time, content of the page and written words outside of it) to a checkpoint.
+ * @param file The checkpoint file, opened for writing.
+ */
+void MainMemory::saveState(FILE* file) {
+    uint64_t pageLimit = pageSize / wordWidth;
+    uint64_t header[4] = {(uint64_t) pageBaseAddress, pageLimit, accessesSingle, accessesBurst};
+    double times[2] = {currentTime, busyUntil};
+
+    fwrite(header, sizeof(uint64_t), 4, file);
+    fwrite(times, sizeof(double), 2, file);
+
+    // The addresses are implicit, so only the content gets stored
+    uint32_t* content = (uint32_t*) malloc(sizeof(uint32_t) * pageLimit);
+    for (uint64_t i = 0; i < pageLimit; i++) {
+        content[i] = memory[i].content;
+    }
+
+    fwrite(content, sizeof(uint32_t), pageLimit, file);
+    free(content);
+
+    // Written words outside of the page as index and content pairs, sorted so that the checkpoint is deterministic.
+    // Words that hold their initial content again, such as undone stores, are left out as if never written
+    std::vector<uint64_t> words;
+    for (auto& word : offPage) {
+        if (word.second.content != (uint32_t) word.first) {
+            words.push_back(word.first);
+        }
+    }
+    std::sort(words.begin(), words.end());
+
+    uint64_t numWords = words.size();
+    fwrite(&numWords, sizeof(uint64_t), 1, file);
+    for (uint64_t index : words) {
+        uint64_t pair[2] = {index, offPage[index].content};
+        fwrite(pair, sizeof(uint64_t), 2, file);
+    }
+}
+
+/**
+ * Restores the whole state of the memory from a checkpoint written by saveState.
+ * @param file The checkpoint file, opened for reading.
+ * @return int 0 if Ok, -1 if the checkpoint is truncated or belongs to a different page.
+ */
+int MainMemory::loadState(FILE* file) {
+    uint64_t pageLimit = pageSize / wordWidth;
+    uint64_t header[4];
+    double times[2];
+
+    if (fread(header, sizeof(uint64_t), 4, file) != 4 || fread(times, sizeof(double), 2, file) != 2) {
+        fprintf(stderr, "Checkpoint Error: Main memory is truncated\n");
+        return -1;
+    }
+
+    if (header[0] != (uint64_t) pageBaseAddress || header[1] != pageLimit) {
+        fprintf(stderr, "Checkpoint Error: Main memory has a different page than the configured one\n");
+        return -1;
+    }
+
+    styled.clear();
+    uint32_t* content = (uint32_t*) malloc(sizeof(uint32_t) * pageLimit);
+    if (fread(content, sizeof(uint32_t), pageLimit, file) != pageLimit) {
+        fprintf(stderr, "Checkpoint Error: Main memory is truncated\n");
+        free(content);
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < pageLimit; i++) {
+        memory[i].content = content[i];
+        memory[i].lineColor = COLOR_NONE;
+    }
+    free(content);
+
+    // The words outside of the page are reset in place instead of removed, as the undo journal may point to them
+    uint64_t numWords;
+    if (fread(&numWords, sizeof(uint64_t), 1, file) != 1) {
+        fprintf(stderr, "Checkpoint Error: Main memory is truncated\n");
+        return -1;
+    }
+
+    for (auto& word : offPage) {
+        word.second.content = (uint32_t) word.first;
+        word.second.lineColor = COLOR_NONE;
+    }
+
+    for (uint64_t i = 0; i < numWords; i++) {
+        uint64_t pair[2];
+        if (fread(pair, sizeof(uint64_t), 2, file) != 2 || pair[0] < pageLimit) {
+            fprintf(stderr, "Checkpoint Error: Main memory is truncated\n");
+            return -1;
+        }
+        getLine(pair[0], true)->content = pair[1];
+    }
+
+    accessesSingle = header[2];
+    accessesBurst = header[3];
+    currentTime = times[0];
+    busyUntil = times[1];
+
+    return 0;
+}
+
+/**
+ * Appends the stats and simulated time of the memory to a list of counters.
+ * @param counters The list.
+ */
+void MainMemory::saveCounters(std::vector<uint64_t>& counters) {
+    uint64_t times[2];
+    memcpy(times, &currentTime, sizeof(double));
+    memcpy(times + 1, &busyUntil, sizeof(double));
+
+    counters.push_back(accessesSingle);
+    counters.push_back(accessesBurst);
+    counters.push_back(times[0]);
+    counters.push_back(times[1]);
+}
+
+/**
+ * Restores the stats and simulated time of the memory from a list of counters written by saveCounters.
+ * @param counters Pointer to the first counter of the memory.
+ * @return const uint64_t* Pointer to the counter after the ones of the memory.
+ */
+const uint64_t* MainMemory::restoreCounters(const uint64_t* counters) {
+    accessesSingle = counters[0];
+    accessesBurst = counters[1];
+    memcpy(&currentTime, counters + 2, sizeof(double));
+    memcpy(&busyUntil, counters + 3, sizeof(double));
+    return counters + 4;
 }
 
 /**
@@ -99,22 +295,45 @@ void MainMemory::processRequest(MemoryOperation* op, MemoryReply* rep) {
     //If it is a load, put the data in the reply
     if (op->operation == LOAD) {
         for (int i = 0; i < op->numWords; i++) {
-            rep->data[i] = memory[i + baseIndex].content;
-            (i == 0) ? memory[i + baseIndex].lineColor = COLOR_LOAD_FIRST : memory[i + baseIndex].lineColor = COLOR_LOAD_BURST;
+            MemoryLine* line = getLine(i + baseIndex, false);
+
+            // A word outside of the page that was never written still has its initial content
+            if (line == nullptr) {
+                rep->data[i] = (uint32_t) (i + baseIndex);
+                continue;
+            }
+
+            if (journal != nullptr) journal->recordWord(this, line);
+            rep->data[i] = line->content;
+            setStyle(&line->lineColor, (i == 0) ? COLOR_LOAD_FIRST : COLOR_LOAD_BURST);
         }
     } else if (op->operation == STORE) {
         for (int i = 0; i < op->numWords; i++) {
-            memory[i + baseIndex].content = op->data[i];
-            (i == 0) ? memory[i + baseIndex].lineColor = COLOR_STORE_FIRST : memory[i + baseIndex].lineColor = COLOR_STORE_BURST;
+            MemoryLine* line = getLine(i + baseIndex, true);
+            if (journal != nullptr) journal->recordWord(this, line);
+            line->content = op->data[i];
+            setStyle(&line->lineColor, (i == 0) ? COLOR_STORE_FIRST : COLOR_STORE_BURST);
         }
     } else {
         assert(0 && "Unsupported operation type");
     }
 
-    // Update the access time
     // The first access takes accessTimeSingle. If there is more than one word in the operation, the following take accessTimeBurst
-    rep->totalTime += accessTimeSingle;
-    rep->totalTime += accessTimeBurst * (op->numWords - 1);
+    double requestTime = accessTimeSingle + accessTimeBurst * (op->numWords - 1);
+
+    // Requests are served one after another, so a request starts when both the CPU operation has started and the previous request has finished
+    if (!functional) {
+        double startTime = (currentTime > busyUntil) ? currentTime : busyUntil;
+        busyUntil = startTime + requestTime;
+
+        if (dramsysFile != nullptr) {
+            writeToDramsysFile(dramsysFile, (uint64_t) (startTime * DRAMSYS_TICKS_PER_SECOND + 0.5), op->operation, op->address);
+        }
+    }
+
+    // Update the access time
+    rep->totalTime += requestTime;
+    rep->hitLevel = 0;
 
     // Update the stats following the same principles
     accessesSingle++;
@@ -122,10 +341,10 @@ void MainMemory::processRequest(MemoryOperation* op, MemoryReply* rep) {
 }
 
 /**
- * Clears the style from all memory rows. 
+ * Registers the statistics of the memory as mem.*
+ * @param stats The registry.
  */
-void MainMemory::clearStyle() {
-    for (int i = 0; i < pageSize / wordWidth; i++) {
-        memory[i].lineColor = COLOR_NONE;
-    }
+void MainMemory::registerStats(StatsRegistry* stats) {
+    stats->add("mem.accesses_single", &accessesSingle);
+    stats->add("mem.accesses_burst", &accessesBurst);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "MemoryElement.h"
 
 // Constructor
-MemoryElement::MemoryElement() : next(nullptr), prev(nullptr) {}
+MemoryElement::MemoryElement() : next(nullptr), prev(nullptr), journal(nullptr), functional(false), quiet(false) {}
 
 MemoryElement* MemoryElement::getNext() {
     return next;
@@ -18,3 +18,57 @@ void MemoryElement::setNext(MemoryElement* nextElement) {
 void MemoryElement::setPrev(MemoryElement* prevElement) {
     prev = prevElement;
 }
+
+
+void MemoryElement::setJournal(Journal* j) {
+    journal = j;
+}
+
+void MemoryElement::setFunctional(bool isFunctional) {
+    functional = isFunctional;
+}
+
+void MemoryElement::setQuiet(bool isQuiet) {
+    quiet = isQuiet;
+}
+
+/**
+ * Styles a row of the element, remembering it so that clearStyle only visits the rows styled since the last clear.
+ * Nothing is styled in functional or quiet mode.
+ * @param style The style of the row.
+ * @param color The new style.
+ */
+void MemoryElement::setStyle(ColorNames* style, ColorNames color) {
+    if (functional || quiet) {
+        return;
+    }
+
+    // A row that is already styled was remembered when it got its first style
+    if (*style == COLOR_NONE && color != COLOR_NONE) {
+        styled.push_back(style);
+    }
+    *style = color;
+}
+
+/**
+ * Clears the style of the rows styled since the last clear.
+ */
+void MemoryElement::clearStyle() {
+    for (ColorNames* style : styled) {
+        *style = COLOR_NONE;
+    }
+    styled.clear();
+}
+
+/**
+ * Serves the longest run of requests at the start of a batch of CPU operations that the element can complete on its own,
+ * one cycle each: the request i runs at cycle + i. The caller advances cycle past the ones served, and the rest of the
+ * batch has to go through processRequest, in order. By default, no request is served.
+ * @param ops The requests.
+ * @param reps The replies, with the time set to 0.
+ * @param numOps The number of requests.
+ * @return uint32_t The number of requests served.
+ */
+uint32_t MemoryElement::processBatch(MemoryOperation**, MemoryReply*, uint32_t) {
+    return 0;
+}
@@ -16,7 +16,8 @@ const char* writePolicyStr(PolicyWrite policy) { return strWritePolicy[policy];
 
 // Global variables
 int debugLevel = 0;
-uint32_t cycle = 0;
+uint64_t cycle = 0;
+uint64_t randState = 1;
 
 /**
  * Convert string into long. It can have a multiplier G, M or K. Any other char will result in error.
@@ -328,67 +329,95 @@ void contentStringToArray(unsigned* array, char* content, int count) {
 
 
 /**
- * Opens the specified DRAMSys file and returns the last memory access stored in the file
+ * Opens (and truncates) the specified DRAMSys trace file and sets up its write buffer.
  * @param filename The name or path to the file.
- * @param f A pointer to the file that will get opened.
- * @return The number of the last memory access stored in the open file.
+ * @param df Pointer to the writer that will be initialised.
+ * @return 0 if Ok, -1 if the file could not be opened.
  */
-int openDramsysFile(const char* filename, FILE** f) {
+int openDramsysFile(const char* filename, DramsysFile* df) {
+    df->used = 0;
+    df->requests = 0;
+    df->buffer = NULL;
+
 	// The file gets opened
-	*f = fopen(filename, "r");
+	df->file = fopen(filename, "w");
 
 	// If the file could not be opened, return -1
-    if (*f == NULL) {
-        perror("Error opening file\n");
+    if (df->file == NULL) {
+        perror("Error opening DRAMSys file");
         return -1;
     }
 
-    int number;
-    char text[256];
+    df->buffer = (char*) malloc(DRAMSYS_BUFFER_SIZE);
+	return 0;
+}
 
-    // While there is data on the file, iterate until the end is reached.
-    while (fscanf(*f, "%d:%255[^\n]", &number, text) == 2) {}
+/**
+ * Appends a request to the DRAMSys trace. The line is formatted straight into the write buffer,
+ * which only gets written to disk once it is full.
+ * @param df Pointer to an open DRAMSys writer (openDramsysFile should be used).
+ * @param timestamp The time at which the request reaches the memory, in DRAMSYS_TICKS_PER_SECOND units.
+ * @param operation LOAD for reads, STORE for writes.
+ * @param address The address of the request.
+ */
+void writeToDramsysFile(DramsysFile* df, uint64_t timestamp, Operation operation, uint64_t address) {
+    static const char hexDigits[] = "0123456789abcdef";
+    char digits[20];
+    int numDigits = 0;
 
-    // If the file is empty, the timestamp should begin in 0 or 1, so -1 gets returned (It will get incremented afterwards)
-    if (ftell(*f) == 0) {
-		number = -1;
-	}
+	// The writer gets checked before writing
+    if (df->file == NULL) {
+        return;
+    }
 
-    // The file is closed and reopened in append mode
-    fclose(*f);
-	*f = fopen(filename, "a");
+    // Make sure there is always room for a full line
+    if (df->used + DRAMSYS_MAX_LINE_LENGTH > DRAMSYS_BUFFER_SIZE) {
+        flushDramsysFile(df);
+    }
 
-	return number;
-}
+    char* line = df->buffer + df->used;
+
+    // Timestamp in decimal (Digits are generated backwards)
+    do {
+        digits[numDigits++] = '0' + timestamp % 10;
+        timestamp /= 10;
+    } while (timestamp != 0);
+    while (numDigits > 0) *line++ = digits[--numDigits];
+
+    // Command
+    const char* command = (operation == LOAD) ? ":\tread\t0x" : ":\twrite\t0x";
+    while (*command) *line++ = *command++;
 
+    // Address in hexadecimal
+    do {
+        digits[numDigits++] = hexDigits[address & 0xF];
+        address >>= 4;
+    } while (address != 0);
+    while (numDigits > 0) *line++ = digits[--numDigits];
+
+    *line++ = '\n';
+
+    df->used = line - df->buffer;
+    df->requests++;
+}
 
 /**
- * Appends the specified memory address to the specified filename.
- * @param f Pointer to the end of the file to append the content (open_dramsys_file should be used).
- * @param lastNumber The number of the last memory access.
- * @param address The address to append to the file.
- * @param readOrWrite 0 If read, 1 if write.
+ * Writes all the buffered lines to the DRAMSys trace file.
+ * @param df Pointer to the writer.
  */
-void writeToDramsysFile(FILE** f, int lastNumber, int readOrWrite, int address) {
-	// The pointer gets checked before writing
-    if (*f == NULL) {
-        perror("File pointer is null\n");
-        return;
+void flushDramsysFile(DramsysFile* df) {
+    if (df->file != NULL && df->used > 0) {
+        fwrite(df->buffer, 1, df->used, df->file);
     }
 
-    // The line gets written to the file
-    if (readOrWrite == 0) {
-		fprintf(*f, "%d:\tread\t0x%x\n",lastNumber + 1, address);
-	} else {
-		fprintf(*f, "%d:\twrite\t0x%x\n",lastNumber + 1, address);
-	}
+    df->used = 0;
 }
 
 /**
  * Count the number of lines in the file.
  */
-int countLines(FILE* fp) {
-   int count = 0;
+uint64_t countLines(FILE* fp) {
+   uint64_t count = 0;
 
    for (char c = getc(fp); c != EOF; c = getc(fp))
       if (c == '\n')
@@ -397,9 +426,39 @@ int countLines(FILE* fp) {
 }
 
 /**
- * Closes the DRAMSys trace file.
- * @param f The file to be closed.
+ * Seeds the simulation's random number generator.
+ * @param seed The seed.
+ */
+void seedRand(uint32_t seed) {
+    // The state of a xorshift generator can never be 0
+    randState = ((uint64_t) seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * Generates a pseudo-random number. Unlike rand(), the whole state is in randState, so it can be saved and restored.
+ * @return uint32_t The random number.
+ */
+uint32_t simRand() {
+    // xorshift64*
+    randState ^= randState >> 12;
+    randState ^= randState << 25;
+    randState ^= randState >> 27;
+    return (uint32_t) ((randState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * Flushes and closes the DRAMSys trace file.
+ * @param df The writer to be closed.
  */
-void closeDramsysFile(FILE **f) {
-    fclose(*f);
+void closeDramsysFile(DramsysFile* df) {
+    if (df->file == NULL) {
+        return;
+    }
+
+    flushDramsysFile(df);
+    fclose(df->file);
+    free(df->buffer);
+
+    df->file = NULL;
+    df->buffer = NULL;
 }
\ No newline at end of file
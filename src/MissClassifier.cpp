@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <vector>
+
+#include "MissClassifier.h"
+
+/**
+ * Constructs a new classifier.
+ * @param numLines The number of lines of the cache being classified. The shadow cache has the same number.
+ */
+MissClassifier::MissClassifier(uint64_t numLines) {
+    capacity = numLines;
+    clear();
+}
+
+/**
+ * References a line, updating the set of seen lines and the shadow fully associative LRU cache. O(log n).
+ * @param lineAddress The address of the line without the offset bits.
+ * @param record Returns what was modified, so that the reference can be undone.
+ * @return MissType The type the miss would be if the reference missed in the real cache.
+ */
+MissType MissClassifier::reference(uint64_t lineAddress, ClassifierRecord* record) {
+    MissType type;
+
+    record->classifier = this;
+    record->lineAddress = lineAddress;
+    record->wasSeen = markSeen(lineAddress);
+    record->evicted = false;
+
+    std::unordered_map<uint64_t, uint64_t>::iterator it = stamps.find(lineAddress);
+    record->wasPresent = (it != stamps.end());
+
+    if (record->wasPresent) {
+        // Shadow hit, move the line to the most recently used position
+        record->oldStamp = it->second;
+        recency.erase(it->second);
+        it->second = ++clock;
+        type = MISS_CONFLICT;
+    } else {
+        // Shadow miss, make room by evicting the least recently used line
+        if (stamps.size() >= capacity) {
+            std::map<uint64_t, uint64_t>::iterator lru = recency.begin();
+            record->evicted = true;
+            record->evictedStamp = lru->first;
+            record->evictedAddress = lru->second;
+            stamps.erase(lru->second);
+            recency.erase(lru);
+        }
+
+        stamps[lineAddress] = ++clock;
+        type = record->wasSeen ? MISS_CAPACITY : MISS_COMPULSORY;
+    }
+
+    recency[clock] = lineAddress;
+
+    return type;
+}
+
+/**
+ * References several lines in order, for hits that need neither a classification nor a record to undo them.
+ * @param lineAddresses The addresses of the lines without the offset bits.
+ * @param count The number of lines.
+ */
+void MissClassifier::referenceHits(const uint64_t* lineAddresses, size_t count) {
+    ClassifierRecord record;
+
+    for (size_t i = 0; i < count; i++) {
+        reference(lineAddresses[i], &record);
+    }
+}
+
+/**
+ * Undoes a reference. References must be undone newest first.
+ * @param record The record the reference returned.
+ */
+void MissClassifier::undo(const ClassifierRecord* record) {
+    recency.erase(clock);
+    stamps.erase(record->lineAddress);
+    clock--;
+
+    if (record->wasPresent) {
+        stamps[record->lineAddress] = record->oldStamp;
+        recency[record->oldStamp] = record->lineAddress;
+    }
+
+    if (record->evicted) {
+        stamps[record->evictedAddress] = record->evictedStamp;
+        recency[record->evictedStamp] = record->evictedAddress;
+    }
+
+    if (!record->wasSeen) {
+        unmarkSeen(record->lineAddress);
+    }
+}
+
+/**
+ * Adds a line to the seen lines.
+ * @param lineAddress The address of the line without the offset bits.
+ * @return bool If the line had already been seen.
+ */
+bool MissClassifier::markSeen(uint64_t lineAddress) {
+    // Value-initialised, so new chunks start with no line seen
+    SeenChunk* chunk = &seen[lineAddress / CLASSIFIER_CHUNK_LINES];
+    uint64_t offset = lineAddress % CLASSIFIER_CHUNK_LINES;
+    uint64_t mask = (uint64_t) 1 << (offset % 64);
+    bool wasSeen = (chunk->bits[offset / 64] & mask) != 0;
+
+    chunk->bits[offset / 64] |= mask;
+    numSeen += !wasSeen;
+    return wasSeen;
+}
+
+/**
+ * Removes a seen line, when its first reference is undone. Its chunk is kept.
+ * @param lineAddress The address of the line without the offset bits.
+ */
+void MissClassifier::unmarkSeen(uint64_t lineAddress) {
+    SeenChunk* chunk = &seen[lineAddress / CLASSIFIER_CHUNK_LINES];
+    uint64_t offset = lineAddress % CLASSIFIER_CHUNK_LINES;
+
+    chunk->bits[offset / 64] &= ~((uint64_t) 1 << (offset % 64));
+    numSeen--;
+}
+
+/**
+ * Forgets all the referenced lines.
+ */
+void MissClassifier::clear() {
+    clock = 0;
+    numSeen = 0;
+    seen.clear();
+    stamps.clear();
+    recency.clear();
+}
+
+/**
+ * Writes the seen lines and the shadow cache to a checkpoint.
+ * @param file The checkpoint file, opened for writing.
+ */
+void MissClassifier::saveState(FILE* file) {
+    std::vector<uint64_t> data;
+
+    // Header
+    data.push_back(clock);
+    data.push_back(numSeen);
+    data.push_back(recency.size());
+
+    // Seen lines (Sorted, so that identical states give identical checkpoints), followed by the shadow cache as (stamp, address) pairs
+    for (std::pair<const uint64_t, SeenChunk>& chunk : seen) {
+        for (uint32_t i = 0; i < CLASSIFIER_CHUNK_LINES; i++) {
+            if ((chunk.second.bits[i / 64] >> (i % 64)) & 1) {
+                data.push_back(chunk.first * CLASSIFIER_CHUNK_LINES + i);
+            }
+        }
+    }
+    std::sort(data.begin() + 3, data.end());
+    for (std::pair<const uint64_t, uint64_t>& entry : recency) {
+        data.push_back(entry.first);
+        data.push_back(entry.second);
+    }
+
+    fwrite(data.data(), sizeof(uint64_t), data.size(), file);
+}
+
+/**
+ * Restores the seen lines and the shadow cache from a checkpoint written by saveState.
+ * @param file The checkpoint file, opened for reading.
+ * @return int 0 if Ok, -1 if the checkpoint is truncated.
+ */
+int MissClassifier::loadState(FILE* file) {
+    uint64_t header[3];
+
+    clear();
+
+    if (fread(header, sizeof(uint64_t), 3, file) != 3 || header[2] > capacity) {
+        return -1;
+    }
+
+    // The number of seen lines comes from the file, so they are read a chunk at a time instead of trusting it for a
+    // single allocation. A corrupt count just runs out of file
+    uint64_t lines[CLASSIFIER_CHUNK_LINES];
+    for (uint64_t read = 0; read < header[1]; ) {
+        size_t count = std::min<uint64_t>(CLASSIFIER_CHUNK_LINES, header[1] - read);
+        if (fread(lines, sizeof(uint64_t), count, file) != count) {
+            clear();
+            return -1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            markSeen(lines[i]);
+        }
+        read += count;
+    }
+
+    std::vector<uint64_t> data(header[2] * 2);
+    if (fread(data.data(), sizeof(uint64_t), data.size(), file) != data.size()) {
+        clear();
+        return -1;
+    }
+
+    clock = header[0];
+    for (uint64_t i = 0; i < data.size(); i += 2) {
+        recency[data[i]] = data[i + 1];
+        stamps[data[i + 1]] = data[i];
+    }
+
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <math.h>
+#include <algorithm>
 
 #include "Misc.h"
 #include "PolicyReplacement.h"
@@ -17,9 +18,14 @@
 #define CPU_KEYS 3
 #define MEMORY_KEYS 5
 #define CACHE_KEYS 7
+#define CACHE_TOPOLOGY_KEYS 3       // Only valid in named cache sections, after the rest of the cache keys
 const char* keysCpu[] =       {"address_width", "word_width", "rand_seed"};
 const char* keysMemory[] =    {"size", "access_time_1","access_time_burst", "page_size", "page_base_address"};
-const char* keysCache[] =     {"line_size", "size", "associativity", "write_policy", "replacement_policy", "separated", "access_time"};
+const char* keysCache[] =     {"line_size", "size", "associativity", "write_policy", "replacement_policy", "separated", "access_time",
+                               "next", "core", "side"};
+
+// Prefix of the named cache sections, [cache.NAME]
+#define CACHE_NAMED_PREFIX "cache."
 
 /* Wrappers for misc parsing functions */
 
@@ -145,9 +151,11 @@ void checkSectionKeys(dictionary *ini, const char *section, int numberOfValidKey
 /**
  * Read the simulator configuration file.
  * @param ini_name the file name
- * @param cacheLevels Pointer to a cache level counter. Will return the number of cache levels in the config file.
+ * @param cacheSections Returns the name of the section of each cache. Numbered caches are sorted by their number, named ones
+ *                      keep the order of the file.
+ * @param named Returns if the caches are named [cache.NAME] sections instead of numbered [cacheN] ones.
  */
-dictionary *readConfigurationFile(char* iniName, uint8_t* cacheLevels) {
+dictionary *readConfigurationFile(char* iniName, std::vector<std::string>* cacheSections, bool* named) {
     int errors = 0;
     dictionary *ini;
 
@@ -160,6 +168,7 @@ dictionary *readConfigurationFile(char* iniName, uint8_t* cacheLevels) {
     int numberCPUs = 0;
     int numberCaches = 0;
     int numberMemories = 0;
+    std::vector<std::string> namedSections;
 
     /* Check that all the configuration file sections are correct.
      * No missing sections. No unknown sections. */
@@ -174,6 +183,23 @@ dictionary *readConfigurationFile(char* iniName, uint8_t* cacheLevels) {
         } else if (strcmp(section, "memory") == 0) {
             // Count memory sections. There can be only one memory section
             numberMemories++;
+        // If the name of the section is like "cache.NAME"
+        } else if (strncmp(section, CACHE_NAMED_PREFIX, strlen(CACHE_NAMED_PREFIX)) == 0) {
+            const char* name = section + strlen(CACHE_NAMED_PREFIX);
+            bool correctName = name[0] != '\0' && strcmp(name, "memory") != 0;
+
+            // Names become the prefix of the statistics, so they are kept simple
+            for (int j = 0; name[j] && correctName; j++) {
+                correctName = isalnum(name[j]) || name[j] == '_';
+            }
+
+            if (correctName) {
+                namedSections.push_back(section);
+                checkSectionKeys(ini, section, CACHE_KEYS + CACHE_TOPOLOGY_KEYS, (char**) keysCache, &errors);
+            } else {
+                fprintf(stderr,"ConfigParser Error: Invalid cache section name [%s]. Names can only have letters, digits and _, and cannot be memory\n", section);
+                errors++;
+            }
         // If the name of the section is like "cache..."
         } else if (strncmp(section, "cache", 5) == 0) {
             int correctNum = 1;
@@ -230,9 +256,9 @@ dictionary *readConfigurationFile(char* iniName, uint8_t* cacheLevels) {
         checkSectionKeys(ini, "memory", MEMORY_KEYS, (char**) keysMemory, &errors);
     }
 
-    // Check that the number of cache levels is within range
-    if (numberCaches > MAX_CACHE_LEVELS) {
-        fprintf(stderr,"ConfigParser Error: The number of caches is excesive.\n");
+    // Numbered caches form a chain, named ones describe their own topology. Both cannot be mixed
+    if (numberCaches > 0 && !namedSections.empty()) {
+        fprintf(stderr,"ConfigParser Error: [cacheN] and [cache.NAME] sections cannot be mixed\n");
         errors++;
     }
 
@@ -242,27 +268,195 @@ dictionary *readConfigurationFile(char* iniName, uint8_t* cacheLevels) {
         return NULL;
     }
 
-    *cacheLevels = numberCaches;
+    *named = !namedSections.empty();
+    if (*named) {
+        *cacheSections = namedSections;
+    } else {
+        cacheSections->clear();
+        for (int i = 1; i <= numberCaches; i++) {
+            cacheSections->push_back("cache" + std::to_string(i));
+        }
+    }
+
     return ini;
 }
 
 /**
- * Parses all the configuration in the provided ini file and returns the config the sim should have.
- * @param iniName Path to the ini config file.
- * @param sc Pointer to a SimulatorConfig struct.
- * @return 0 if Ok, -1 if warnings, -2 if fatal errors
+ * Reorders the values of every cache.
+ * @param values The values, one per cache.
+ * @param order The index that each position takes its value from.
  */
-int parseConfiguration(char* iniName, SimulatorConfig* sc) {
+template <typename T>
+static void reorderCaches(std::vector<T>& values, const std::vector<uint32_t>& order) {
+    std::vector<T> reordered;
+    for (uint32_t i = 0; i < order.size(); i++) {
+        reordered.push_back(values[order[i]]);
+    }
+    values = reordered;
+}
+
+/**
+ * Reads the topology keys of the named caches (next, core and side), computes the level of every cache and sorts them
+ * by level, so that every cache comes before the ones below it.
+ * @param ini The configuration file.
+ * @param sections The section of each cache, sorted along with the caches.
+ * @param sc The configuration, with the rest of the keys of the caches already parsed.
+ * @return int The number of errors.
+ */
+int parseTopology(dictionary* ini, std::vector<std::string>* sections, SimulatorConfig* sc) {
     int errors = 0;
-    int cacheLevels = 0;
+    uint32_t numCaches = sections->size();
+    std::vector<bool> isTarget(numCaches, false);
+    char param[300];
+
+    sc->cacheNext.assign(numCaches, -1);
+    sc->cacheCore.assign(numCaches, -1);
+    sc->cacheSide.assign(numCaches, CACHE_SIDE_BOTH);
+    sc->cacheLevel.assign(numCaches, 0);
+
+    // cache:next, either another cache or the main memory
+    for (uint32_t i = 0; i < numCaches; i++) {
+        snprintf(param, sizeof(param), "%s:next", (*sections)[i].c_str());
+        std::string next = iniparser_getstring(ini, param, "memory");
+        std::transform(next.begin(), next.end(), next.begin(), ::tolower);
+
+        if (next == "memory") {
+            continue;
+        }
 
-    // Read configuration file
-    dictionary *ini;
+        for (uint32_t j = 0; j < numCaches; j++) {
+            if (sc->cacheName[j] == next) {
+                sc->cacheNext[i] = j;
+            }
+        }
 
-    if((ini = readConfigurationFile(iniName, &sc->miscCacheLevels)) == NULL) {
-       return -2;
+        if (sc->cacheNext[i] == -1 || sc->cacheNext[i] == (int32_t) i) {
+            fprintf(stderr,"ConfigParser Error: %s must be memory or the name of another cache\n", param);
+            errors++;
+            sc->cacheNext[i] = -1;
+        } else {
+            isTarget[sc->cacheNext[i]] = true;
+        }
+    }
+
+    // cache:core and cache:side, only for the caches that no other cache sends its misses to
+    for (uint32_t i = 0; i < numCaches; i++) {
+        const char* section = (*sections)[i].c_str();
+
+        snprintf(param, sizeof(param), "%s:core", section);
+        const char* core = iniparser_getstring(ini, param, NULL);
+        snprintf(param, sizeof(param), "%s:side", section);
+        const char* side = iniparser_getstring(ini, param, NULL);
+
+        if (isTarget[i]) {
+            if (core != NULL || side != NULL) {
+                fprintf(stderr,"ConfigParser Error: %s gets the misses of another cache, so it cannot have a core or a side\n", section);
+                errors++;
+            }
+            continue;
+        }
+
+        sc->cacheCore[i] = (core == NULL) ? 0 : parseInt(core);
+        if (sc->cacheCore[i] < 0) {
+            fprintf(stderr,"ConfigParser Error: %s:core value is not valid\n", section);
+            errors++;
+            sc->cacheCore[i] = 0;
+        }
+
+        if (side == NULL || strcasecmp(side, "both") == 0) {
+            sc->cacheSide[i] = CACHE_SIDE_BOTH;
+        } else if (strcasecmp(side, "instructions") == 0) {
+            sc->cacheSide[i] = CACHE_SIDE_INSTRUCTIONS;
+        } else if (strcasecmp(side, "data") == 0) {
+            sc->cacheSide[i] = CACHE_SIDE_DATA;
+        } else {
+            fprintf(stderr,"ConfigParser Error: %s:side must be both, instructions or data\n", section);
+            errors++;
+        }
     }
 
+    // Every core needs a cache for its instructions and one for its data
+    sc->miscNumCores = 1;
+    for (uint32_t i = 0; i < numCaches; i++) {
+        sc->miscNumCores = std::max<uint32_t>(sc->miscNumCores, sc->cacheCore[i] + 1);
+    }
+    for (uint32_t core = 0; core < sc->miscNumCores; core++) {
+        int entries[NUM_CACHE_SIDES] = {0};
+        for (uint32_t i = 0; i < numCaches; i++) {
+            if (sc->cacheCore[i] == (int32_t) core) entries[sc->cacheSide[i]]++;
+        }
+
+        if (entries[CACHE_SIDE_BOTH] + entries[CACHE_SIDE_INSTRUCTIONS] != 1 || entries[CACHE_SIDE_BOTH] + entries[CACHE_SIDE_DATA] != 1) {
+            fprintf(stderr,"ConfigParser Error: Core %u must have exactly one cache for its instructions and one for its data\n", core);
+            errors++;
+        }
+    }
+
+    if (errors > 0) {
+        return errors;
+    }
+
+    // Levels, as the longest path from a core. A level beyond the number of caches means that the misses go around in a loop
+    for (uint32_t i = 0; i < numCaches; i++) {
+        if (sc->cacheCore[i] != -1) sc->cacheLevel[i] = 1;
+    }
+    for (uint32_t pass = 0; pass < numCaches; pass++) {
+        for (uint32_t i = 0; i < numCaches; i++) {
+            if (sc->cacheLevel[i] != 0 && sc->cacheNext[i] != -1) {
+                uint32_t* next = &sc->cacheLevel[sc->cacheNext[i]];
+                *next = std::max(*next, sc->cacheLevel[i] + 1);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < numCaches; i++) {
+        if (sc->cacheLevel[i] == 0 || sc->cacheLevel[i] > numCaches) {
+            fprintf(stderr,"ConfigParser Error: The misses of %s go around in a loop\n", (*sections)[i].c_str());
+            return errors + 1;
+        }
+    }
+
+    // Sort the caches by level, keeping the order of the file within a level
+    std::vector<uint32_t> order(numCaches), position(numCaches);
+    for (uint32_t i = 0; i < numCaches; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [sc](uint32_t a, uint32_t b) { return sc->cacheLevel[a] < sc->cacheLevel[b]; });
+    for (uint32_t i = 0; i < numCaches; i++) {
+        position[order[i]] = i;
+    }
+
+    reorderCaches(*sections, order);
+    reorderCaches(sc->cacheSize, order);
+    reorderCaches(sc->cacheLineSize, order);
+    reorderCaches(sc->cacheAccessTime, order);
+    reorderCaches(sc->cacheAssoc, order);
+    reorderCaches(sc->cacheIsSplit, order);
+    reorderCaches(sc->cachePolicyWrite, order);
+    reorderCaches(sc->cachePolicyReplacement, order);
+    reorderCaches(sc->cacheName, order);
+    reorderCaches(sc->cacheNext, order);
+    reorderCaches(sc->cacheCore, order);
+    reorderCaches(sc->cacheSide, order);
+    reorderCaches(sc->cacheLevel, order);
+
+    for (uint32_t i = 0; i < numCaches; i++) {
+        if (sc->cacheNext[i] != -1) sc->cacheNext[i] = position[sc->cacheNext[i]];
+    }
+
+    return 0;
+}
+
+/**
+ * Parses the values of a configuration file already read by readConfigurationFile.
+ * @param ini The configuration file.
+ * @param sections The section of each cache, as returned by readConfigurationFile.
+ * @param named If the caches are named [cache.NAME] sections.
+ * @param sc Returns the configuration.
+ * @return 0 if Ok, -1 if warnings, -2 if fatal errors
+ */
+static int parseValues(dictionary* ini, std::vector<std::string> sections, bool named, SimulatorConfig* sc) {
+    int errors = 0;
+
     // CPU config
     parseConfInt(ini,"cpu:address_width", &sc->cpuAddressWidth, &errors);
     parseConfInt(ini,"cpu:word_width", &sc->cpuWordWidth, &errors);
@@ -308,41 +502,60 @@ int parseConfiguration(char* iniName, SimulatorConfig* sc) {
     }
 
     // Multilevel cache configs
+    sc->miscCacheLevels = sections.size();
+    sc->cacheSize.assign(sc->miscCacheLevels, 0);
+    sc->cacheLineSize.assign(sc->miscCacheLevels, 1);
+    sc->cacheAccessTime.assign(sc->miscCacheLevels, 0.0);
+    sc->cacheAssoc.assign(sc->miscCacheLevels, 1);
+    sc->cacheIsSplit.assign(sc->miscCacheLevels, false);
+    sc->cachePolicyWrite.assign(sc->miscCacheLevels, WRITE_BACK);
+    sc->cachePolicyReplacement.assign(sc->miscCacheLevels, LRU);
+    sc->cacheName.clear();
+
     // Browse the cache array and check the configuration of each cache.
-    for (int cacheNumber = 0; cacheNumber < sc->miscCacheLevels; cacheNumber++) {
+    for (uint32_t cacheNumber = 0; cacheNumber < sc->miscCacheLevels; cacheNumber++) {
+        const char* section = sections[cacheNumber].c_str();
+
+        // Numbered caches are named after their level
+        if (named) {
+            sc->cacheName.push_back(section + strlen(CACHE_NAMED_PREFIX));
+        } else {
+            sc->cacheName.push_back("l" + std::to_string(cacheNumber + 1));
+        }
+
         // cache:line_size
-        char param[50];
-        sprintf(param, "cache%d:line_size", cacheNumber + 1);
+        char param[300];
+        snprintf(param, sizeof(param), "%s:line_size", section);
         parseConfLong(ini, param, &sc->cacheLineSize[cacheNumber],&errors,true);
         if (!isPowerOf2(sc->cacheLineSize[cacheNumber])) {
-	        fprintf(stderr,"ConfigParser Warning: cache%d:line_size must be power of 2\n", cacheNumber + 1);
+	        fprintf(stderr,"ConfigParser Warning: %s:line_size must be power of 2\n", section);
             errors++;
 	    }
 
         // cache:size
-        sprintf(param, "cache%d:size", cacheNumber + 1);
+        snprintf(param, sizeof(param), "%s:size", section);
         parseConfLong(ini, param, &sc->cacheSize[cacheNumber],&errors, true);
         if ((sc->cacheSize[cacheNumber]) % (sc->cacheLineSize[cacheNumber]) != 0) {
-	        fprintf(stderr,"ConfigParser Warning: cache%d:size must be a multiple of cache%d:line_size\n", cacheNumber + 1, cacheNumber + 1);
+	        fprintf(stderr,"ConfigParser Warning: %s:size must be a multiple of %s:line_size\n", section, section);
             errors++;
 	    }
 
         // cache:separated
-        sprintf(param, "cache%d:separated", cacheNumber + 1);
+        snprintf(param, sizeof(param), "%s:separated", section);
         const char* cacheSeparated = iniparser_getstring(ini, param, NULL);
         long long_separated = parseBoolean(cacheSeparated);
         if (long_separated == -1) {
-            fprintf(stderr,"ConfigParser Warning: cache%d:separated value is not valid\n", cacheNumber + 1);
+            fprintf(stderr,"ConfigParser Warning: %s:separated value is not valid\n", section);
             errors++;
         } else if (long_separated == -2) {
-            fprintf(stderr,"ConfigParser Warning: Missing value cache%d:separated\n", cacheNumber + 1);
+            fprintf(stderr,"ConfigParser Warning: Missing value %s:separated\n", section);
             errors++;
         } else {
             sc->cacheIsSplit[cacheNumber] = long_separated;
         }
 
         // cache:asocitivity
-        sprintf(param, "cache%d:associativity", cacheNumber + 1);
+        snprintf(param, sizeof(param), "%s:associativity", section);
         //this is the number of lines. For error check
         int num_lines=sc->cacheSize[cacheNumber] / sc->cacheLineSize[cacheNumber];
 
@@ -353,20 +566,20 @@ int parseConfiguration(char* iniName, SimulatorConfig* sc) {
         const char* cache_asociativity = iniparser_getstring(ini, param, NULL);
         // si es F es de compleatamente asociativa. Un solo set. Tantas lines/set como lines totales.
         if (cache_asociativity != NULL&&strcmp(cache_asociativity, "F") == 0) {
-            sc->cacheAssoc[cacheNumber] = sc->cacheSize[cacheNumber] / sc->cacheLineSize[cacheNumber];
+            sc->cacheAssoc[cacheNumber] = num_lines;
         } else {
             long long_asociativity = parseInt(cache_asociativity);
             if (long_asociativity == -1) {
-                fprintf(stderr,"ConfigParser Warning: cache%d:associativity value is not valid\n", cacheNumber + 1);
+                fprintf(stderr,"ConfigParser Warning: %s:associativity value is not valid\n", section);
                 errors++;
             } else if (long_asociativity == -2) {
-                fprintf(stderr,"ConfigParser Warning: Missing value cache%d:associativity\n", cacheNumber + 1);
+                fprintf(stderr,"ConfigParser Warning: Missing value %s:associativity\n", section);
                 errors++;
             } else if (!isPowerOf2(long_asociativity)) {
-                fprintf(stderr,"ConfigParser Warning: The value of cache%d:associativity must be power of 2\n", cacheNumber + 1);
+                fprintf(stderr,"ConfigParser Warning: The value of %s:associativity must be power of 2\n", section);
                 errors++;
             } else if (long_asociativity>num_lines) {
-                fprintf(stderr,"ConfigParser Warning: The value of cache%d:associativity can't be bigger than the number of lines\n", cacheNumber + 1);
+                fprintf(stderr,"ConfigParser Warning: The value of %s:associativity can't be bigger than the number of lines\n", section);
                 errors++;
             }else {
                 sc->cacheAssoc[cacheNumber] = long_asociativity;
@@ -374,38 +587,63 @@ int parseConfiguration(char* iniName, SimulatorConfig* sc) {
         }
 
         // cache:write_policy
-        sprintf(param, "cache%d:write_policy", cacheNumber + 1);
+        snprintf(param, sizeof(param), "%s:write_policy", section);
         const char* cache_write_policy = iniparser_getstring(ini, param, NULL);
         long long_write_policy = parseWritePolicy(cache_write_policy);
         if (long_write_policy == -1) {
-            fprintf(stderr,"ConfigParser Warning: cache%d:write_policy value is not valid\n", cacheNumber + 1);
+            fprintf(stderr,"ConfigParser Warning: %s:write_policy value is not valid\n", section);
             errors++;
         } else if (long_write_policy==-2) {
-            fprintf(stderr,"ConfigParser Warning: Missing value cache%d:write_policy\n", cacheNumber + 1);
+            fprintf(stderr,"ConfigParser Warning: Missing value %s:write_policy\n", section);
             errors++;
         } else {
             sc->cachePolicyWrite[cacheNumber] = (PolicyWrite) long_write_policy;
         }
 
         // reading key cache:replacement_policy
-        sprintf(param, "cache%d:replacement_policy", cacheNumber + 1);
+        snprintf(param, sizeof(param), "%s:replacement_policy", section);
         const char* cache_replacement = iniparser_getstring(ini, param, NULL);
         long long_replacement = parseReplacementPolicy(cache_replacement);
         if (long_replacement == -1) {
-            fprintf(stderr,"ConfigParser Warning: replacement_policy value for cache%d is not valid.\n", cacheNumber + 1);
+            fprintf(stderr,"ConfigParser Warning: replacement_policy value for %s is not valid.\n", section);
             errors++;
         } else if (long_replacement == -2) {
-            fprintf(stderr,"ConfigParser Warning: Missing replacement_policy value for cache%d.\n", cacheNumber + 1);
+            fprintf(stderr,"ConfigParser Warning: Missing replacement_policy value for %s.\n", section);
             errors++;
         } else {
             sc->cachePolicyReplacement[cacheNumber] = (PolicyReplacement) long_replacement;
         }
 
         // reading key cache:access_time
-        sprintf(param, "cache%d:access_time", cacheNumber + 1);
+        snprintf(param, sizeof(param), "%s:access_time", section);
         parseConfDouble(ini, param, &sc->cacheAccessTime[cacheNumber], &errors);
     }
 
+    // Topology of the caches. Numbered ones form a chain from the only core, named ones are wired by their keys
+    if (named) {
+        if (parseTopology(ini, &sections, sc) > 0) {
+            fprintf(stderr,"\nThe topology of the caches is invalid\n");
+            return -2;
+        }
+    } else {
+        sc->miscNumCores = 1;
+        sc->cacheNext.clear();
+        sc->cacheCore.assign(sc->miscCacheLevels, -1);
+        sc->cacheSide.assign(sc->miscCacheLevels, CACHE_SIDE_BOTH);
+        sc->cacheLevel.clear();
+        for (uint32_t i = 0; i < sc->miscCacheLevels; i++) {
+            sc->cacheNext.push_back((i + 1 < sc->miscCacheLevels) ? i + 1 : -1);
+            sc->cacheLevel.push_back(i + 1);
+        }
+        if (sc->miscCacheLevels > 0) sc->cacheCore[0] = 0;
+    }
+
+    // Filter streams and the per level breakdowns need a chain
+    sc->miscIsChain = sc->miscNumCores == 1 && (sc->miscCacheLevels == 0 || sc->cacheSide[0] == CACHE_SIDE_BOTH);
+    for (uint32_t i = 0; i < sc->miscCacheLevels; i++) {
+        sc->miscIsChain &= sc->cacheNext[i] == ((i + 1 < sc->miscCacheLevels) ? (int32_t) i + 1 : -1);
+    }
+
     if (errors > 0) {
         fprintf(stderr,"\nTotal warnings: %d\n", errors);
         return -1;
@@ -414,3 +652,233 @@ int parseConfiguration(char* iniName, SimulatorConfig* sc) {
     return 0;
 }
 
+/**
+ * Removes the blanks at both ends of a string.
+ * @param text The string.
+ * @return std::string The string without the blanks.
+ */
+static std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    size_t last = text.find_last_not_of(" \t");
+
+    return (first == std::string::npos) ? "" : text.substr(first, last - first + 1);
+}
+
+/**
+ * Writes a number with the largest of the K, M and G multipliers (base 2) that divides it.
+ * @param value The number.
+ * @return std::string The number, E.g. 16K for 16384.
+ */
+static std::string formatMultiplier(long value) {
+    const char* units = "KMG";
+    int unit = -1;
+
+    while (unit < 2 && value >= 1024 && value % 1024 == 0) {
+        value /= 1024;
+        unit++;
+    }
+
+    return std::to_string(value) + ((unit >= 0) ? std::string(1, units[unit]) : "");
+}
+
+/**
+ * Expands an item of a sweep list. A range FIRST..LAST [*FACTOR|+STEP] gives the integers from FIRST up to LAST, each
+ * one FACTOR times or STEP more than the previous (+1 by default). FIRST and LAST can have the multipliers K, M and G
+ * (base 2), and then the values keep them. Anything else is a single value.
+ * @param item The item.
+ * @param values Returns the values, appended to the ones already there.
+ * @return int 0 if Ok, -1 if the range is invalid or too long.
+ */
+static int expandSweepItem(const std::string& item, std::vector<std::string>* values) {
+    size_t dots = item.find("..");
+
+    if (dots == std::string::npos) {
+        values->push_back(item);
+        return 0;
+    }
+
+    std::string rest = item.substr(dots + 2);
+    size_t stepAt = rest.find_first_of("*+");
+    std::string first = trim(item.substr(0, dots));
+    std::string last = trim(rest.substr(0, stepAt));
+    std::string step = (stepAt == std::string::npos) ? "1" : trim(rest.substr(stepAt + 1));
+    bool multiply = stepAt != std::string::npos && rest[stepAt] == '*';
+
+    if (first.empty() || last.empty() || step.empty()) {
+        return -1;
+    }
+
+    long firstValue = parseLong(first.c_str(), true);
+    long lastValue = parseLong(last.c_str(), true);
+    long stepValue = parseLong(step.c_str(), false);
+    bool multipliers = !isdigit(first.back()) || !isdigit(last.back());
+
+    if (firstValue < 0 || lastValue < firstValue || stepValue < (multiply ? 2 : 1) || (multiply && firstValue == 0)) {
+        return -1;
+    }
+
+    for (long value = firstValue; value <= lastValue; value = multiply ? value * stepValue : value + stepValue) {
+        if (values->size() >= SWEEP_MAX_POINTS) {
+            return -1;
+        }
+        values->push_back(multipliers ? formatMultiplier(value) : std::to_string(value));
+    }
+
+    return 0;
+}
+
+/**
+ * Finds the keys of a configuration file that sweep a list or a range of values, and expands them.
+ * @param ini The configuration file.
+ * @param keys Returns the swept keys, as section:key.
+ * @param values Returns the values of each swept key.
+ * @return int The number of errors.
+ */
+static int findSweeps(dictionary* ini, std::vector<std::string>* keys, std::vector<std::vector<std::string>>* values) {
+    int errors = 0;
+
+    keys->clear();
+    values->clear();
+    for (int i = 0; i < iniparser_getnsec(ini); i++) {
+        const char* section = iniparser_getsecname(ini, i);
+        int numberKeys = iniparser_getsecnkeys(ini, section);
+        std::vector<const char*> sectionKeys(numberKeys);
+
+        iniparser_getseckeys(ini, section, sectionKeys.data());
+        for (int j = 0; j < numberKeys; j++) {
+            std::string value = iniparser_getstring(ini, sectionKeys[j], "");
+
+            if (value.find("..") == std::string::npos && value.find(',') == std::string::npos) {
+                continue;
+            }
+
+            std::vector<std::string> expanded;
+            size_t start = 0;
+            bool valid = true;
+            while (valid) {
+                size_t comma = value.find(',', start);
+                std::string item = trim(value.substr(start, comma - start));
+                valid = !item.empty() && expandSweepItem(item, &expanded) == 0;
+                if (comma == std::string::npos) {
+                    break;
+                }
+                start = comma + 1;
+            }
+
+            if (!valid) {
+                fprintf(stderr, "ConfigParser Error: %s is not a valid list or range, or it has more than %d values\n",
+                        sectionKeys[j], SWEEP_MAX_POINTS);
+                errors++;
+                continue;
+            }
+
+            keys->push_back(sectionKeys[j]);
+            values->push_back(expanded);
+        }
+    }
+
+    return errors;
+}
+
+/**
+ * Parses all the configuration in the provided ini file and returns the config the sim should have.
+ * @param iniName Path to the ini config file.
+ * @param sc Pointer to a SimulatorConfig struct.
+ * @return 0 if Ok, -1 if warnings, -2 if fatal errors
+ */
+int parseConfiguration(char* iniName, SimulatorConfig* sc) {
+    std::vector<std::string> sections;
+    std::vector<std::string> sweptKeys;
+    std::vector<std::vector<std::string>> sweptValues;
+    bool named;
+
+    // Read configuration file
+    dictionary *ini;
+
+    if((ini = readConfigurationFile(iniName, &sections, &named)) == NULL) {
+       return -2;
+    }
+
+    // A sweep is a set of configurations, which only parseSweep expands
+    if (findSweeps(ini, &sweptKeys, &sweptValues) > 0 || !sweptKeys.empty()) {
+        if (!sweptKeys.empty()) {
+            fprintf(stderr,"ConfigParser Error: %s sweeps the values of %s, which only simulations run with --nogui can expand\n",
+                    iniName, sweptKeys[0].c_str());
+        }
+        iniparser_freedict(ini);
+        return -2;
+    }
+
+    int result = parseValues(ini, sections, named, sc);
+    iniparser_freedict(ini);
+    return result;
+}
+
+/**
+ * Expands the configuration file of a sweep into one configuration per combination of the swept values. Any value of
+ * the file can be a comma separated list of values, or a range FIRST..LAST [*FACTOR|+STEP] of integers, E.g.
+ * size = 16K..4M *2 or replacement_policy = lru,fifo. Combinations with errors or warnings are left out.
+ * @param iniName Path to the ini config file.
+ * @param keys Returns the swept keys, as section:key. Empty if the file has no sweeps, and then it must be parsed with
+ *             parseConfiguration.
+ * @param points Returns the configurations, varying the last key fastest.
+ * @return int 0 if Ok, -2 if fatal errors.
+ */
+int parseSweep(char* iniName, std::vector<std::string>* keys, std::vector<SweepPoint>* points) {
+    std::vector<std::string> sections;
+    std::vector<std::vector<std::string>> values;
+    bool named;
+    dictionary* ini;
+
+    points->clear();
+    if ((ini = readConfigurationFile(iniName, &sections, &named)) == NULL) {
+        return -2;
+    }
+
+    if (findSweeps(ini, keys, &values) > 0) {
+        iniparser_freedict(ini);
+        return -2;
+    }
+
+    uint64_t numPoints = keys->empty() ? 0 : 1;
+    for (uint32_t i = 0; i < values.size() && numPoints <= SWEEP_MAX_POINTS; i++) {
+        numPoints *= values[i].size();
+    }
+    if (numPoints > SWEEP_MAX_POINTS) {
+        fprintf(stderr, "ConfigParser Error: The sweep of %s has more than %d configurations\n", iniName, SWEEP_MAX_POINTS);
+        iniparser_freedict(ini);
+        return -2;
+    }
+
+    for (uint64_t i = 0; i < numPoints; i++) {
+        SweepPoint point;
+        uint64_t index = i;
+
+        point.values.resize(keys->size());
+        for (int32_t j = keys->size() - 1; j >= 0; j--) {
+            point.values[j] = values[j][index % values[j].size()];
+            index /= values[j].size();
+            iniparser_set(ini, (*keys)[j].c_str(), point.values[j].c_str());
+        }
+
+        if (parseValues(ini, sections, named, &point.config) != 0) {
+            std::string name;
+            for (uint32_t j = 0; j < keys->size(); j++) {
+                name += ((j > 0) ? ", " : "") + (*keys)[j] + " = " + point.values[j];
+            }
+            fprintf(stderr, "ConfigParser Warning: Leaving out the configuration %s of the sweep\n\n", name.c_str());
+            continue;
+        }
+
+        points->push_back(point);
+    }
+
+    iniparser_freedict(ini);
+
+    if (!keys->empty() && points->empty()) {
+        fprintf(stderr, "ConfigParser Error: No configuration of the sweep of %s is valid\n", iniName);
+        return -2;
+    }
+
+    return 0;
+}
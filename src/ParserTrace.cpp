@@ -11,6 +11,8 @@
 
 #include "ParserTrace.h"
 #include "Misc.h"
+#include "CompressedTrace.h"
+#include "TraceImporter.h"
 
 /**
  * Remove comments and other string operations on a line from a trace file.
@@ -168,16 +170,60 @@ int parseLine(char* line, MemoryOperation* result){
    return 0;
 }
 
+/**
+ * Reads a whole stream of operations, such as a compressed or an imported trace, and stores all the operations in the
+ * memory operation pointer.
+ * 
+ * @param source The opened source
+ * @param ops Pointer to a memory operation. The function allocates the array and the operations
+ * @param numOperations Pointer to an unsigned integer that represents the number of operations.
+ * @return int 0 if Ok, -2 if fatal errors
+ */
+int loadSource(OperationSource* source, MemoryOperation*** ops, uint64_t* numOperations) {
+   MemoryOperation op;
+   uint64_t data;
+
+   uint64_t numberOfOperations = source->getNumOps();
+   *ops = (MemoryOperation**) malloc(sizeof(MemoryOperation*) * numberOfOperations);
+
+   op.data = &data;
+   for (uint64_t i = 0; i < numberOfOperations; i++) {
+      if (!source->next(&op)) {
+         for (uint64_t j = 0; j < i; j++) {
+            free((*ops)[j]->data);
+            free((*ops)[j]);
+         }
+         free(*ops);
+         return -2;
+      }
+
+      (*ops)[i] = (MemoryOperation*) malloc(sizeof(MemoryOperation));
+      *(*ops)[i] = op;
+      (*ops)[i]->data = nullptr;
+
+      if (op.operation == STORE) {
+         (*ops)[i]->data = (uint64_t*) malloc(sizeof(uint64_t));
+         (*ops)[i]->data[0] = data;
+      }
+   }
+
+   *numOperations = numberOfOperations;
+   return 0;
+}
+
 /**
  * Parses the given trace file and stores all the operations in the memory operation pointer. 
+ * Compressed traces and the external formats are detected and read as well.
  * The function allocates memory and the caller should free the pointer once finished.
  * 
  * @param traceFile A path to the trace file to parse
  * @param ops Pointer to a memory operation. The caller should NOT allocate memory, the function will do so dynamically depending on the travetrace's length
  * @param numOperations Pointer to an unsigned integer that represents the number of operations.
+ * @param baseAddress The page base address of the memory, which imported traces are checked against. 0 if the trace is
+ *                    not going to be simulated.
  * @return int 0 if Ok, -1 if warnings, -2 if fatal errors
  */
-int parseTrace(const char* traceFile, MemoryOperation*** ops, uint32_t* numOperations) {
+int parseTrace(const char* traceFile, MemoryOperation*** ops, uint64_t* numOperations, uint64_t baseAddress) {
    int errors = 0;
 
    // File related vars
@@ -189,6 +235,24 @@ int parseTrace(const char* traceFile, MemoryOperation*** ops, uint32_t* numOpera
    if (debugLevel == 1)
     printf("Loading trace file: %s\n", traceFile);
 
+   TraceFormat format = detectTraceFormat(traceFile);
+
+   if (format == TRACE_FORMAT_COMPRESSED) {
+      CompressedTraceReader reader;
+      if (reader.open(traceFile, 0) != 0) {
+         return -2;
+      }
+      return loadSource(&reader, ops, numOperations);
+   }
+
+   if (format != TRACE_FORMAT_VCA) {
+      TraceImporter importer;
+      if (importer.open(traceFile, format, baseAddress) != 0) {
+         return -2;
+      }
+      return loadSource(&importer, ops, numOperations);
+   }
+
    // Open the file and check for errors 
    file = fopen(traceFile, "r");
 
@@ -198,14 +262,14 @@ int parseTrace(const char* traceFile, MemoryOperation*** ops, uint32_t* numOpera
    }
 
    // Count the lines and rewind the pointer to the start of the file
-   int numberOfLines = countLines(file);
+   uint64_t numberOfLines = countLines(file);
    rewind(file);
 
    // Allocate memory to store as many operations as lines
    *ops = (MemoryOperation**) malloc(sizeof(MemoryOperation*) * numberOfLines);
 
-   int currentLineNumber = 0;
-   int numberOfOperations = 0;
+   uint64_t currentLineNumber = 0;
+   uint64_t numberOfOperations = 0;
 
    // Read all the lines in the file
    while ((read = getline(&currentLine, &len, file)) != -1) {
@@ -10,86 +10,376 @@ Simulator::Simulator(SimulatorConfig* sc, MemoryOperation** ops) {
     wordWidth = sc->cpuWordWidth / 8;           // In Bytes
     addressWidth = sc->cpuAddressWidth;         // In bits
     numOperations = sc->miscNumOperations;
-    cacheLevels = sc->miscCacheLevels;
+    cacheLevels = std::min<uint32_t>(sc->miscCacheLevels, sc->cacheSize.size());
+    quiet = false;
     cycle = 0;
 
     // Set the rand seed for the simulation
-    srand(sc->cpuRandSeed);
+    randSeed = sc->cpuRandSeed;
+    seedRand(randSeed);
 
     // Store the trace
     operations = ops;
+    source = nullptr;
+
+    // Requests replayed into a lower level span whole lines of the level above, so replies and streamed operations
+    // get room for the longest line
+    maxWords = 1;
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        maxWords = std::max<uint32_t>(maxWords, sc->cacheLineSize[i] / wordWidth);
+    }
+    streamData = (uint64_t*) calloc(maxWords, sizeof(uint64_t));
+    streamOperation.data = streamData;
+    filterRecorder = nullptr;
+    filter = nullptr;
 
     // Init the stats
     totalAccessTime = 0.0f;
+    warmupOperations = 0;
+
+    // The journal, the interval sampling and the history are only enabled on demand
+    journal = nullptr;
+    intervalStats = nullptr;
+    history = nullptr;
+    triggeredBreakpoint = -1;
 
     // Create the memory hierarchy
     memory = new MainMemory(sc);
-    for (int i = 0; i < cacheLevels; i++) {
-        caches[i] = new Cache(sc, i);
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches.push_back(new Cache(sc, i));
     }
 
-    /* TODO Is the previous pointer required ? 
-       A memory element will get a function called and the reply is passed as a return of that fx */
+    // Link every cache to the one that gets its misses. Caches beyond the number of levels are not built, so the ones
+    // above them send their misses straight to the main memory
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        int32_t next = sc->cacheNext[i];
+        MemoryElement* nextElement = (next >= 0 && (uint32_t) next < cacheLevels) ? (MemoryElement*) caches[next] : memory;
 
-    // Link all caches together
-    for (int i = 1; i < cacheLevels; i++) {
-        caches[i - 1]->setNext(caches[i]);
-        caches[i]->setPrev(caches[i - 1]);
+        caches[i]->setNext(nextElement);
+        nextElement->setPrev(caches[i]);
     }
 
-    // If there is at least one cache, link the last cache to the main memory
-    if (cacheLevels > 0) {
-        caches[cacheLevels - 1]->setNext(memory);
-        memory->setPrev(caches[cacheLevels - 1]);
+    // Every core sends its accesses to its first caches, or straight to the main memory if there are none
+    numCores = std::max<uint32_t>(sc->miscNumCores, 1);
+    entries.assign(2 * numCores, memory);
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        int32_t core = sc->cacheCore[i];
+        if (core < 0) continue;
 
-        // Also, store a pointer to the first cache as the memory element that is closest to the CPU
-        // All requests will be sent to this cache and it will have to take care of bringing the data by itself
-        hierarchyStart = caches[0];
-    } else {
-        // If there is no cache, wire everything straight to the CPU
-        hierarchyStart = memory;
+        if (sc->cacheSide[i] != CACHE_SIDE_DATA) entries[2 * core] = caches[i];
+        if (sc->cacheSide[i] != CACHE_SIDE_INSTRUCTIONS) entries[2 * core + 1] = caches[i];
+    }
+
+    // Register the statistics of the CPU and every element
+    stats.add("cpu.cycle", &cycle);
+    stats.add("cpu.warmup_operations", &warmupOperations);
+    stats.add("cpu.total_access_time", &totalAccessTime);
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->registerStats(&stats);
     }
+    memory->registerStats(&stats);
+}
+
+/**
+ * Construct a new Simulator:: Simulator object that pulls the operations from a source as it executes them, so that
+ * the whole trace never has to be in memory. Meant for runs without GUI, as the GUI lists the whole trace.
+ * @param sc The simulator configs
+ * @param src The source of the operations to execute. It must outlive the simulator
+ */
+Simulator::Simulator(SimulatorConfig* sc, OperationSource* src) : Simulator(sc, (MemoryOperation**) nullptr) {
+    source = src;
+    source->rewind();
+    numOperations = source->getNumOps();
+}
+
+/**
+ * Construct a new Simulator:: Simulator object that replays a filter stream into the level it was recorded at,
+ * skipping the levels above. Each step replays the requests of an operation of the recorded trace.
+ * @param sc The simulator configs. The levels above the recorded one must be the ones the stream was recorded with
+ * @param fr The filter stream, already opened. It must outlive the simulator
+ */
+Simulator::Simulator(SimulatorConfig* sc, FilterReader* fr) : Simulator(sc, (OperationSource*) fr) {
+    filter = fr;
+    numOperations = filter->getNumCycles();
+    setEntryLevel(filter->getLevel());
 }
 
 Simulator::~Simulator() {
+    delete journal;
+    delete history;
+
+    // Free the memory hierarchy
+    delete memory;
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        delete caches[i];
+    }
+
+    free(streamData);
+
     // Free the data in the memory operations loaded from the trace
-    for (int i = 0; i < numOperations; i++) {
+    for (uint64_t i = 0; operations != nullptr && i < numOperations; i++) {
         free(operations[i]->data);
     }
 }
 
+/**
+ * Gets the operation to execute in the current cycle.
+ * @return MemoryOperation* The operation, nullptr if the source has ended before the expected number of operations.
+ */
+MemoryOperation* Simulator::fetchOperation() {
+    if (source == nullptr) {
+        return operations[cycle];
+    }
+
+    if (!source->next(&streamOperation)) {
+        numOperations = cycle;
+        return nullptr;
+    }
+
+    return &streamOperation;
+}
+
+/**
+ * Moves the source to the operation of the current cycle, after the cycle was restored. Sources are deterministic,
+ * so the operations before it are produced again and thrown away.
+ */
+void Simulator::syncSource() {
+    source->rewind();
+
+    if (filter != nullptr) {
+        while (filter->getNextCycle() < cycle) {
+            filter->next(&streamOperation);
+        }
+        return;
+    }
+
+    // The cycle may come from a checkpoint of a longer trace, so stop where the source ends
+    uint64_t skipped = 0;
+    while (skipped < cycle && source->next(&streamOperation)) {
+        skipped++;
+    }
+}
+
+/**
+ * Replays the requests of the filter stream that belong to the current cycle, if any.
+ * @param rep The reply, which accumulates the time of all of them.
+ */
+void Simulator::replayCycle(MemoryReply* rep) {
+    while (filter->getNextCycle() == cycle && filter->next(&streamOperation)) {
+        getEntry(&streamOperation, 0)->processRequest(&streamOperation, rep);
+    }
+}
+
 /**
  * Runs a single instruction. 
  */
 void Simulator::singleStep() {
     MemoryReply rep;
 
+    // Filter streams have no operations of their own, just the requests sent in each cycle
+    if (filter != nullptr) {
+        if (cycle < numOperations) {
+            rep.totalTime = 0.0;
+            rep.data = (uint64_t*) malloc(sizeof(uint64_t) * maxWords);
+            memory->setCurrentTime(totalAccessTime);
+            replayCycle(&rep);
+            totalAccessTime += rep.totalTime;
+            free(rep.data);
+
+            cycle++;
+            if (intervalStats != nullptr) {
+                intervalStats->step();
+            }
+            if (history != nullptr) {
+                history->step();
+            }
+        }
+        return;
+    }
+
     // Check that the cycle is not greater than the number of ops
     if (cycle < numOperations) {
-        // Clear previous styles
-        clearAllStyles();
+        MemoryOperation* op = fetchOperation();
+        if (op == nullptr) {
+            return;
+        }
+
+        // Record the state prior to the step so that it can be undone
+        if (journal != nullptr) {
+            if (journal->isSnapshotDue(cycle)) {
+                char* data;
+                size_t size;
+                FILE* stream = open_memstream(&data, &size);
+                saveState(stream);
+                fclose(stream);
+                journal->addSnapshot(cycle, data, size);
+            }
+
+            std::vector<uint64_t> counters;
+            saveCounters(counters);
+            journal->beginStep(counters);
+        }
+
+        // Clear previous styles. Only the GUI shows them, and it never runs quiet
+        if (!quiet) clearAllStyles();
 
         // Set up the reply
         rep.totalTime = 0.0;
-        rep.data = (uint64_t*) malloc(sizeof(uint64_t));
+        rep.data = (uint64_t*) malloc(sizeof(uint64_t) * maxWords);
 
         // Display information on console
-        printf("\n\n------ Cycle %d ------\n\n", cycle);
-        if (operations[cycle]->operation == LOAD)  printf("CPU: Requested data on 0x%lX\n", operations[cycle]->address);
-        if (operations[cycle]->operation == STORE) printf("CPU: Storing %lu on 0x%lX\n", operations[cycle]->data[0], operations[cycle]->address);
+        if (!quiet) {
+            printf("\n\n------ Cycle %lu ------\n\n", cycle);
+            if (op->operation == LOAD)  printf("CPU: Requested data on 0x%lX\n", op->address);
+            if (op->operation == STORE) printf("CPU: Storing %lu on 0x%lX\n", op->data[0], op->address);
+        }
+
+        // Let the memory know when this operation started so that its requests can be timestamped
+        memory->setCurrentTime(totalAccessTime);
 
         // Throw the request to the first level of the memory hierarchy
-        hierarchyStart->processRequest(operations[cycle], &rep);
+        getEntry(op, 0)->processRequest(op, &rep);
 
         // Unpack the reply and free the data
-        if (operations[cycle]->operation == LOAD)  printf("CPU: Finished load, got %lu in %.2f\n", rep.data[0], rep.totalTime);
-        if (operations[cycle]->operation == STORE)  printf("CPU: Finished store in %.2f\n", rep.totalTime);
+        if (!quiet) {
+            if (op->operation == LOAD)  printf("CPU: Finished load, got %lu in %.2f\n", rep.data[0], rep.totalTime);
+            if (op->operation == STORE)  printf("CPU: Finished store in %.2f\n", rep.totalTime);
+        }
         totalAccessTime += rep.totalTime;
         free(rep.data);
 
         // Enter a new cycle
         cycle++;
+
+        if (intervalStats != nullptr) {
+            intervalStats->step();
+        }
+
+        if (history != nullptr) {
+            history->step();
+        }
+
+        if (journal != nullptr) {
+            journal->endStep();
+        }
+    }
+}
+
+/**
+ * Runs an operation that does not come from the trace, as the next cycle of the simulation. Meant for embedders that
+ * generate the operations themselves, so nothing is printed and no styles are updated.
+ * @param op The operation. Its address must be within the simulated memory.
+ * @param rep The reply. Its data pointer must point to storage for at least one word.
+ * @param core The core that runs it, below getNumCores().
+ */
+void Simulator::access(MemoryOperation* op, MemoryReply* rep, uint32_t core) {
+    rep->totalTime = 0.0;
+    rep->hitLevel = 0;
+
+    memory->setCurrentTime(totalAccessTime);
+    getEntry(op, core)->processRequest(op, rep);
+    totalAccessTime += rep->totalTime;
+
+    cycle++;
+    numOperations = std::max(numOperations, cycle);
+
+    if (intervalStats != nullptr) {
+        intervalStats->step();
+    }
+}
+
+/**
+ * Runs a batch of operations that do not come from the trace, as the next cycles of the simulation. The first level
+ * serves the hits it can on its own, and the rest of the operations go through the whole hierarchy one at a time, so
+ * the results are the same as with access.
+ * @param ops The operations. Their addresses must be within the simulated memory.
+ * @param reps The replies, one per operation. Their data pointers must point to storage for at least one word.
+ * @param numOps The number of operations.
+ * @param core The core that runs them, below getNumCores().
+ */
+void Simulator::accessBatch(MemoryOperation** ops, MemoryReply* reps, uint32_t numOps, uint32_t core) {
+    // Interval sampling has to look at the stats after every operation
+    if (intervalStats != nullptr) {
+        for (uint32_t i = 0; i < numOps; i++) {
+            access(ops[i], &reps[i], core);
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < numOps; i++) {
+        reps[i].totalTime = 0.0;
+        reps[i].hitLevel = 0;
+    }
+
+    // Each run of operations that go to the same cache is handed to it at once
+    uint32_t i = 0;
+    while (i < numOps) {
+        MemoryElement* entry = getEntry(ops[i], core);
+        uint32_t run = 1;
+        while (i + run < numOps && getEntry(ops[i + run], core) == entry) {
+            run++;
+        }
+
+        uint32_t served = entry->processBatch(ops + i, reps + i, run);
+        double start = totalAccessTime;
+        for (uint32_t j = i; j < i + served; j++) {
+            start = totalAccessTime;
+            totalAccessTime += reps[j].totalTime;
+        }
+
+        // The memory keeps the start of the last operation, as if each one had gone through access
+        if (served > 0) {
+            memory->setCurrentTime(start);
+        }
+        cycle += served;
+        i += served;
+
+        if (served < run) {
+            access(ops[i], &reps[i], core);
+            i++;
+        }
+    }
+
+    numOperations = std::max(numOperations, cycle);
+}
+
+/**
+ * Runs the rest of the operations in batches. Only for quiet runs without journal, interval sampling, history or
+ * breakpoints.
+ */
+void Simulator::stepBatches() {
+    MemoryOperation* batch[SIMULATOR_BATCH_SIZE];
+    MemoryOperation sourceOps[SIMULATOR_BATCH_SIZE];
+    MemoryReply reps[SIMULATOR_BATCH_SIZE];
+    uint64_t* data = (uint64_t*) malloc(sizeof(uint64_t) * maxWords * SIMULATOR_BATCH_SIZE * 2);
+
+    for (uint32_t i = 0; i < SIMULATOR_BATCH_SIZE; i++) {
+        sourceOps[i].data = data + i * maxWords;
+        reps[i].data = data + (SIMULATOR_BATCH_SIZE + i) * maxWords;
     }
+
+    while (cycle < numOperations) {
+        uint32_t numOps = std::min<uint64_t>(SIMULATOR_BATCH_SIZE, numOperations - cycle);
+
+        if (source == nullptr) {
+            for (uint32_t i = 0; i < numOps; i++) {
+                batch[i] = operations[cycle + i];
+            }
+        } else {
+            for (uint32_t i = 0; i < numOps; i++) {
+                if (!source->next(&sourceOps[i])) {
+                    numOperations = cycle + i;
+                    numOps = i;
+                    break;
+                }
+                batch[i] = &sourceOps[i];
+            }
+        }
+
+        accessBatch(batch, reps, numOps);
+    }
+
+    free(data);
 }
 
 /**
@@ -97,13 +387,239 @@ void Simulator::singleStep() {
  * @param stopOnBreakpoint If true, it will stop on the first breakpoint it reaches, if false, it will run until the trace ends.
  */
 void Simulator::stepAll(bool stopOnBreakpoint) {
-    for (int i = cycle; i < numOperations; i++) {
-        // Check if there was a breakpoint prior to executing the operation
-        bool hasBreakPoint = operations[i]->hasBreakPoint;
+    // Without anything to do between operations, they can go to the hierarchy in batches
+    if (!stopOnBreakpoint && quiet && journal == nullptr && intervalStats == nullptr && history == nullptr && filter == nullptr) {
+        stepBatches();
+        return;
+    }
+
+    stepSome(numOperations - cycle, stopOnBreakpoint);
+}
+
+/**
+ * Runs up to a number of operations. Lets a caller run the trace in slices, looking at the simulation in between.
+ * @param numOps The maximum number of operations to run.
+ * @param stopOnBreakpoint If true, stops after running an operation that has a breakpoint or meets the condition of a
+ * conditional breakpoint.
+ * @return true If it stopped at a breakpoint.
+ */
+bool Simulator::stepSome(uint64_t numOps, bool stopOnBreakpoint) {
+    uint64_t end = (numOps < numOperations - cycle) ? cycle + numOps : numOperations;
+    bool conditional = stopOnBreakpoint && !breakpoints.empty();
+
+    // The counters are watched from where the simulation is now, which may be after a step back
+    triggeredBreakpoint = -1;
+    if (conditional) armBreakpoints();
+
+    for (uint64_t i = cycle; i < end; i++) {
+        // Check if there was a breakpoint prior to executing the operation. Sources have no breakpoints
+        bool hasBreakPoint = (operations != nullptr) && operations[i]->hasBreakPoint;
 
         // Run the cycle and then stop afterwards if it had a breakpoint
         singleStep();
-        if (hasBreakPoint && stopOnBreakpoint) break;
+        if (hasBreakPoint && stopOnBreakpoint) return true;
+        if (conditional && checkBreakpoints()) return true;
+    }
+
+    return false;
+}
+
+/**
+ * Adds a conditional breakpoint, which stops stepSome and stepAll when they are told to stop on breakpoints.
+ * @param breakpoint The breakpoint.
+ * @return int 0 if Ok, -1 if its cache, set or address range does not exist.
+ */
+int Simulator::addBreakpoint(const Breakpoint* breakpoint) {
+    if (breakpoint->condition == BREAK_ADDRESS) {
+        if (breakpoint->first > breakpoint->last) {
+            fprintf(stderr, "Breakpoint Error: The address range ends before it starts\n");
+            return -1;
+        }
+    } else if (breakpoint->cache < -1 || breakpoint->cache >= (int32_t) cacheLevels) {
+        fprintf(stderr, "Breakpoint Error: There is no cache %d\n", breakpoint->cache);
+        return -1;
+    } else if (breakpoint->condition == BREAK_SET_REPLACEMENT && breakpoint->cache != -1 &&
+               breakpoint->set >= caches[breakpoint->cache]->getSets()) {
+        fprintf(stderr, "Breakpoint Error: %s has no set %u\n", caches[breakpoint->cache]->getLabel(), breakpoint->set);
+        return -1;
+    }
+
+    breakpoints.push_back(*breakpoint);
+    compileBreakpoints();
+    return 0;
+}
+
+/**
+ * Removes a conditional breakpoint.
+ * @param index The index of the breakpoint, below getNumBreakpoints().
+ */
+void Simulator::removeBreakpoint(uint32_t index) {
+    breakpoints.erase(breakpoints.begin() + index);
+    triggeredBreakpoint = -1;
+    compileBreakpoints();
+}
+
+/**
+ * Returns the number of conditional breakpoints.
+ * @return uint32_t The number of breakpoints.
+ */
+uint32_t Simulator::getNumBreakpoints() {
+    return breakpoints.size();
+}
+
+/**
+ * Returns a conditional breakpoint.
+ * @param index The index of the breakpoint, below getNumBreakpoints().
+ * @return const Breakpoint* The breakpoint.
+ */
+const Breakpoint* Simulator::getBreakpoint(uint32_t index) {
+    return &breakpoints[index];
+}
+
+/**
+ * Returns the conditional breakpoint that stopped the last call to stepSome or stepAll.
+ * @return int32_t The index of the breakpoint, -1 if none did.
+ */
+int32_t Simulator::getTriggeredBreakpoint() {
+    return triggeredBreakpoint;
+}
+
+/**
+ * Turns the conditional breakpoints into the address ranges and counters that have to be checked after each operation,
+ * so that the check is a pair of short loops without any branching on the kind of breakpoint.
+ */
+void Simulator::compileBreakpoints() {
+    watchedRanges.clear();
+    watchedCounters.clear();
+    watchedOwners.clear();
+
+    for (uint32_t i = 0; i < breakpoints.size(); i++) {
+        if (breakpoints[i].condition == BREAK_ADDRESS) {
+            watchedRanges.push_back(breakpoints[i].first);
+            watchedRanges.push_back(breakpoints[i].last);
+            watchedOwners.push_back(i);
+        }
+    }
+
+    auto watch = [this](const uint64_t* counter, uint32_t owner) {
+        if (counter != nullptr) {
+            watchedCounters.push_back(counter);
+            watchedOwners.push_back(owner);
+        }
+    };
+
+    for (uint32_t i = 0; i < breakpoints.size(); i++) {
+        const Breakpoint* breakpoint = &breakpoints[i];
+        uint32_t firstCache = (breakpoint->cache == -1) ? 0 : breakpoint->cache;
+        uint32_t lastCache = (breakpoint->cache == -1) ? cacheLevels : breakpoint->cache + 1;
+
+        for (uint32_t j = firstCache; j < lastCache && breakpoint->condition != BREAK_ADDRESS; j++) {
+            std::string name = caches[j]->getName();
+
+            if (breakpoint->condition == BREAK_MISS) {
+                watch(stats.getCounter(stats.find((name + ".misses").c_str())), i);
+            } else if (breakpoint->condition == BREAK_DIRTY_EVICTION) {
+                // Only dirty lines are written back when evicted
+                watch(stats.getCounter(stats.find((name + ".writebacks").c_str())), i);
+            } else if (breakpoint->set < caches[j]->getSets()) {
+                for (int side = 0; side < (caches[j]->isCacheSplit() ? 2 : 1); side++) {
+                    watch(&caches[j]->getSetCounters(side)[breakpoint->set * NUM_SET_COUNTERS + SET_EVICTIONS], i);
+                }
+            }
+        }
+    }
+
+    watchedValues.resize(watchedCounters.size());
+    armBreakpoints();
+}
+
+/**
+ * Takes the current value of the watched counters as the one they must keep.
+ */
+void Simulator::armBreakpoints() {
+    for (uint32_t i = 0; i < watchedCounters.size(); i++) {
+        watchedValues[i] = *watchedCounters[i];
+    }
+}
+
+/**
+ * Checks the conditional breakpoints after running an operation.
+ * @return true If one of them was met. Its index is kept in triggeredBreakpoint.
+ */
+bool Simulator::checkBreakpoints() {
+    uint32_t numRanges = watchedRanges.size() / 2;
+
+    // Filter streams replay requests instead of the operations of a trace, so they have no addresses to watch
+    if (numRanges != 0 && filter == nullptr && cycle != 0) {
+        uint64_t address = (source == nullptr) ? operations[cycle - 1]->address : streamOperation.address;
+        for (uint32_t i = 0; i < numRanges; i++) {
+            if (address >= watchedRanges[2 * i] && address <= watchedRanges[2 * i + 1]) {
+                triggeredBreakpoint = watchedOwners[i];
+                return true;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < watchedCounters.size(); i++) {
+        if (*watchedCounters[i] != watchedValues[i]) {
+            triggeredBreakpoint = watchedOwners[numRanges + i];
+            armBreakpoints();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Runs operations through a functional model of the hierarchy to warm it up, and then resets the stats so that only the
+ * operations that follow get measured. The functional model updates the content and replacement state of the caches,
+ * but skips timing, styles and console output.
+ * @param numOps The number of operations to warm up with.
+ */
+void Simulator::warmup(uint64_t numOps) {
+    MemoryReply rep;
+    uint64_t end = (numOps < numOperations - cycle) ? cycle + numOps : numOperations;
+
+    rep.data = (uint64_t*) malloc(sizeof(uint64_t) * maxWords);
+    setFunctional(true);
+
+    for (; cycle < end; cycle++) {
+        if (filter != nullptr) {
+            replayCycle(&rep);
+            continue;
+        }
+
+        MemoryOperation* op = fetchOperation();
+        if (op == nullptr) {
+            break;
+        }
+
+        rep.totalTime = 0.0;
+        getEntry(op, 0)->processRequest(op, &rep);
+    }
+
+    setFunctional(false);
+    free(rep.data);
+
+    // Start measuring from here
+    totalAccessTime = 0.0;
+    memory->resetStats();
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->resetStats();
+    }
+    warmupOperations = cycle;
+}
+
+/**
+ * Switches all the elements of the hierarchy from/to functional mode.
+ * @param isFunctional True to only simulate the state of the hierarchy.
+ */
+void Simulator::setFunctional(bool isFunctional) {
+    memory->setFunctional(isFunctional);
+    if (filterRecorder != nullptr) filterRecorder->setFunctional(isFunctional);
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->setFunctional(isFunctional);
     }
 }
 
@@ -111,22 +627,375 @@ void Simulator::stepAll(bool stopOnBreakpoint) {
  * Sets the state to a default and starts the simulation from the beginning.
  */
 void Simulator::reset() {
-    // Reset the cycles
+    // Reset the cycles and the random number generator
     cycle = 0;
+    seedRand(randSeed);
+
+    // Start the source again
+    if (source != nullptr) {
+        source->rewind();
+    }
 
     // Reset the stats
     totalAccessTime = 0.0;
+    warmupOperations = 0;
 
     // Init the mem hierarchy
     memory->flush();
-    for (int i = 0; i < cacheLevels; i++) {
+    for (uint32_t i = 0; i < cacheLevels; i++) {
         caches[i]->flush();
     }
 }
 
+/**
+ * Sets the state to a default and forgets the history of the simulation.
+ */
+void Simulator::restart() {
+    reset();
+
+    if (journal != nullptr) {
+        journal->clear();
+    }
+    if (history != nullptr) {
+        history->clear();
+    }
+}
+
+/**
+ * Enables or disables the quiet mode, in which the progress of each operation is not printed and the hierarchy is not
+ * styled. Meant for runs without GUI.
+ * @param isQuiet True to stop printing.
+ */
+void Simulator::setQuiet(bool isQuiet) {
+    quiet = isQuiet;
+    memory->setQuiet(isQuiet);
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->setQuiet(isQuiet);
+    }
+}
+
+/**
+ * Samples the statistics every few operations from now on.
+ * @param is The sampler, already opened. nullptr to stop sampling.
+ */
+void Simulator::setIntervalStats(IntervalStats* is) {
+    intervalStats = is;
+}
+
+/**
+ * Enables the history of the stats, which the GUI charts. Meant for interactive use.
+ */
+void Simulator::enableHistory() {
+    if (history == nullptr) {
+        history = new StatsHistory(this);
+    }
+}
+
+/**
+ * Returns the history of the stats.
+ * @return StatsHistory* The history, nullptr if disabled.
+ */
+StatsHistory* Simulator::getHistory() {
+    return history;
+}
+
+/**
+ * Sends the operations to a lower level instead of the first one, skipping the levels above it. Meant to replay the
+ * requests that the levels above sent to it, recorded in a filter stream.
+ * @param level The level, 1 for L1. One past the last cache for the main memory.
+ */
+void Simulator::setEntryLevel(uint32_t level) {
+    MemoryElement* element = (level - 1 < cacheLevels) ? (MemoryElement*) caches[level - 1] : memory;
+    entries.assign(entries.size(), element);
+}
+
+/**
+ * Gets the element that receives an access of a core.
+ * @param op The access.
+ * @param core The core that made it.
+ * @return MemoryElement* The first cache for that side of the core, or the main memory if there is none.
+ */
+MemoryElement* Simulator::getEntry(MemoryOperation* op, uint32_t core) {
+    return entries[2 * core + (op->isData ? 1 : 0)];
+}
+
+/**
+ * Records the requests that reach a level from now on, by placing a recorder in front of it.
+ * @param fr The recorder, already opened. It must outlive the simulator.
+ */
+void Simulator::setFilterRecorder(FilterRecorder* fr) {
+    uint32_t level = fr->getLevel();
+
+    filterRecorder = fr;
+    fr->setNext((level - 1 < cacheLevels) ? (MemoryElement*) caches[level - 1] : memory);
+
+    if (level == 1) {
+        entries.assign(entries.size(), fr);
+    } else {
+        caches[level - 2]->setNext(fr);
+    }
+}
+
+/**
+ * Saves the full state of the simulation (cycle, stats, every cache and the main memory) to a checkpoint file.
+ * @param path Path to the checkpoint file. It will be overwritten.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int Simulator::saveCheckpoint(const char* path) {
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Checkpoint Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    saveState(file);
+
+    int result = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0 || result != 0) {
+        fprintf(stderr, "Checkpoint Error: Failed writing %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Restores the full state of the simulation from a checkpoint file. The configuration must match the one the checkpoint was saved with.
+ * If the checkpoint cannot be restored, the simulation is reset.
+ * @param path Path to the checkpoint file.
+ * @return int 0 if Ok, -1 if the checkpoint is invalid.
+ */
+int Simulator::loadCheckpoint(const char* path) {
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Checkpoint Error: Cannot open %s\n", path);
+        return -1;
+    }
+
+    int result = loadState(file, path);
+    fclose(file);
+
+    // Anything recorded in the journal or the history belongs to a different run
+    if (journal != nullptr) {
+        journal->clear();
+    }
+    if (history != nullptr) {
+        history->clear();
+    }
+
+    return result;
+}
+
+/**
+ * Writes the full state of the simulation to a stream.
+ * @param file The stream, opened for writing.
+ */
+void Simulator::saveState(FILE* file) {
+    // Header
+    uint32_t version[2] = {CHECKPOINT_VERSION, cacheLevels};
+    uint64_t state[3] = {cycle, randState, warmupOperations};
+    fwrite(CHECKPOINT_MAGIC, 1, 8, file);
+    fwrite(version, sizeof(uint32_t), 2, file);
+    fwrite(state, sizeof(uint64_t), 3, file);
+    fwrite(&totalAccessTime, sizeof(double), 1, file);
+
+    // Memory hierarchy
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->saveState(file);
+    }
+    memory->saveState(file);
+}
+
+/**
+ * Restores the full state of the simulation from a stream written by saveState.
+ * If the state cannot be restored, the simulation is reset.
+ * @param file The stream, opened for reading.
+ * @param name The name of the stream, used in the error messages.
+ * @return int 0 if Ok, -1 if the state is invalid.
+ */
+int Simulator::loadState(FILE* file, const char* name) {
+    char magic[8];
+    uint32_t version[2];
+    uint64_t state[3];
+    double time;
+
+    // Check the header before touching any state
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, CHECKPOINT_MAGIC, 8) != 0) {
+        fprintf(stderr, "Checkpoint Error: %s is not a checkpoint\n", name);
+        return -1;
+    }
+
+    if (fread(version, sizeof(uint32_t), 2, file) != 2 || fread(state, sizeof(uint64_t), 3, file) != 3 || fread(&time, sizeof(double), 1, file) != 1) {
+        fprintf(stderr, "Checkpoint Error: %s is truncated\n", name);
+        return -1;
+    }
+
+    if (version[0] != CHECKPOINT_VERSION) {
+        fprintf(stderr, "Checkpoint Error: %s has version %u, expected %u\n", name, version[0], CHECKPOINT_VERSION);
+        return -1;
+    }
+
+    if (version[1] != cacheLevels) {
+        fprintf(stderr, "Checkpoint Error: %s has %u cache levels, the configuration has %u\n", name, version[1], cacheLevels);
+        return -1;
+    }
+
+    // Restore the hierarchy
+    int result = 0;
+    for (uint32_t i = 0; i < cacheLevels && result == 0; i++) {
+        result = caches[i]->loadState(file);
+    }
+    if (result == 0) {
+        result = memory->loadState(file);
+    }
+
+    // Do not leave a partially restored hierarchy behind
+    if (result != 0) {
+        reset();
+        return -1;
+    }
+
+    cycle = state[0];
+    randState = state[1];
+    warmupOperations = state[2];
+    totalAccessTime = time;
+
+    if (source != nullptr) {
+        syncSource();
+    }
+
+    return 0;
+}
+
+/**
+ * Enables the undo journal, which allows stepping back. Meant for interactive use, as it slows down every step.
+ */
+void Simulator::enableJournal() {
+    if (journal != nullptr) {
+        return;
+    }
+
+    journal = new Journal();
+    memory->setJournal(journal);
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->setJournal(journal);
+    }
+}
+
+/**
+ * Appends all the counters that a step can modify to a list.
+ * @param counters The list.
+ */
+void Simulator::saveCounters(std::vector<uint64_t>& counters) {
+    uint64_t time;
+    memcpy(&time, &totalAccessTime, sizeof(double));
+
+    counters.clear();
+    counters.push_back(cycle);
+    counters.push_back(randState);
+    counters.push_back(time);
+
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        caches[i]->saveCounters(counters);
+    }
+    memory->saveCounters(counters);
+}
+
+/**
+ * Restores all the counters from a list written by saveCounters.
+ * @param counters The list.
+ */
+void Simulator::restoreCounters(const std::vector<uint64_t>& counters) {
+    const uint64_t* next = counters.data();
+
+    cycle = next[0];
+    randState = next[1];
+    memcpy(&totalAccessTime, next + 2, sizeof(double));
+    next += 3;
+
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        next = caches[i]->restoreCounters(next);
+    }
+    memory->restoreCounters(next);
+}
+
+/**
+ * Undoes the last executed operation.
+ * @return true If the operation was undone.
+ * @return false If there was nothing to undo.
+ */
+bool Simulator::stepBack() {
+    if (cycle == 0) {
+        return false;
+    }
+
+    seek(cycle - 1);
+    return true;
+}
+
+/**
+ * Moves the simulation to the state it has right before running the given operation.
+ * Going forward runs the operations in between. Going back either undoes the steps in the journal or, if it is cheaper
+ * or the steps are no longer in the journal, restores the closest earlier snapshot and runs forward from it.
+ * @param target The cycle to move to.
+ */
+void Simulator::seek(uint64_t target) {
+    std::vector<uint64_t> counters;
+
+    if (target > numOperations) {
+        target = numOperations;
+    }
+
+    if (target < cycle) {
+        if (history != nullptr) {
+            history->truncate(target);
+        }
+
+        // Without a journal, the only way back is replaying from the start
+        if (journal == nullptr) {
+            reset();
+        } else {
+            uint64_t distance = cycle - target;
+            JournalSnapshot* snapshot = journal->findSnapshot(target);
+
+            if (distance <= journal->getDepth() && (snapshot == nullptr || distance <= target - snapshot->cycle)) {
+                // Undo step by step
+                for (uint64_t i = 0; i < distance; i++) {
+                    journal->undoStep(counters);
+                }
+                restoreCounters(counters);
+                if (source != nullptr) syncSource();
+            } else {
+                // Go back to the snapshot. The steps after it will be recorded again when running forward.
+                uint64_t current = cycle;
+                if (snapshot != nullptr) {
+                    FILE* stream = fmemopen(snapshot->data, snapshot->size, "rb");
+                    loadState(stream, "Snapshot");
+                    fclose(stream);
+                } else {
+                    reset();
+                }
+
+                // Only the steps before the snapshot are still valid
+                journal->discardSteps(current - cycle);
+            }
+
+            // Show the style of the last executed operation
+            clearAllStyles();
+            journal->restyleLastStep();
+        }
+    }
+
+    while (cycle < target) {
+        singleStep();
+    }
+}
+
 /**
  * Returns the entire parsed trace.
- * @return MemoryOperation* Pointer to an array of memory operations that represent the trace.
+ * @return MemoryOperation* Pointer to an array of memory operations that represent the trace, nullptr if they come from a source.
  */
 MemoryOperation** Simulator::getOps() {
     return operations;
@@ -145,26 +1014,42 @@ MainMemory* Simulator::getMemory() {
  * @param uint8_t The cache index
  * @return Cache** Pointer to an array of cache pointers.
  */
-Cache* Simulator::getCache(uint8_t cache) {
+Cache* Simulator::getCache(uint32_t cache) {
     return caches[cache];
 }
 
+/**
+ * Returns the registry with all the statistics of the simulation.
+ * @return StatsRegistry* Pointer to the registry.
+ */
+StatsRegistry* Simulator::getStats() {
+    return &stats;
+}
+
 /**
  * Returns the number of operations in the trace.
- * @return uint32_t number of operations.
+ * @return uint64_t number of operations.
  */
-uint32_t Simulator::getNumOps() {
+uint64_t Simulator::getNumOps() {
     return numOperations;
 }
 
 /**
  * Returns the number of caches in the hierarchy.
- * @return uint8_t number of caches.
+ * @return uint32_t number of caches.
  */
-uint8_t Simulator::getNumCaches() {
+uint32_t Simulator::getNumCaches() {
     return cacheLevels;
 }
 
+/**
+ * Returns the number of cores that send accesses to the hierarchy. Traces are run by core 0.
+ * @return uint32_t number of cores.
+ */
+uint32_t Simulator::getNumCores() {
+    return numCores;
+}
+
 /**
  * Returns the address width in bits.
  * @return uint32_t The address width in Bytes 
@@ -181,6 +1066,14 @@ uint32_t Simulator::getWordWidth() {
     return wordWidth;
 }
 
+/**
+ * Returns the number of operations that have been measured, this is, the executed ones after the warm-up.
+ * @return uint64_t The number of operations.
+ */
+uint64_t Simulator::getMeasuredOps() {
+    return cycle - warmupOperations;
+}
+
 /**
  * Returns the total access time.
  * @return uint32_t The total access time.
@@ -194,7 +1087,7 @@ double Simulator::getTotalAccessTime() {
  */
 void Simulator::clearAllStyles() {
     memory->clearStyle();
-    for (int i = 0; i < cacheLevels; i++) {
+    for (uint32_t i = 0; i < cacheLevels; i++) {
         caches[i]->clearStyle();
     }
 }
@@ -203,23 +1096,42 @@ void Simulator::clearAllStyles() {
  * Prints the current execution statistics to stdout.
  */
 void Simulator::printStatistics() {
+    const char* missNames[NUM_MISS_TYPES] = {"compulsory", "capacity", "conflict"};
+    double accessTime = stats.getValue(stats.find("cpu.total_access_time"));
+
     printf("\n\n------ Statistics ------\n\n");
     printf("CPU:\n");
-    printf("\tTotal access time (s): %.4f\n", totalAccessTime);
-    printf("\tAverage memory access time (s): %.4f\n", totalAccessTime / (double) cycle);
+    if (warmupOperations > 0) printf("\tWarm-up operations: %lu\n", stats.getCount("cpu.warmup_operations"));
+    printf("\tMeasured operations: %lu\n", getMeasuredOps());
+    printf("\tTotal access time (s): %.4f\n", accessTime);
+    printf("\tAverage memory access time (s): %.4f\n", accessTime / (double) getMeasuredOps());
     
-    for (int i = 0; i < cacheLevels; i++) {
+    for (uint32_t i = 0; i < cacheLevels; i++) {
         Cache* cache = getCache(i);
-        printf("\nCache L%d:\n", i + 1);
-        printf("\tTotal accesses: %d\n", cache->getAccesses());
-        printf("\tHits: %d\n", cache->getHits());
-        printf("\tMisses: %d \n", cache->getMisses());
-        printf("\tHit rate: %.1f%%\n", cache->getHits() / (double) cycle * 100);
-        printf("\tMiss rate: %.1f%%\n", cache->getMisses() / (double) cycle * 100);
+        std::string name = cache->getName();
+        uint64_t dataMisses[NUM_MISS_TYPES];
+        uint64_t instructionMisses[NUM_MISS_TYPES];
+
+        for (int j = 0; j < NUM_MISS_TYPES; j++) {
+            dataMisses[j] = stats.getCount(name + ".d.misses." + missNames[j]);
+            instructionMisses[j] = stats.getCount(name + ".i.misses." + missNames[j]);
+        }
+
+        printf("\nCache %s:\n", cache->getLabel());
+        printf("\tTotal accesses: %lu\n", stats.getCount(name + ".accesses"));
+        printf("\tHits: %lu\n", stats.getCount(name + ".hits"));
+        printf("\tMisses: %lu \n", stats.getCount(name + ".misses"));
+        printf("\tWrite-backs: %lu\n", stats.getCount(name + ".writebacks"));
+        printf("\tInstruction misses (compulsory/capacity/conflict): %lu/%lu/%lu\n", instructionMisses[MISS_COMPULSORY], instructionMisses[MISS_CAPACITY], instructionMisses[MISS_CONFLICT]);
+        printf("\tData misses (compulsory/capacity/conflict): %lu/%lu/%lu\n", dataMisses[MISS_COMPULSORY], dataMisses[MISS_CAPACITY], dataMisses[MISS_CONFLICT]);
+        printf("\tHit rate: %.1f%%\n", stats.getCount(name + ".hits") / (double) getMeasuredOps() * 100);
+        printf("\tMiss rate: %.1f%%\n", stats.getCount(name + ".misses") / (double) getMeasuredOps() * 100);
     }
 
+    uint64_t accessesSingle = stats.getCount("mem.accesses_single");
+    uint64_t accessesBurst = stats.getCount("mem.accesses_burst");
     printf("\nMemory:\n");
-    printf("\tTotal accesses: %ld\n", memory->getAccessesBurst() + memory->getAccessesSingle());
-    printf("\tFirst word accesses: %ld\n", memory->getAccessesSingle());
-    printf("\tBurst accesses: %ld\n", memory->getAccessesBurst());
+    printf("\tTotal accesses: %ld\n", accessesBurst + accessesSingle);
+    printf("\tFirst word accesses: %ld\n", accessesSingle);
+    printf("\tBurst accesses: %ld\n", accessesBurst);
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "StatsHistory.h"
+#include "Simulator.h"
+
+/**
+ * Creates a history that starts from the current state of a simulation.
+ * @param simulator The simulator to sample.
+ */
+StatsHistory::StatsHistory(Simulator* simulator) {
+    sim = simulator;
+    cacheLevels = sim->getNumCaches();
+    levels.resize(HISTORY_SIZE * cacheLevels * 2);
+    clear();
+}
+
+/**
+ * Must be called after each operation. Takes a sample every stride operations.
+ */
+void StatsHistory::step() {
+    // The history may already have a sample of this cycle if the simulation went back and is running forward again
+    if ((cycle & (stride - 1)) != 0 || samples[count - 1].cycle >= cycle) {
+        return;
+    }
+
+    if (count == HISTORY_SIZE) {
+        downsample();
+        if ((cycle & (stride - 1)) != 0) {
+            return;
+        }
+    }
+
+    takeSample();
+}
+
+/**
+ * Forgets the samples taken after a cycle. Used when the simulation goes back.
+ * @param target The cycle the simulation went back to.
+ */
+void StatsHistory::truncate(uint64_t target) {
+    while (count > 1 && samples[count - 1].cycle > target) {
+        count--;
+    }
+}
+
+/**
+ * Forgets every sample and starts again from the current state of the simulation.
+ */
+void StatsHistory::clear() {
+    stride = 1;
+    count = 0;
+    takeSample();
+}
+
+/**
+ * Returns the number of samples.
+ * @return uint32_t The number of samples, at least 1.
+ */
+uint32_t StatsHistory::getNumSamples() {
+    return count;
+}
+
+/**
+ * Returns the number of operations between two samples.
+ * @return uint64_t The number of operations.
+ */
+uint64_t StatsHistory::getStride() {
+    return stride;
+}
+
+/**
+ * Returns a sample.
+ * @param index 0 for the oldest sample. Must be lower than getNumSamples().
+ * @return const HistorySample* The sample.
+ */
+const HistorySample* StatsHistory::getSample(uint32_t index) {
+    return &samples[index];
+}
+
+/**
+ * Returns the accesses of a cache in a sample.
+ * @param index The sample, 0 for the oldest one.
+ * @param level The cache.
+ * @return uint64_t The accesses.
+ */
+uint64_t StatsHistory::getAccesses(uint32_t index, uint32_t level) {
+    return levels[(index * cacheLevels + level) * 2];
+}
+
+/**
+ * Returns the hits of a cache in a sample.
+ * @param index The sample, 0 for the oldest one.
+ * @param level The cache.
+ * @return uint64_t The hits.
+ */
+uint64_t StatsHistory::getHits(uint32_t index, uint32_t level) {
+    return levels[(index * cacheLevels + level) * 2 + 1];
+}
+
+/**
+ * Appends a sample with the current value of the counters of the simulation.
+ */
+void StatsHistory::takeSample() {
+    MainMemory* memory = sim->getMemory();
+    HistorySample* sample = &samples[count];
+
+    sample->cycle = cycle;
+    sample->measuredOps = sim->getMeasuredOps();
+    sample->time = sim->getTotalAccessTime();
+    sample->memoryAccesses = memory->getAccessesSingle() + memory->getAccessesBurst();
+
+    for (uint32_t i = 0; i < cacheLevels; i++) {
+        Cache* cache = sim->getCache(i);
+        levels[(count * cacheLevels + i) * 2] = cache->getAccesses();
+        levels[(count * cacheLevels + i) * 2 + 1] = cache->getHits();
+    }
+
+    count++;
+}
+
+/**
+ * Halves the number of samples by doubling the stride. Only the samples on the new stride are kept, besides the first.
+ */
+void StatsHistory::downsample() {
+    uint32_t kept = 1;
+
+    stride *= 2;
+    for (uint32_t i = 1; i < count; i++) {
+        if ((samples[i].cycle & (stride - 1)) != 0) {
+            continue;
+        }
+
+        samples[kept] = samples[i];
+        std::copy(levels.begin() + i * cacheLevels * 2, levels.begin() + (i + 1) * cacheLevels * 2,
+                  levels.begin() + kept * cacheLevels * 2);
+        kept++;
+    }
+
+    count = kept;
+}
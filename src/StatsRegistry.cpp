@@ -0,0 +1,194 @@
+#include "StatsRegistry.h"
+
+/**
+ * Registers a 32 bit counter.
+ * @param name The hierarchical name of the counter.
+ * @param value Pointer to the counter. Must stay valid as long as the registry is used.
+ */
+void StatsRegistry::add(const std::string& name, const uint32_t* value) {
+    entries.push_back({name, STAT_U32, value});
+}
+
+/**
+ * Registers a 64 bit counter.
+ * @param name The hierarchical name of the counter.
+ * @param value Pointer to the counter. Must stay valid as long as the registry is used.
+ */
+void StatsRegistry::add(const std::string& name, const uint64_t* value) {
+    entries.push_back({name, STAT_U64, value});
+}
+
+/**
+ * Registers a floating point statistic.
+ * @param name The hierarchical name of the statistic.
+ * @param value Pointer to the statistic. Must stay valid as long as the registry is used.
+ */
+void StatsRegistry::add(const std::string& name, const double* value) {
+    entries.push_back({name, STAT_DOUBLE, value});
+}
+
+/**
+ * Gets the number of registered statistics.
+ * @return uint32_t The number of statistics.
+ */
+uint32_t StatsRegistry::getNumStats() {
+    return entries.size();
+}
+
+/**
+ * Gets the name of a statistic.
+ * @param index The index of the statistic, in registration order.
+ * @return const char* The hierarchical name.
+ */
+const char* StatsRegistry::getName(uint32_t index) {
+    return entries[index].name.c_str();
+}
+
+/**
+ * Gets the current value of a statistic.
+ * @param index The index of the statistic, in registration order.
+ * @return double The value.
+ */
+double StatsRegistry::getValue(uint32_t index) {
+    switch (entries[index].type) {
+        case STAT_U32:
+            return *(const uint32_t*) entries[index].value;
+        case STAT_U64:
+            return *(const uint64_t*) entries[index].value;
+        case STAT_DOUBLE:
+            return *(const double*) entries[index].value;
+        default:
+            assert(0 && "Invalid statistic type");
+            return 0.0;
+    }
+}
+
+/**
+ * Searches a statistic by name.
+ * @param name The hierarchical name.
+ * @return int32_t The index of the statistic, or -1 if it is not registered.
+ */
+int32_t StatsRegistry::find(const char* name) {
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        if (entries[i].name == name) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the counter behind a statistic, to watch it without going through the registry.
+ * @param index The index of the statistic, as returned by find.
+ * @return const uint64_t* The counter, nullptr if the index is -1 or the statistic is not a 64 bit counter.
+ */
+const uint64_t* StatsRegistry::getCounter(int32_t index) {
+    if (index < 0 || entries[index].type != STAT_U64) {
+        return nullptr;
+    }
+
+    return (const uint64_t*) entries[index].value;
+}
+
+/**
+ * Gets the current value of a 64 bit counter by name, for the views that print the statistics.
+ * @param name The hierarchical name.
+ * @return uint64_t The value, 0 if the counter is not registered.
+ */
+uint64_t StatsRegistry::getCount(const std::string& name) {
+    const uint64_t* counter = getCounter(find(name.c_str()));
+    return (counter != nullptr) ? *counter : 0;
+}
+
+/**
+ * Prints the current value of a statistic, keeping integers as integers.
+ * @param file The output file.
+ * @param entry The statistic.
+ */
+void StatsRegistry::formatValue(FILE* file, const StatEntry* entry) {
+    switch (entry->type) {
+        case STAT_U32:
+            fprintf(file, "%u", *(const uint32_t*) entry->value);
+            break;
+        case STAT_U64:
+            fprintf(file, "%lu", *(const uint64_t*) entry->value);
+            break;
+        case STAT_DOUBLE:
+            fprintf(file, "%.9g", *(const double*) entry->value);
+            break;
+        default:
+            assert(0 && "Invalid statistic type");
+            break;
+    }
+}
+
+/**
+ * Writes all the statistics to a JSON file, as a single object with one member per statistic.
+ * @param path Path to the file. It will be overwritten.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int StatsRegistry::writeJson(const char* path) {
+    FILE* file = fopen(path, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "Stats Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    fprintf(file, "{\n");
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        fprintf(file, "  \"%s\": ", entries[i].name.c_str());
+        formatValue(file, &entries[i]);
+        fprintf(file, (i + 1 < entries.size()) ? ",\n" : "\n");
+    }
+    fprintf(file, "}\n");
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Stats Error: Failed writing %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Prints all the statistics as CSV, a header with the names and a single row with the values.
+ * @param file The output file.
+ */
+void StatsRegistry::printCsv(FILE* file) {
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        fprintf(file, (i > 0) ? ",%s" : "%s", entries[i].name.c_str());
+    }
+    fprintf(file, "\n");
+
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        if (i > 0) fprintf(file, ",");
+        formatValue(file, &entries[i]);
+    }
+    fprintf(file, "\n");
+}
+
+/**
+ * Writes all the statistics to a CSV file, as a header with the names and a single row with the values.
+ * Files of different runs with the same configuration can be concatenated by skipping their headers.
+ * @param path Path to the file. It will be overwritten.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int StatsRegistry::writeCsv(const char* path) {
+    FILE* file = fopen(path, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "Stats Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    printCsv(file);
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Stats Error: Failed writing %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
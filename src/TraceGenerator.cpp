@@ -0,0 +1,448 @@
+#include <algorithm>
+
+#include "TraceGenerator.h"
+
+// Pattern names
+const char* strGeneratorPattern[] = {"sequential", "stride", "uniform", "zipf", "chase", "matmul"};
+
+/**
+ * Converts a pattern into its name.
+ * @param pattern The pattern.
+ * @return const char* The name.
+ */
+const char* generatorPatternStr(GeneratorPattern pattern) {
+    return strGeneratorPattern[pattern];
+}
+
+/**
+ * Converts a name into a pattern.
+ * @param string The name, as returned by generatorPatternStr.
+ * @return int The pattern, -1 if the name is unknown, -2 if it is a null pointer.
+ */
+int parseGeneratorPattern(const char* string) {
+    if (string == NULL) {
+        return -2;
+    }
+
+    for (int i = 0; i < NUM_GEN_PATTERNS; i++) {
+        if (strcmp(strGeneratorPattern[i], string) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Gets the smallest mask of the form 2^k - 1 that covers a range.
+ * @param n The number of values of the range, starting at 0.
+ * @return uint64_t The mask.
+ */
+static uint64_t maskFor(uint64_t n) {
+    uint64_t mask = 0;
+    while (n > 1 && mask < n - 1) {
+        mask = (mask << 1) | 1;
+    }
+    return mask;
+}
+
+/**
+ * Converts a probability into the random number below which an event happens.
+ * @param ratio The probability, between 0 and 1.
+ * @return uint64_t The threshold.
+ */
+static uint64_t ratioThreshold(double ratio) {
+    return (ratio >= 1.0) ? UINT64_MAX : (uint64_t) (ratio * 18446744073709551616.0);
+}
+
+/**
+ * Computes log(1 + x) / x, accurately also near 0.
+ */
+static double log1pOverX(double x) {
+    return (fabs(x) > 1e-8) ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+/**
+ * Computes (exp(x) - 1) / x, accurately also near 0.
+ */
+static double expm1OverX(double x) {
+    return (fabs(x) > 1e-8) ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+}
+
+TraceGenerator::TraceGenerator() {
+    memset(&config, 0, sizeof(GeneratorConfig));
+    codeWords = 0;
+    dataWords = 0;
+    rewind();
+}
+
+/**
+ * Checks the parameters of a trace and prepares the generator to produce it from the start.
+ * @param gc The parameters.
+ * @return int 0 if Ok, -1 if the parameters are invalid.
+ */
+int TraceGenerator::init(const GeneratorConfig* gc) {
+    int errors = 0;
+
+    if (gc->pattern < 0 || gc->pattern >= NUM_GEN_PATTERNS) {
+        fprintf(stderr, "Generator Error: Unknown access pattern\n");
+        errors++;
+    }
+    if (gc->numOps == 0) {
+        fprintf(stderr, "Generator Error: The trace must have at least one operation\n");
+        errors++;
+    }
+    if (gc->wordWidth == 0 || gc->footprint < gc->wordWidth) {
+        fprintf(stderr, "Generator Error: The footprint must hold at least one word\n");
+        errors++;
+    }
+    if (gc->wordWidth != 0 && (gc->stride == 0 || gc->stride % gc->wordWidth != 0)) {
+        fprintf(stderr, "Generator Error: The stride must be a multiple of the word width\n");
+        errors++;
+    }
+    if (gc->writeRatio < 0.0 || gc->writeRatio > 1.0 || gc->instRatio < 0.0 || gc->instRatio > 1.0) {
+        fprintf(stderr, "Generator Error: The write and instruction ratios must be between 0 and 1\n");
+        errors++;
+    }
+    if (gc->zipfSkew <= 0.0) {
+        fprintf(stderr, "Generator Error: The Zipfian skew must be positive\n");
+        errors++;
+    }
+    if (gc->block == 0) {
+        fprintf(stderr, "Generator Error: The matrix blocks must have at least one element\n");
+        errors++;
+    }
+
+    if (errors > 0) {
+        return -1;
+    }
+
+    config = *gc;
+
+    // Give the code an eighth of the footprint, within a limit, if there are instruction fetches
+    uint64_t words = config.footprint / config.wordWidth;
+    codeWords = 0;
+    if (config.instRatio > 0.0) {
+        codeWords = std::max<uint64_t>(std::min<uint64_t>(words / 8, GENERATOR_MAX_CODE_BYTES / config.wordWidth), 1);
+    }
+    dataWords = words - codeWords;
+    strideWords = config.stride / config.wordWidth;
+
+    // The ratios are compared against raw random numbers
+    instThreshold = ratioThreshold(config.instRatio);
+    writeThreshold = ratioThreshold(config.writeRatio);
+
+    // The chased nodes are stride Bytes apart, their order comes from a full period LCG over a power of 2 that is scrambled
+    numNodes = dataWords / strideWords;
+    permMask = maskFor(numNodes);
+    permIncrement = ((uint64_t) config.seed << 1) | 1;
+    chaseMultiplier = 6364136223846793005ULL;
+
+    // Matrices A, B and C are stored one after another, row by row
+    matrixSize = (uint64_t) sqrt(dataWords / 3.0);
+    while ((matrixSize + 1) * (matrixSize + 1) * 3 <= dataWords) matrixSize++;
+    while (matrixSize * matrixSize * 3 > dataWords) matrixSize--;
+    config.block = std::min<uint64_t>(config.block, std::max<uint64_t>(matrixSize, 1));
+
+    if (dataWords == 0 || (config.pattern == GEN_CHASE && numNodes == 0) || (config.pattern == GEN_MATMUL && matrixSize == 0)) {
+        fprintf(stderr, "Generator Error: The footprint is too small for the %s pattern\n", generatorPatternStr(config.pattern));
+        return -1;
+    }
+
+    // Constants of the Zipfian sampler over the ranks 1..dataWords
+    zipfIntegralFirst = zipfIntegral(1.5) - 1.0;
+    zipfIntegralLast = zipfIntegral(dataWords + 0.5);
+    zipfThreshold = 2.0 - zipfIntegralInverse(zipfIntegral(2.5) - zipfH(2.0));
+    zipfMask = maskFor(dataWords);
+
+    rewind();
+    return 0;
+}
+
+/**
+ * Restarts the trace from its first operation.
+ */
+void TraceGenerator::rewind() {
+    generated = 0;
+    state = ((uint64_t) config.seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+    pc = 0;
+    position = 0;
+    ii = jj = kk = i = j = k = 0;
+    matmulPhase = 0;
+}
+
+/**
+ * Returns the number of operations of the trace.
+ * @return uint64_t The number of operations.
+ */
+uint64_t TraceGenerator::getNumOps() {
+    return config.numOps;
+}
+
+/**
+ * Produces the next operation of the trace. Stores write the index of the operation.
+ * @param op The operation to fill. Its data pointer must point to storage for at least one word.
+ * @return true If an operation was produced, false if the trace has ended.
+ */
+bool TraceGenerator::next(MemoryOperation* op) {
+    uint64_t word;
+
+    if (generated >= config.numOps) {
+        return false;
+    }
+
+    op->numWords = 1;
+    op->hasBreakPoint = false;
+    op->operation = LOAD;
+
+    if (codeWords > 0 && nextRandom() < instThreshold) {
+        // Instruction fetch. Run through the code with an occasional jump
+        if (nextRandom() % GENERATOR_JUMP_PERIOD == 0) {
+            pc = nextRandom() % codeWords;
+        } else if (++pc == codeWords) {
+            pc = 0;
+        }
+        word = pc;
+        op->isData = false;
+    } else {
+        switch (config.pattern) {
+            case GEN_SEQUENTIAL:
+                word = position;
+                if (++position == dataWords) position = 0;
+                break;
+            case GEN_STRIDE:
+                word = position;
+                position += strideWords;
+                if (position >= dataWords) position %= dataWords;
+                break;
+            case GEN_UNIFORM:
+                word = nextRandom() % dataWords;
+                break;
+            case GEN_ZIPF:
+                word = nextZipf();
+                break;
+            case GEN_CHASE:
+                word = nextChase() * strideWords;
+                break;
+            case GEN_MATMUL:
+                word = nextMatmul(&op->operation);
+                break;
+            default:
+                assert(0 && "Invalid access pattern");
+                word = 0;
+                break;
+        }
+
+        // The matrix multiply decides by itself what to store
+        if (config.pattern != GEN_MATMUL && nextRandom() < writeThreshold) {
+            op->operation = STORE;
+        }
+
+        word += codeWords;
+        op->isData = true;
+    }
+
+    if (op->operation == STORE) {
+        op->data[0] = generated;
+    }
+    op->address = config.baseAddress + word * config.wordWidth;
+    generated++;
+
+    return true;
+}
+
+/**
+ * Writes the whole trace to a trace (.vca) file, so that it can be loaded in the GUI or by other tools.
+ * The generator is rewound before and after writing.
+ * @param path Path to the trace file. It will be overwritten.
+ * @return int 0 if Ok, -1 if the file could not be written.
+ */
+int TraceGenerator::writeTrace(const char* path) {
+    MemoryOperation op;
+    uint64_t data;
+    FILE* file = fopen(path, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "Generator Error: Cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    fprintf(file, "# Generated %s trace: %lu operations over %lu Bytes from 0x%08lX, seed %u\n", generatorPatternStr(config.pattern),
+            config.numOps, config.footprint, config.baseAddress, config.seed);
+
+    op.data = &data;
+    rewind();
+    while (next(&op)) {
+        if (op.operation == STORE) {
+            fprintf(file, "S 0x%08lX D %lu\n", op.address, op.data[0]);
+        } else {
+            fprintf(file, "L 0x%08lX %c\n", op.address, op.isData ? 'D' : 'I');
+        }
+    }
+    rewind();
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Generator Error: Failed writing %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Gets the next number of the xorshift64* generator of the trace.
+ * @return uint64_t The number.
+ */
+uint64_t TraceGenerator::nextRandom() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Gets a random number in [0, 1).
+ * @return double The number.
+ */
+double TraceGenerator::randomUnit() {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Shuffles the numbers covered by a mask of the form 2^k - 1. Every step is a bijection of [0, 2^k), so no two numbers
+ * end up in the same place.
+ * @param index The number to move.
+ * @param mask The mask.
+ * @return uint64_t The new place of the number.
+ */
+uint64_t TraceGenerator::scatter(uint64_t index, uint64_t mask) {
+    int shift = (__builtin_popcountll(mask) + 1) / 2;
+
+    index = (index * 0x9E3779B97F4A7C15ULL + config.seed) & mask;
+    index ^= index >> shift;
+    index = (index * 0xBF58476D1CE4E5B9ULL) & mask;
+    index ^= index >> shift;
+
+    return index;
+}
+
+/**
+ * Probability mass of the Zipfian distribution, not normalised.
+ */
+double TraceGenerator::zipfH(double x) {
+    return exp(-config.zipfSkew * log(x));
+}
+
+/**
+ * Integral of zipfH.
+ */
+double TraceGenerator::zipfIntegral(double x) {
+    double logX = log(x);
+    return expm1OverX((1.0 - config.zipfSkew) * logX) * logX;
+}
+
+/**
+ * Inverse of zipfIntegral.
+ */
+double TraceGenerator::zipfIntegralInverse(double x) {
+    double t = std::max(x * (1.0 - config.zipfSkew), -1.0);
+    return exp(log1pOverX(t) * x);
+}
+
+/**
+ * Samples a word with a Zipfian distribution, by rejection-inversion (Hörmann and Derflinger), which takes constant
+ * time and memory whatever the footprint. The ranks are scattered over the data so that the popular words are not
+ * next to each other.
+ * @return uint64_t The word, relative to the data.
+ */
+uint64_t TraceGenerator::nextZipf() {
+    uint64_t rank;
+
+    while (true) {
+        double u = zipfIntegralLast + randomUnit() * (zipfIntegralFirst - zipfIntegralLast);
+        double x = zipfIntegralInverse(u);
+
+        rank = (uint64_t) std::min(std::max(x + 0.5, 1.0), (double) dataWords);
+        if (rank - x <= zipfThreshold || u >= zipfIntegral(rank + 0.5) - zipfH(rank)) {
+            break;
+        }
+    }
+
+    // Walk the cycle of the permutation until it lands inside the data
+    rank--;
+    do {
+        rank = scatter(rank, zipfMask);
+    } while (rank >= dataWords);
+
+    return rank;
+}
+
+/**
+ * Gets the next node of the pointer chase. The LCG visits every number below the mask once per period, and the
+ * scattered numbers that do not belong to a node are skipped.
+ * @return uint64_t The node.
+ */
+uint64_t TraceGenerator::nextChase() {
+    uint64_t node;
+
+    do {
+        position = (position * chaseMultiplier + permIncrement) & permMask;
+        node = scatter(position, permMask);
+    } while (node >= numNodes);
+
+    return node;
+}
+
+/**
+ * Gets the next access of the blocked matrix multiply. For every element of C in a block, C is loaded, then A and B
+ * are loaded for every k of the block, and C is stored. When the multiply ends, it starts again.
+ * @param operation Returns whether the access is a load or a store.
+ * @return uint64_t The word, relative to the data.
+ */
+uint64_t TraceGenerator::nextMatmul(Operation* operation) {
+    uint64_t n = matrixSize, b = config.block, size = n * n, word;
+
+    switch (matmulPhase) {
+        case 0:
+            word = 2 * size + i * n + j;
+            matmulPhase = 1;
+            break;
+        case 1:
+            word = i * n + k;
+            matmulPhase = 2;
+            break;
+        case 2:
+            word = size + k * n + j;
+            k++;
+            matmulPhase = (k < std::min(kk + b, n)) ? 1 : 3;
+            break;
+        default:
+            word = 2 * size + i * n + j;
+            *operation = STORE;
+            matmulPhase = 0;
+
+            // Move to the next element of the block, or to the next block
+            j++;
+            if (j == std::min(jj + b, n)) {
+                j = jj;
+                i++;
+                if (i == std::min(ii + b, n)) {
+                    kk += b;
+                    if (kk >= n) {
+                        kk = 0;
+                        jj += b;
+                        if (jj >= n) {
+                            jj = 0;
+                            ii += b;
+                            if (ii >= n) ii = 0;
+                        }
+                    }
+                    i = ii;
+                    j = jj;
+                }
+            }
+            k = kk;
+            break;
+    }
+
+    return word;
+}
@@ -0,0 +1,356 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TraceImporter.h"
+
+/**
+ * Reads a hexadecimal number, with or without the 0x prefix.
+ * @param cursor The position in the text. It is moved past the number.
+ * @param value Returns the number.
+ * @return int 0 if Ok, -1 if there is no hexadecimal number at the cursor.
+ */
+static int parseHex(char** cursor, uint64_t* value) {
+    char* end;
+
+    if ((*cursor)[0] == '0' && ((*cursor)[1] == 'x' || (*cursor)[1] == 'X')) {
+        *cursor += 2;
+    }
+    if (!isxdigit((unsigned char) **cursor)) {
+        return -1;
+    }
+
+    *value = strtoull(*cursor, &end, 16);
+    *cursor = end;
+
+    return 0;
+}
+
+/**
+ * Skips the spaces and tabs at the cursor.
+ * @param cursor The position in the text.
+ * @return char* The first character that is not a space.
+ */
+static char* skipSpaces(char* cursor) {
+    while (*cursor == ' ' || *cursor == '\t') {
+        cursor++;
+    }
+    return cursor;
+}
+
+/**
+ * Guesses the format of a trace file: compressed traces by their header, the rest by their extension.
+ * @param path Path to the file.
+ * @return TraceFormat The format. Text traces of NuCachis if it is not recognised.
+ */
+TraceFormat detectTraceFormat(const char* path) {
+    if (isCompressedTrace(path)) {
+        return TRACE_FORMAT_COMPRESSED;
+    }
+
+    const char* extension = strrchr(path, '.');
+    if (extension == NULL) {
+        return TRACE_FORMAT_VCA;
+    }
+
+    if (strcmp(extension, ".din") == 0) return TRACE_FORMAT_DIN;
+    if (strcmp(extension, ".lackey") == 0) return TRACE_FORMAT_LACKEY;
+    if (strcmp(extension, ".champsim") == 0 || strcmp(extension, ".champsimtrace") == 0) return TRACE_FORMAT_CHAMPSIM;
+
+    return TRACE_FORMAT_VCA;
+}
+
+/**
+ * Converts a trace format to a string.
+ * @param format The format.
+ * @return const char* The name of the format.
+ */
+const char* traceFormatStr(TraceFormat format) {
+    switch (format) {
+        case TRACE_FORMAT_VCA:          return "vca";
+        case TRACE_FORMAT_COMPRESSED:   return "compressed";
+        case TRACE_FORMAT_DIN:          return "din";
+        case TRACE_FORMAT_LACKEY:       return "lackey";
+        case TRACE_FORMAT_CHAMPSIM:     return "champsim";
+        default:                        return "unknown";
+    }
+}
+
+TraceImporter::TraceImporter() {
+    file = NULL;
+    buffer = NULL;
+    line = NULL;
+    lineLength = 0;
+    format = TRACE_FORMAT_DIN;
+    numOps = 0;
+    lineNumber = 0;
+    baseAddress = 0;
+    numPending = 0;
+    nextPending = 0;
+}
+
+TraceImporter::~TraceImporter() {
+    close();
+}
+
+/**
+ * Opens a trace of an external format. The whole file is read once to validate it and count its operations, but
+ * nothing is kept in memory.
+ * @param path Path to the file.
+ * @param format The format of the file. Only the external formats are accepted.
+ * @param baseAddress The page base address of the memory. Records with an address below it are errors.
+ * @return int 0 if Ok, -2 if the file cannot be opened or has errors.
+ */
+int TraceImporter::open(const char* path, TraceFormat format, uint64_t baseAddress) {
+    if (format != TRACE_FORMAT_DIN && format != TRACE_FORMAT_LACKEY && format != TRACE_FORMAT_CHAMPSIM) {
+        fprintf(stderr, "Trace Error: %s traces cannot be imported\n", traceFormatStr(format));
+        return -2;
+    }
+
+    this->path = path;
+    this->format = format;
+    this->baseAddress = baseAddress;
+    file = fopen(path, (format == TRACE_FORMAT_CHAMPSIM) ? "rb" : "r");
+
+    if (file == NULL) {
+        fprintf(stderr, "Trace Error: Cannot open file %s\n", path);
+        return -2;
+    }
+
+    // Traces are read sequentially, a large buffer saves most of the system calls
+    buffer = (char*) malloc(IMPORT_BUFFER_SIZE);
+    setvbuf(file, buffer, _IOFBF, IMPORT_BUFFER_SIZE);
+
+    // Count the operations, and check that the memory has all of their addresses
+    int result;
+    numOps = 0;
+    rewind();
+    while ((result = readRecord()) > 0) {
+        for (uint32_t i = 0; i < numPending && result > 0; i++) {
+            if (pending[i].address < baseAddress) {
+                fprintf(stderr, "Trace Error: %s %lu of %s: The address 0x%lX is below memory:page_base_address (0x%lX)\n",
+                        (format == TRACE_FORMAT_CHAMPSIM) ? "Instruction" : "Line", lineNumber, path, pending[i].address,
+                        baseAddress);
+                result = -1;
+            }
+        }
+        if (result < 0) {
+            break;
+        }
+        numOps += numPending;
+    }
+
+    if (result < 0) {
+        close();
+        return -2;
+    }
+
+    rewind();
+    return 0;
+}
+
+/**
+ * Closes the file.
+ */
+void TraceImporter::close() {
+    if (file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+
+    free(buffer);
+    free(line);
+    buffer = NULL;
+    line = NULL;
+    lineLength = 0;
+}
+
+/**
+ * Queues an operation of the current record.
+ * @param address The address accessed.
+ * @param flags TRACE_FLAG_* of the operation.
+ */
+void TraceImporter::addPending(uint64_t address, uint8_t flags) {
+    pending[numPending].address = address;
+    pending[numPending].data = 0;
+    pending[numPending].flags = flags;
+    numPending++;
+}
+
+/**
+ * Reads the next record of the file into the pending operations. Records may produce no operations.
+ * @return int 1 if a record was read, 0 at the end of the file, -1 if the record has errors.
+ */
+int TraceImporter::readRecord() {
+    numPending = 0;
+    nextPending = 0;
+
+    switch (format) {
+        case TRACE_FORMAT_DIN:      return readDin();
+        case TRACE_FORMAT_LACKEY:   return readLackey();
+        case TRACE_FORMAT_CHAMPSIM: return readChampSim();
+        default:                    return -1;
+    }
+}
+
+/**
+ * Reads a line of a din trace: a label (0 data read, 1 data write, 2 instruction fetch, 3 escape, 4 flush) and a
+ * hexadecimal address. Escapes and flushes are ignored, as well as any field after the address.
+ * @return int 1 if a record was read, 0 at the end of the file, -1 if the record has errors.
+ */
+int TraceImporter::readDin() {
+    uint64_t address;
+
+    if (getline(&line, &lineLength, file) == -1) {
+        return 0;
+    }
+    lineNumber++;
+
+    char* cursor = skipSpaces(line);
+    if (*cursor == '\n' || *cursor == '\0') {
+        return 1;
+    }
+
+    char label = *cursor++;
+    if (label < '0' || label > '4' || (*cursor != ' ' && *cursor != '\t')) {
+        fprintf(stderr, "Trace Error: Line %lu of %s: The label must be 0, 1, 2, 3 or 4\n", lineNumber, path.c_str());
+        return -1;
+    }
+
+    cursor = skipSpaces(cursor);
+    if (parseHex(&cursor, &address) != 0) {
+        fprintf(stderr, "Trace Error: Line %lu of %s: Invalid or non hexadecimal address\n", lineNumber, path.c_str());
+        return -1;
+    }
+
+    switch (label) {
+        case '0': addPending(address, TRACE_FLAG_DATA); break;
+        case '1': addPending(address, TRACE_FLAG_DATA | TRACE_FLAG_STORE); break;
+        case '2': addPending(address, 0); break;
+        default: break;
+    }
+
+    return 1;
+}
+
+/**
+ * Reads a line of a lackey trace: "I  address,size" for instruction fetches, and " L", " S" or " M" for data loads,
+ * stores and modifications, which load and then store. The messages of valgrind, starting with ==, are ignored.
+ * @return int 1 if a record was read, 0 at the end of the file, -1 if the record has errors.
+ */
+int TraceImporter::readLackey() {
+    uint64_t address;
+
+    if (getline(&line, &lineLength, file) == -1) {
+        return 0;
+    }
+    lineNumber++;
+
+    if (line[0] == '=' && line[1] == '=') {
+        return 1;
+    }
+
+    char* cursor = skipSpaces(line);
+    if (*cursor == '\n' || *cursor == '\0') {
+        return 1;
+    }
+
+    char kind = *cursor++;
+    if (kind != 'I' && kind != 'L' && kind != 'S' && kind != 'M') {
+        fprintf(stderr, "Trace Error: Line %lu of %s: The access must be I, L, S or M\n", lineNumber, path.c_str());
+        return -1;
+    }
+
+    cursor = skipSpaces(cursor);
+    if (parseHex(&cursor, &address) != 0 || *cursor != ',') {
+        fprintf(stderr, "Trace Error: Line %lu of %s: Expected a hexadecimal address and a size\n", lineNumber, path.c_str());
+        return -1;
+    }
+
+    switch (kind) {
+        case 'I': addPending(address, 0); break;
+        case 'L': addPending(address, TRACE_FLAG_DATA); break;
+        case 'S': addPending(address, TRACE_FLAG_DATA | TRACE_FLAG_STORE); break;
+        case 'M':
+            addPending(address, TRACE_FLAG_DATA);
+            addPending(address, TRACE_FLAG_DATA | TRACE_FLAG_STORE);
+            break;
+    }
+
+    return 1;
+}
+
+/**
+ * Reads an instruction of a ChampSim trace: the fetch of the instruction, followed by its loads and its stores.
+ * @return int 1 if a record was read, 0 at the end of the file, -1 if the file ends in the middle of a record.
+ */
+int TraceImporter::readChampSim() {
+    ChampSimInstruction instruction;
+
+    size_t read = fread(&instruction, 1, sizeof(ChampSimInstruction), file);
+    if (read == 0) {
+        return 0;
+    }
+    lineNumber++;
+
+    if (read != sizeof(ChampSimInstruction)) {
+        fprintf(stderr, "Trace Error: %s ends in the middle of instruction %lu\n", path.c_str(), lineNumber);
+        return -1;
+    }
+
+    addPending(instruction.ip, 0);
+    for (int i = 0; i < 4; i++) {
+        if (instruction.sourceMemory[i] != 0) addPending(instruction.sourceMemory[i], TRACE_FLAG_DATA);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (instruction.destinationMemory[i] != 0) addPending(instruction.destinationMemory[i], TRACE_FLAG_DATA | TRACE_FLAG_STORE);
+    }
+
+    return 1;
+}
+
+/**
+ * Produces the next operation of the trace.
+ * @param op The operation to fill. Its data pointer must point to storage for at least one word.
+ * @return true If an operation was produced, false if the trace has ended.
+ */
+bool TraceImporter::next(MemoryOperation* op) {
+    while (nextPending >= numPending) {
+        if (readRecord() <= 0) {
+            return false;
+        }
+    }
+
+    TraceRecord* record = &pending[nextPending++];
+    op->address = record->address;
+    op->numWords = 1;
+    op->operation = (record->flags & TRACE_FLAG_STORE) ? STORE : LOAD;
+    op->isData = (record->flags & TRACE_FLAG_DATA) != 0;
+    op->hasBreakPoint = false;
+    if (op->operation == STORE) {
+        op->data[0] = record->data;
+    }
+
+    return true;
+}
+
+/**
+ * Restarts the trace from its first operation.
+ */
+void TraceImporter::rewind() {
+    if (file != NULL) {
+        fseeko(file, 0, SEEK_SET);
+    }
+
+    lineNumber = 0;
+    numPending = 0;
+    nextPending = 0;
+}
+
+/**
+ * Returns the number of operations of the trace.
+ * @return uint64_t The number of operations.
+ */
+uint64_t TraceImporter::getNumOps() {
+    return numOps;
+}
@@ -0,0 +1,221 @@
+#include "nucachis.h"
+#include "ParserConfig.h"
+#include "Simulator.h"
+
+static_assert(sizeof(nc_access) == 24, "The layout of nc_access is part of the C interface");
+static_assert(sizeof(nc_result) == 24, "The layout of nc_result is part of the C interface");
+
+struct nc_sim {
+    SimulatorConfig config;
+    Simulator* simulator;
+    uint64_t cycle;         // The globals of the simulator while this simulation is not running
+    uint64_t randState;
+};
+
+/**
+ * Puts the cycle and random state of a simulation into the globals the simulator runs on, so that several simulations
+ * can be used in turn.
+ * @param sim The simulation.
+ * @param saved Returns the globals it replaced, for leaveSim.
+ */
+static void enterSim(nc_sim* sim, uint64_t saved[2]) {
+    saved[0] = cycle;
+    saved[1] = randState;
+    cycle = sim->cycle;
+    randState = sim->randState;
+}
+
+/**
+ * Stores the globals back into a simulation and restores the ones enterSim replaced.
+ * @param sim The simulation.
+ * @param saved The globals returned by enterSim.
+ */
+static void leaveSim(nc_sim* sim, const uint64_t saved[2]) {
+    sim->cycle = cycle;
+    sim->randState = randState;
+    cycle = saved[0];
+    randState = saved[1];
+}
+
+/**
+ * Creates a simulation of the hierarchy of a configuration file, with empty caches and no trace. Each simulation keeps
+ * its own cycle and random state, so several can be used in turn, but not from several threads at once.
+ * @param config_path Path to the configuration file.
+ * @return nc_sim* The simulation, NULL if the configuration has errors.
+ */
+nc_sim* nc_sim_create(const char* config_path) {
+    nc_sim* sim = new nc_sim();
+
+    if (parseConfiguration((char*) config_path, &sim->config) == -2) {
+        delete sim;
+        return NULL;
+    }
+
+    // The accesses are pushed one by one instead of coming from a trace
+    sim->config.miscNumOperations = 0;
+
+    // The constructor resets the cycle and seeds the random state, which must not reach the other simulations
+    uint64_t saved[2];
+    enterSim(sim, saved);
+    sim->simulator = new Simulator(&sim->config, (MemoryOperation**) nullptr);
+    sim->simulator->setQuiet(true);
+    leaveSim(sim, saved);
+
+    return sim;
+}
+
+/**
+ * Frees a simulation.
+ * @param sim The simulation. NULL is ignored.
+ */
+void nc_sim_destroy(nc_sim* sim) {
+    if (sim == NULL) {
+        return;
+    }
+
+    delete sim->simulator;
+    delete sim;
+}
+
+/**
+ * Empties the hierarchy and clears the stats, as if the simulation had just been created.
+ * @param sim The simulation.
+ */
+void nc_sim_reset(nc_sim* sim) {
+    uint64_t saved[2];
+    enterSim(sim, saved);
+    sim->simulator->reset();
+    leaveSim(sim, saved);
+}
+
+/**
+ * Returns the number of cores of the hierarchy, that is, how many cores can make accesses.
+ * @param sim The simulation.
+ * @return uint32_t The number of cores.
+ */
+uint32_t nc_sim_num_cores(nc_sim* sim) {
+    return sim->simulator->getNumCores();
+}
+
+/**
+ * Runs a batch of accesses in order, one cycle each. Batching saves a call per access to the embedders that cross an
+ * FFI boundary, and lets the first level serve its hits in a single pass.
+ * @param sim The simulation.
+ * @param accesses The accesses to run.
+ * @param count The number of accesses.
+ * @param results Returns the outcome of each access, count of them. NULL if only the stats are wanted.
+ * @return uint64_t The number of accesses that were run. Less than count if an access is invalid, which stops the batch.
+ */
+uint64_t nc_sim_access_batch(nc_sim* sim, const nc_access* accesses, uint64_t count, nc_result* results) {
+    uint64_t baseAddress = sim->simulator->getMemory()->getPageBaseAddress();
+    uint64_t words[SIMULATOR_BATCH_SIZE];
+    MemoryOperation ops[SIMULATOR_BATCH_SIZE];
+    MemoryOperation* batch[SIMULATOR_BATCH_SIZE];
+    MemoryReply reps[SIMULATOR_BATCH_SIZE];
+
+    for (uint32_t i = 0; i < SIMULATOR_BATCH_SIZE; i++) {
+        ops[i].numWords = 1;
+        ops[i].hasBreakPoint = false;
+        ops[i].data = &words[i];
+        reps[i].data = &words[i];
+        batch[i] = &ops[i];
+    }
+
+    // Hand the accesses to the simulator in chunks, up to the first invalid one
+    // Each chunk belongs to a single core, so it ends early where the core changes
+    uint64_t saved[2];
+    enterSim(sim, saved);
+    uint64_t done = 0;
+    uint32_t numCores = sim->simulator->getNumCores();
+    while (done < count) {
+        uint32_t numOps = 0;
+        uint8_t core = accesses[done].core;
+        bool invalid = false;
+
+        while (numOps < SIMULATOR_BATCH_SIZE && done + numOps < count) {
+            const nc_access* access = &accesses[done + numOps];
+
+            if (access->type > NC_IFETCH || access->address < baseAddress || access->core >= numCores) {
+                fprintf(stderr, "API Error: Access %lu has an invalid type or core, or is below the simulated memory\n",
+                        done + numOps);
+                invalid = true;
+                break;
+            }
+            if (access->core != core) {
+                break;
+            }
+
+            ops[numOps].address = access->address;
+            ops[numOps].operation = (access->type == NC_STORE) ? STORE : LOAD;
+            ops[numOps].isData = access->type != NC_IFETCH;
+            words[numOps] = access->data;
+            numOps++;
+        }
+
+        sim->simulator->accessBatch(batch, reps, numOps, core);
+
+        for (uint32_t i = 0; results != NULL && i < numOps; i++) {
+            nc_result* result = &results[done + i];
+            result->latency = reps[i].totalTime;
+            result->data = (ops[i].operation == STORE) ? 0 : words[i];
+            result->hit_level = reps[i].hitLevel;
+            memset(result->reserved, 0, sizeof(result->reserved));
+        }
+
+        done += numOps;
+        if (invalid) {
+            break;
+        }
+    }
+
+    leaveSim(sim, saved);
+    return done;
+}
+
+/**
+ * Reads a statistic by its name, as listed by nc_stats_name (E.g. l1.d.hits or cpu.total_access_time).
+ * @param sim The simulation.
+ * @param name The name of the statistic.
+ * @param value Returns the value of the statistic.
+ * @return int 0 if Ok, -1 if there is no statistic with that name.
+ */
+int nc_stats_get(nc_sim* sim, const char* name, double* value) {
+    StatsRegistry* stats = sim->simulator->getStats();
+    int32_t index = stats->find(name);
+
+    if (index < 0) {
+        return -1;
+    }
+
+    // cpu.cycle reads the global cycle
+    uint64_t saved[2];
+    enterSim(sim, saved);
+    *value = stats->getValue(index);
+    leaveSim(sim, saved);
+    return 0;
+}
+
+/**
+ * Returns the number of statistics of the simulation.
+ * @param sim The simulation.
+ * @return uint32_t The number of statistics.
+ */
+uint32_t nc_stats_count(nc_sim* sim) {
+    return sim->simulator->getStats()->getNumStats();
+}
+
+/**
+ * Returns the name of a statistic.
+ * @param sim The simulation.
+ * @param index The index of the statistic, below nc_stats_count.
+ * @return const char* The name, owned by the simulation. NULL if the index is out of range.
+ */
+const char* nc_stats_name(nc_sim* sim, uint32_t index) {
+    StatsRegistry* stats = sim->simulator->getStats();
+
+    if (index >= stats->getNumStats()) {
+        return NULL;
+    }
+
+    return stats->getName(index);
+}
@@ -0,0 +1,135 @@
+/*
+ * Checks that serving the hits of the first level in batches leaves the simulation exactly as running the operations
+ * one at a time, both for traces and for operations submitted by the caller. Takes the configuration files to simulate.
+ */
+
+#include <vector>
+
+#include "TestCommon.h"
+
+#define TEST_OPERATIONS 30000
+#define TEST_CHUNK 100                  // Operations submitted at once by the caller, not a multiple of the batch size
+#define TEST_SNAPSHOT "batch_test.snap"
+
+/**
+ * Runs a trace with stepAll, which goes in batches, and then with stepSome, which goes one operation at a time.
+ * @param sc The simulator configs.
+ * @param gen The trace.
+ * @return int 0 if Ok, -1 if the simulations end differently.
+ */
+static int compareTrace(SimulatorConfig* sc, TraceGenerator* gen) {
+    std::string batched, single;
+
+    // The simulator runs on a global cycle, so the two simulations go one after the other
+    Simulator* sim = new Simulator(sc, gen);
+    sim->setQuiet(true);
+    sim->stepAll(false);
+    batched = snapshot(sim, TEST_SNAPSHOT);
+    delete sim;
+
+    sim = new Simulator(sc, gen);
+    sim->setQuiet(true);
+    sim->stepSome(TEST_OPERATIONS, false);
+    single = snapshot(sim, TEST_SNAPSHOT);
+    delete sim;
+
+    if (batched.empty() || batched != single) {
+        fprintf(stderr, "Test Error: The trace ends differently in batches\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Submits the operations of a trace with accessBatch, and then one at a time with access.
+ * @param sc The simulator configs, without trace.
+ * @param gen The trace.
+ * @return int 0 if Ok, -1 if a reply or the end of the simulations differ.
+ */
+static int compareSubmitted(SimulatorConfig* sc, TraceGenerator* gen) {
+    std::vector<MemoryOperation> ops(TEST_OPERATIONS);
+    std::vector<uint64_t> words(2 * TEST_OPERATIONS);
+    std::vector<MemoryReply> batchedReps(TEST_OPERATIONS), singleReps(TEST_OPERATIONS);
+    std::string batched, single;
+
+    gen->rewind();
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i++) {
+        ops[i].data = &words[i];
+        gen->next(&ops[i]);
+        batchedReps[i].data = &words[TEST_OPERATIONS + i];
+        singleReps[i].data = &words[TEST_OPERATIONS + i];
+    }
+
+    Simulator* sim = new Simulator(sc, (MemoryOperation**) nullptr);
+    sim->setQuiet(true);
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i += TEST_CHUNK) {
+        std::vector<MemoryOperation*> chunk;
+        for (uint32_t j = i; j < i + TEST_CHUNK; j++) {
+            chunk.push_back(&ops[j]);
+        }
+        sim->accessBatch(chunk.data(), &batchedReps[i], TEST_CHUNK);
+    }
+    batched = snapshot(sim, TEST_SNAPSHOT);
+    delete sim;
+
+    sim = new Simulator(sc, (MemoryOperation**) nullptr);
+    sim->setQuiet(true);
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i++) {
+        sim->access(&ops[i], &singleReps[i]);
+    }
+    single = snapshot(sim, TEST_SNAPSHOT);
+    delete sim;
+
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i++) {
+        if (batchedReps[i].totalTime != singleReps[i].totalTime || batchedReps[i].hitLevel != singleReps[i].hitLevel) {
+            fprintf(stderr, "Test Error: The reply to operation %u differs in batches\n", i);
+            return -1;
+        }
+    }
+    if (batched.empty() || batched != single) {
+        fprintf(stderr, "Test Error: The submitted operations end differently in batches\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    GeneratorPattern patterns[] = {GEN_SEQUENTIAL, GEN_ZIPF, GEN_MATMUL};
+    int failed = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <config.ini>...\n", argv[0]);
+        return 1;
+    }
+
+    for (int c = 1; c < argc; c++) {
+        SimulatorConfig sc;
+
+        if (parseConfiguration(argv[c], &sc) == -2) {
+            return 1;
+        }
+
+        for (GeneratorPattern pattern : patterns) {
+            TraceGenerator gen;
+
+            if (initTestTrace(&gen, &sc, pattern, TEST_OPERATIONS, 9) != 0) {
+                return 1;
+            }
+
+            if (compareTrace(&sc, &gen) != 0 || compareSubmitted(&sc, &gen) != 0) {
+                fprintf(stderr, "Test Error: %s with the %s pattern\n", argv[c], generatorPatternStr(pattern));
+                failed = 1;
+            }
+        }
+    }
+
+    remove(TEST_SNAPSHOT);
+    if (failed) {
+        return 1;
+    }
+
+    printf("Batched and single operations leave the same simulations\n");
+    return 0;
+}
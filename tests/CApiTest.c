@@ -0,0 +1,157 @@
+/*
+ * Drives several simulations of the C API in turn and checks that each one gives the same results as if it had run
+ * alone. Takes the configuration file to simulate, which should use random replacement to also cover the random state.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nucachis.h"
+
+#define TEST_ACCESSES 4096
+#define TEST_CHUNK 100
+#define TEST_BASE_ADDRESS 0x8000000
+#define TEST_SPAN 2048
+
+/**
+ * Fills a sequence of accesses from a seed, with loads, stores and instruction fetches over a span larger than the caches.
+ * @param accesses Returns the accesses, TEST_ACCESSES of them.
+ * @param seed The seed of the sequence.
+ */
+static void makeAccesses(nc_access* accesses, uint32_t seed) {
+    uint64_t state = seed;
+
+    memset(accesses, 0, TEST_ACCESSES * sizeof(nc_access));
+    for (uint32_t i = 0; i < TEST_ACCESSES; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        accesses[i].address = TEST_BASE_ADDRESS + ((state >> 33) % TEST_SPAN) * 4;
+        accesses[i].data = state >> 16;
+        accesses[i].type = (uint8_t) ((state >> 60) % 3);
+    }
+}
+
+/**
+ * Runs the next chunk of accesses of a simulation.
+ * @param sim The simulation.
+ * @param accesses All the accesses of the simulation.
+ * @param results All the results of the simulation.
+ * @param done The number of accesses already run, advanced by the chunk.
+ * @return int 0 if Ok, -1 if the simulation stopped early.
+ */
+static int runChunk(nc_sim* sim, const nc_access* accesses, nc_result* results, uint32_t* done) {
+    uint32_t count = TEST_ACCESSES - *done < TEST_CHUNK ? TEST_ACCESSES - *done : TEST_CHUNK;
+
+    if (nc_sim_access_batch(sim, &accesses[*done], count, &results[*done]) != count) {
+        fprintf(stderr, "Test Error: The batch at access %u stopped early\n", *done);
+        return -1;
+    }
+
+    *done += count;
+    return 0;
+}
+
+/**
+ * Compares the results and the stats of two runs of the same accesses.
+ * @param name The name of the simulation, for the messages.
+ * @param sim The simulation that ran along others.
+ * @param ref The simulation that ran alone.
+ * @param results The results of sim.
+ * @param refResults The results of ref.
+ * @return int 0 if they match, -1 if not.
+ */
+static int compareRuns(const char* name, nc_sim* sim, nc_sim* ref, const nc_result* results, const nc_result* refResults) {
+    for (uint32_t i = 0; i < TEST_ACCESSES; i++) {
+        if (memcmp(&results[i], &refResults[i], sizeof(nc_result)) != 0) {
+            fprintf(stderr, "Test Error: Access %u of %s differs from the run alone (latency %f vs %f, level %u vs %u)\n",
+                    i, name, results[i].latency, refResults[i].latency, results[i].hit_level, refResults[i].hit_level);
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < nc_stats_count(ref); i++) {
+        const char* stat = nc_stats_name(ref, i);
+        double value, refValue;
+
+        if (nc_stats_get(sim, stat, &value) != 0 || nc_stats_get(ref, stat, &refValue) != 0 || value != refValue) {
+            fprintf(stderr, "Test Error: The stat %s of %s differs from the run alone\n", stat, name);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <config.ini>\n", argv[0]);
+        return 1;
+    }
+
+    nc_access* accesses[2];
+    nc_result* results[2];
+    nc_result* refResults[2];
+    nc_sim* refs[2];
+    for (uint32_t s = 0; s < 2; s++) {
+        accesses[s] = (nc_access*) malloc(TEST_ACCESSES * sizeof(nc_access));
+        results[s] = (nc_result*) calloc(TEST_ACCESSES, sizeof(nc_result));
+        refResults[s] = (nc_result*) calloc(TEST_ACCESSES, sizeof(nc_result));
+        makeAccesses(accesses[s], s + 1);
+    }
+
+    // Run each sequence alone, one simulation after the other
+    int failed = 0;
+    for (uint32_t s = 0; s < 2 && !failed; s++) {
+        uint32_t done = 0;
+
+        refs[s] = nc_sim_create(argv[1]);
+        if (refs[s] == NULL) {
+            fprintf(stderr, "Test Error: Could not create a simulation of %s\n", argv[1]);
+            return 1;
+        }
+        while (done < TEST_ACCESSES && !failed) {
+            failed = runChunk(refs[s], accesses[s], refResults[s], &done) != 0;
+        }
+    }
+
+    // Run both again in turn, the second one created while the first is half way
+    nc_sim* sims[2] = {nc_sim_create(argv[1]), NULL};
+    uint32_t done[2] = {0, 0};
+    int reset = 0;
+    while (!failed && (done[0] < TEST_ACCESSES || done[1] < TEST_ACCESSES)) {
+        if (done[0] >= TEST_ACCESSES / 2 && sims[1] == NULL) {
+            sims[1] = nc_sim_create(argv[1]);
+        }
+
+        for (uint32_t s = 0; s < 2 && !failed; s++) {
+            if (sims[s] != NULL && done[s] < TEST_ACCESSES) {
+                failed = runChunk(sims[s], accesses[s], results[s], &done[s]) != 0;
+            }
+        }
+
+        // Resetting one simulation must not disturb the other
+        if (done[1] >= TEST_ACCESSES / 4 && !reset) {
+            nc_sim_reset(sims[1]);
+            done[1] = 0;
+            reset = 1;
+        }
+    }
+
+    failed = failed || compareRuns("the first simulation", sims[0], refs[0], results[0], refResults[0]) != 0;
+    failed = failed || compareRuns("the second simulation", sims[1], refs[1], results[1], refResults[1]) != 0;
+
+    for (uint32_t s = 0; s < 2; s++) {
+        nc_sim_destroy(sims[s]);
+        nc_sim_destroy(refs[s]);
+        free(accesses[s]);
+        free(results[s]);
+        free(refResults[s]);
+    }
+
+    if (failed) {
+        return 1;
+    }
+
+    printf("Two simulations in turn match their runs alone\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * Saves checkpoints at several points of a simulation and restores each one in a new simulation, which must get the
+ * same state and end the same as the original one. Damaged checkpoints must be rejected without bringing the process
+ * down. Takes the configuration files to simulate.
+ */
+
+#include <string.h>
+
+#include "TestCommon.h"
+
+#define TEST_OPERATIONS 20000
+#define TEST_CHECKPOINT "checkpoint_test.ckpt"   // The checkpoint that gets restored
+#define TEST_SNAPSHOT "checkpoint_test.snap"     // The states that are compared with it
+
+/**
+ * Runs a trace up to an operation, saves a checkpoint there, restores it in a new simulation and runs both to the end.
+ * @param sc The simulator configs.
+ * @param pattern The access pattern of the trace.
+ * @param saveAt The operation after which the checkpoint is saved.
+ * @return int 0 if Ok, -1 if the restored simulation differs.
+ */
+static int roundTrip(SimulatorConfig* sc, GeneratorPattern pattern, uint64_t saveAt) {
+    TraceGenerator gen;
+    std::string saved, restored, end, restoredEnd;
+
+    if (initTestTrace(&gen, sc, pattern, TEST_OPERATIONS, 3) != 0) {
+        return -1;
+    }
+
+    // The simulator runs on a global cycle, so the two simulations go one after the other
+    Simulator* sim = new Simulator(sc, &gen);
+    sim->setQuiet(true);
+    sim->stepSome(saveAt, false);
+    saved = snapshot(sim, TEST_CHECKPOINT);
+    sim->stepAll(false);
+    end = snapshot(sim, TEST_SNAPSHOT);
+    delete sim;
+
+    sim = new Simulator(sc, &gen);
+    sim->setQuiet(true);
+    if (saved.empty() || sim->loadCheckpoint(TEST_CHECKPOINT) != 0) {
+        fprintf(stderr, "Test Error: Could not save or restore the checkpoint at operation %lu\n", saveAt);
+        delete sim;
+        return -1;
+    }
+    restored = snapshot(sim, TEST_SNAPSHOT);
+    sim->stepAll(false);
+    restoredEnd = snapshot(sim, TEST_SNAPSHOT);
+    delete sim;
+
+    if (restored != saved) {
+        fprintf(stderr, "Test Error: The checkpoint at operation %lu is not restored as it was saved\n", saveAt);
+        return -1;
+    }
+    if (restoredEnd != end) {
+        fprintf(stderr, "Test Error: The simulation restored at operation %lu ends differently\n", saveAt);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes a damaged copy of a checkpoint.
+ * @param checkpoint The checkpoint.
+ * @param size The number of Bytes to keep.
+ * @param word The index of the 8 Byte word to overwrite with a huge count, -1 for none.
+ */
+static void writeDamaged(const std::string& checkpoint, size_t size, int64_t word) {
+    std::string damaged = checkpoint.substr(0, size);
+    uint64_t huge = 1ULL << 60;
+
+    if (word >= 0) {
+        memcpy(&damaged[word * sizeof(uint64_t)], &huge, sizeof(uint64_t));
+    }
+
+    FILE* file = fopen(TEST_CHECKPOINT, "wb");
+    fwrite(damaged.data(), 1, damaged.size(), file);
+    fclose(file);
+}
+
+/**
+ * Restores truncated checkpoints, which must be rejected, and checkpoints with a huge count in place of each of their
+ * words, which must be rejected or restored but never bring the process down.
+ * @param sc The simulator configs.
+ * @return int 0 if Ok, -1 if a truncated checkpoint is accepted.
+ */
+static int rejectDamaged(SimulatorConfig* sc) {
+    TraceGenerator gen;
+
+    if (initTestTrace(&gen, sc, GEN_ZIPF, TEST_OPERATIONS, 3) != 0) {
+        return -1;
+    }
+
+    Simulator* sim = new Simulator(sc, &gen);
+    sim->setQuiet(true);
+    sim->stepSome(TEST_OPERATIONS / 2, false);
+    std::string checkpoint = snapshot(sim, TEST_SNAPSHOT);
+    size_t step = checkpoint.size() / 64 + 1;
+
+    int result = 0;
+    for (size_t size = 0; size < checkpoint.size(); size += step) {
+        writeDamaged(checkpoint, size, -1);
+        if (sim->loadCheckpoint(TEST_CHECKPOINT) == 0) {
+            fprintf(stderr, "Test Error: A checkpoint truncated to %zu Bytes was restored\n", size);
+            result = -1;
+        }
+    }
+
+    for (size_t word = 0; word < checkpoint.size() / sizeof(uint64_t); word++) {
+        writeDamaged(checkpoint, checkpoint.size(), word);
+        sim->loadCheckpoint(TEST_CHECKPOINT);
+    }
+
+    delete sim;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    GeneratorPattern patterns[] = {GEN_ZIPF, GEN_CHASE};
+    uint64_t points[] = {0, 1, TEST_OPERATIONS / 3, TEST_OPERATIONS};
+    int failed = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <config.ini>...\n", argv[0]);
+        return 1;
+    }
+
+    for (int c = 1; c < argc; c++) {
+        SimulatorConfig sc;
+
+        if (parseConfiguration(argv[c], &sc) == -2) {
+            return 1;
+        }
+
+        for (GeneratorPattern pattern : patterns) {
+            for (uint64_t point : points) {
+                if (roundTrip(&sc, pattern, point) != 0) {
+                    fprintf(stderr, "Test Error: %s with the %s pattern\n", argv[c], generatorPatternStr(pattern));
+                    failed = 1;
+                }
+            }
+        }
+
+        if (rejectDamaged(&sc) != 0) {
+            fprintf(stderr, "Test Error: %s with damaged checkpoints\n", argv[c]);
+            failed = 1;
+        }
+    }
+
+    remove(TEST_CHECKPOINT);
+    remove(TEST_SNAPSHOT);
+    if (failed) {
+        return 1;
+    }
+
+    printf("Every checkpoint is restored as it was saved\n");
+    return 0;
+}
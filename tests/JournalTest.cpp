@@ -0,0 +1,112 @@
+/*
+ * Steps back and seeks through a simulation with the undo journal, and checks that every state it reaches is the same
+ * as the one a plain simulation had at that cycle. Takes the configuration files to simulate.
+ */
+
+#include <vector>
+
+#include "TestCommon.h"
+
+#define TEST_OPERATIONS 1500
+#define TEST_SNAPSHOT "journal_test.snap"
+
+/**
+ * Compares the state of a journaled simulation with the one of the plain simulation at the same cycle.
+ * @param sim The journaled simulation.
+ * @param states The state of the plain simulation at every cycle.
+ * @param action What brought the simulation there, for the message.
+ * @return int 0 if Ok, -1 if they differ.
+ */
+static int checkState(Simulator* sim, const std::vector<std::string>& states, const char* action) {
+    if (snapshot(sim, TEST_SNAPSHOT) != states[cycle]) {
+        fprintf(stderr, "Test Error: The state after %s to cycle %lu differs from the plain simulation\n", action, cycle);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Runs a trace plainly and then with the journal, seeking to several cycles and stepping back to the start.
+ * @param sc The simulator configs.
+ * @param pattern The access pattern of the trace.
+ * @return int 0 if Ok, -1 if a state differs.
+ */
+static int replay(SimulatorConfig* sc, GeneratorPattern pattern) {
+    TraceGenerator gen;
+    std::vector<std::string> states;
+
+    if (initTestTrace(&gen, sc, pattern, TEST_OPERATIONS, 5) != 0) {
+        return -1;
+    }
+
+    // The simulator runs on a global cycle, so the two simulations go one after the other
+    Simulator* sim = new Simulator(sc, &gen);
+    sim->setQuiet(true);
+    states.push_back(snapshot(sim, TEST_SNAPSHOT));
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i++) {
+        sim->singleStep();
+        states.push_back(snapshot(sim, TEST_SNAPSHOT));
+    }
+    delete sim;
+
+    // Seek back and forth, across snapshots of the journal, and then step back one cycle at a time
+    uint64_t targets[] = {TEST_OPERATIONS / 2, 3, TEST_OPERATIONS - 1, 0, 777, 1, TEST_OPERATIONS, 2};
+    int result = 0;
+
+    sim = new Simulator(sc, &gen);
+    sim->setQuiet(true);
+    sim->enableJournal();
+    sim->stepAll(false);
+    for (uint64_t target : targets) {
+        sim->seek(target);
+        if (checkState(sim, states, "seeking") != 0) {
+            result = -1;
+        }
+    }
+
+    sim->seek(TEST_OPERATIONS);
+    while (result == 0 && sim->stepBack()) {
+        result = checkState(sim, states, "stepping back");
+    }
+    if (result == 0 && cycle != 0) {
+        fprintf(stderr, "Test Error: Stepping back stopped at cycle %lu\n", cycle);
+        result = -1;
+    }
+
+    delete sim;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    GeneratorPattern patterns[] = {GEN_UNIFORM, GEN_MATMUL};
+    int failed = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <config.ini>...\n", argv[0]);
+        return 1;
+    }
+
+    for (int c = 1; c < argc; c++) {
+        SimulatorConfig sc;
+
+        if (parseConfiguration(argv[c], &sc) == -2) {
+            return 1;
+        }
+
+        for (GeneratorPattern pattern : patterns) {
+            if (replay(&sc, pattern) != 0) {
+                fprintf(stderr, "Test Error: %s with the %s pattern\n", argv[c], generatorPatternStr(pattern));
+                failed = 1;
+            }
+        }
+    }
+
+    remove(TEST_SNAPSHOT);
+    if (failed) {
+        return 1;
+    }
+
+    printf("Every state reached through the journal matches the plain simulation\n");
+    return 0;
+}
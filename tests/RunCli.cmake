@@ -0,0 +1,24 @@
+# Runs the command line executable and compares a file it writes with the expected one. Called by ctest with:
+#   CLI       Path to nucachis_cli
+#   ARGS      Arguments of the run, separated by |
+#   OUTPUT    File written by the run
+#   EXPECTED  Expected content of OUTPUT
+
+string(REPLACE "|" ";" args "${ARGS}")
+file(REMOVE "${OUTPUT}")
+
+execute_process(COMMAND "${CLI}" ${args}
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+    ERROR_VARIABLE errors
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "nucachis_cli failed (${result}):\n${errors}")
+endif()
+
+execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${OUTPUT}" "${EXPECTED}" RESULT_VARIABLE different)
+if(different)
+    file(READ "${OUTPUT}" actual)
+    file(READ "${EXPECTED}" expected)
+    message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}\nGot:\n${actual}\nExpected:\n${expected}")
+endif()
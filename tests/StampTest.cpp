@@ -0,0 +1,134 @@
+/*
+ * Runs the same requests through two copies of the first cache of a configuration, one a cycle apart and the other
+ * with gaps of billions of cycles, which makes its sets rebase their timestamps all the time. Rebasing must never
+ * change a replacement decision, so both copies must keep the same lines. Takes the configuration files to simulate.
+ */
+
+#include <vector>
+
+#include "TestCommon.h"
+#include "MainMemory.h"
+
+#define TEST_REQUESTS 30000
+#define TEST_MAX_GAP 3000000000ULL      // Largest gap between two requests of the rebased copy, beyond CACHE_MAX_STAMP
+
+/**
+ * Runs a request in a cache at a cycle. Every other request goes through the batched path, which serves the hits.
+ * @param cache The cache.
+ * @param op The request.
+ * @param now The cycle.
+ * @param batched Whether to try the batched path first.
+ */
+static void runAt(Cache* cache, MemoryOperation* op, uint64_t now, bool batched) {
+    MemoryReply rep;
+    std::vector<uint64_t> words(cache->getLineSizeWords());
+
+    rep.data = words.data();
+    rep.totalTime = 0.0;
+    rep.hitLevel = 0;
+    cycle = now;
+    if (!batched || cache->processBatch(&op, &rep, 1) == 0) {
+        cache->processRequest(op, &rep);
+    }
+}
+
+/**
+ * Compares the lines of two caches.
+ * @param a The first cache.
+ * @param b The second cache.
+ * @return bool True if both have the same lines in the same places.
+ */
+static bool sameLines(Cache* a, Cache* b) {
+    for (int side = 0; side < 2; side++) {
+        CacheLine* linesA = a->getCache(side);
+        CacheLine* linesB = b->getCache(side);
+
+        for (uint32_t i = 0; linesA != nullptr && i < a->getLines(); i++) {
+            if (linesA[i].valid != linesB[i].valid || linesA[i].tag != linesB[i].tag || linesA[i].dirty != linesB[i].dirty) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Runs the requests in both copies of a cache with a replacement policy.
+ * @param sc The simulator configs.
+ * @param policy The replacement policy of the cache.
+ * @return int 0 if Ok, -1 if the copies diverge.
+ */
+static int compareCopies(SimulatorConfig* sc, PolicyReplacement policy) {
+    sc->cachePolicyReplacement[0] = policy;
+
+    MainMemory memory(sc), rebasedMemory(sc);
+    Cache cache(sc, 0), rebased(sc, 0);
+    cache.setNext(&memory);
+    rebased.setNext(&rebasedMemory);
+    cache.setQuiet(true);
+    rebased.setQuiet(true);
+
+    uint64_t state = 42, data = 7, now = 0;
+    for (uint32_t i = 0; i < TEST_REQUESTS; i++) {
+        MemoryOperation op;
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        op.address = sc->memPageBaseAddress + ((state >> 8) % (sc->memPageSize / 4)) * 4;
+        op.numWords = 1;
+        op.operation = (state & 3) == 0 ? STORE : LOAD;
+        op.isData = (state >> 4) & 1;
+        op.data = &data;
+        op.hasBreakPoint = false;
+
+        // Random replacement has to draw the same numbers in both copies
+        uint64_t seed = randState;
+        runAt(&cache, &op, i, (i & 1) != 0);
+        uint64_t next = randState;
+
+        randState = seed;
+        now += 1 + (state >> 20) % TEST_MAX_GAP;
+        runAt(&rebased, &op, now, (i & 1) != 0);
+
+        if (randState != next || !sameLines(&cache, &rebased)) {
+            fprintf(stderr, "Test Error: The rebased cache diverges at request %u with the %s policy\n", i,
+                    replacementPolicyStr(policy));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int failed = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <config.ini>...\n", argv[0]);
+        return 1;
+    }
+
+    for (int c = 1; c < argc; c++) {
+        SimulatorConfig sc;
+
+        if (parseConfiguration(argv[c], &sc) == -2) {
+            return 1;
+        }
+
+        for (int policy = 0; policy < NUM_POLICY_REPLACEMENT; policy++) {
+            if (compareCopies(&sc, (PolicyReplacement) policy) != 0) {
+                fprintf(stderr, "Test Error: %s\n", argv[c]);
+                failed = 1;
+            }
+        }
+    }
+
+    if (failed) {
+        return 1;
+    }
+
+    printf("Rebasing the timestamps never changes the lines of a cache\n");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+
+#include "ParserConfig.h"
+#include "Simulator.h"
+#include "TraceGenerator.h"
+
+// Generated traces of the tests
+#define TEST_FOOTPRINT 4096             // In Bytes, a few times the size of the caches of the shipped configurations
+#define TEST_INST_RATIO 0.2             // So that split caches get instruction fetches
+
+/**
+ * Reads a whole file.
+ * @param path Path to the file.
+ * @return std::string The content, empty if the file cannot be read.
+ */
+inline std::string readFile(const char* path) {
+    std::string content;
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return content;
+    }
+
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, read);
+    }
+
+    fclose(file);
+    return content;
+}
+
+/**
+ * Captures the complete state of a simulation, as its checkpoint.
+ * @param sim The simulation.
+ * @param path Path of the file the checkpoint goes through.
+ * @return std::string The checkpoint, empty if it could not be saved.
+ */
+inline std::string snapshot(Simulator* sim, const char* path) {
+    if (sim->saveCheckpoint(path) != 0) {
+        return std::string();
+    }
+
+    return readFile(path);
+}
+
+/**
+ * Sets up a generated trace that fits the memory page of a configuration.
+ * @param gen The generator.
+ * @param sc The simulator configs.
+ * @param pattern The access pattern.
+ * @param numOps The number of operations.
+ * @param seed The seed of the generator.
+ * @return int 0 if Ok, -1 if the generator rejects the parameters.
+ */
+inline int initTestTrace(TraceGenerator* gen, SimulatorConfig* sc, GeneratorPattern pattern, uint64_t numOps, uint32_t seed) {
+    GeneratorConfig gc;
+
+    gc.pattern = pattern;
+    gc.numOps = numOps;
+    gc.baseAddress = sc->memPageBaseAddress;
+    gc.footprint = TEST_FOOTPRINT;
+    gc.wordWidth = sc->cpuWordWidth / 8;
+    gc.stride = GENERATOR_DEFAULT_STRIDE;
+    gc.writeRatio = GENERATOR_DEFAULT_WRITES;
+    gc.instRatio = TEST_INST_RATIO;
+    gc.zipfSkew = GENERATOR_DEFAULT_ZIPF;
+    gc.block = 8;
+    gc.seed = seed;
+
+    return gen->init(&gc);
+}